@@ -0,0 +1,353 @@
+// Hot-path benchmarks for HashFusion and MerkleTrie.
+//
+//   cmake -S . -B build && cmake --build build -j
+//   ./build/trie_benchmarks --benchmark_filter=Trie
+//
+// Trie benchmarks run at 1K..10M voters; each reports p50/p99/p999
+// latency of the single operation and the process peak RSS alongside
+// Google Benchmark's mean time and throughput.
+#include <benchmark/benchmark.h>
+#include "hash_fusion.h"
+#include "merkle_trie.h"
+#include "sparse_merkle_tree.h"
+#include "vote_tally.h"
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <vector>
+#include <sys/resource.h>
+
+static const char* SALT = "benchmark-salt";
+static const uint64_t TIMESTAMP = 1700000000000ULL;
+
+static double peakRssMegabytes() {
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    return usage.ru_maxrss / 1024.0;   // ru_maxrss is in KiB on Linux
+}
+
+// Times each operation individually for the percentile counters
+class LatencyRecorder {
+public:
+    template <typename Fn>
+    void measure(Fn fn) {
+        auto start = std::chrono::steady_clock::now();
+        fn();
+        auto elapsed = std::chrono::steady_clock::now() - start;
+        samples.push_back(std::chrono::duration<double, std::nano>(elapsed).count());
+    }
+    
+    void report(benchmark::State& state) {
+        if (!samples.empty()) {
+            std::sort(samples.begin(), samples.end());
+            state.counters["p50_ns"] = percentile(0.50);
+            state.counters["p99_ns"] = percentile(0.99);
+            state.counters["p999_ns"] = percentile(0.999);
+        }
+        state.counters["peak_rss_mb"] = peakRssMegabytes();
+    }
+
+private:
+    std::vector<double> samples;
+    
+    double percentile(double q) const {
+        return samples[std::min(samples.size() - 1, static_cast<size_t>(q * samples.size()))];
+    }
+};
+
+static std::string voterInput(size_t i) {
+    return "VOTER-" + std::to_string(i);
+}
+
+// Registry of n voters keyed by their fused hashes. Only the latest size
+// is kept, so the 10M run does not also hold every smaller trie.
+struct Registry {
+    size_t size;
+    std::vector<std::string> keys;
+    std::unique_ptr<MerkleTrie> trie;
+};
+
+static Registry& registryOfSize(size_t n) {
+    static Registry registry{0, {}, nullptr};
+    if (registry.trie && registry.size == n) {
+        return registry;
+    }
+    
+    registry.trie.reset();
+    registry.keys.clear();
+    registry.keys.shrink_to_fit();
+    
+    std::vector<std::pair<std::string, std::string>> entries(n);
+    for (size_t i = 0; i < n; i++) {
+        entries[i].second = voterInput(i);
+        entries[i].first = HashFusion::sha256(entries[i].second);
+    }
+    registry.trie = std::make_unique<MerkleTrie>(entries);
+    registry.keys.reserve(n);
+    for (auto& entry : entries) {
+        registry.keys.push_back(std::move(entry.first));
+    }
+    registry.size = n;
+    return registry;
+}
+
+static void VoterCounts(benchmark::internal::Benchmark* b) {
+    b->RangeMultiplier(10)->Range(1000, 10000000)->Unit(benchmark::kMicrosecond);
+}
+
+static void BM_Sha256(benchmark::State& state) {
+    std::string input(static_cast<size_t>(state.range(0)), 'v');
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(HashFusion::sha256(input));
+    }
+    state.SetBytesProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_Sha256)->Arg(64)->Arg(1024)->Arg(64 * 1024);
+
+static void BM_Sha256Digest(benchmark::State& state) {
+    std::string input(static_cast<size_t>(state.range(0)), 'v');
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(HashFusion::sha256Digest(input.data(), input.size()));
+    }
+    state.SetBytesProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_Sha256Digest)->Arg(64)->Arg(1024)->Arg(64 * 1024);
+
+static void BM_VoterHashFusion(benchmark::State& state) {
+    LatencyRecorder latency;
+    size_t i = 0;
+    for (auto _ : state) {
+        latency.measure([&] {
+            benchmark::DoNotOptimize(HashFusion::voterHashFusion(voterInput(i++), SALT, TIMESTAMP));
+        });
+    }
+    state.SetItemsProcessed(state.iterations());
+    latency.report(state);
+}
+BENCHMARK(BM_VoterHashFusion);
+
+// Same digests with the salt and time suffixes padded once per batch
+static void BM_VoterHashFusionContext(benchmark::State& state) {
+    LatencyRecorder latency;
+    FusionContext fusion(SALT, TIMESTAMP);
+    size_t i = 0;
+    for (auto _ : state) {
+        latency.measure([&] {
+            benchmark::DoNotOptimize(fusion.voterHashFusion(voterInput(i++)));
+        });
+    }
+    state.SetItemsProcessed(state.iterations());
+    latency.report(state);
+}
+BENCHMARK(BM_VoterHashFusionContext);
+
+static void BM_TrieInsert(benchmark::State& state) {
+    Registry& registry = registryOfSize(static_cast<size_t>(state.range(0)));
+    LatencyRecorder latency;
+    size_t i = 0;
+    for (auto _ : state) {
+        state.PauseTiming();
+        std::string key = HashFusion::sha256("insert-" + std::to_string(i++));
+        state.ResumeTiming();
+        latency.measure([&] { registry.trie->insert(key, "inserted"); });
+    }
+    state.SetItemsProcessed(state.iterations());
+    latency.report(state);
+    // The inserts changed the trie; rebuild it for the next benchmark
+    registry.trie.reset();
+}
+BENCHMARK(BM_TrieInsert)->Apply(VoterCounts);
+
+static void BM_TrieSearch(benchmark::State& state) {
+    Registry& registry = registryOfSize(static_cast<size_t>(state.range(0)));
+    LatencyRecorder latency;
+    size_t i = 0;
+    for (auto _ : state) {
+        const std::string& key = registry.keys[(i++ * 7919) % registry.keys.size()];
+        latency.measure([&] { benchmark::DoNotOptimize(registry.trie->search(key)); });
+    }
+    state.SetItemsProcessed(state.iterations());
+    latency.report(state);
+}
+BENCHMARK(BM_TrieSearch)->Apply(VoterCounts);
+
+static void BM_TrieMerkleProof(benchmark::State& state) {
+    Registry& registry = registryOfSize(static_cast<size_t>(state.range(0)));
+    LatencyRecorder latency;
+    size_t i = 0;
+    for (auto _ : state) {
+        const std::string& key = registry.keys[(i++ * 7919) % registry.keys.size()];
+        latency.measure([&] { benchmark::DoNotOptimize(registry.trie->getMerkleProof(key)); });
+    }
+    state.SetItemsProcessed(state.iterations());
+    latency.report(state);
+}
+BENCHMARK(BM_TrieMerkleProof)->Apply(VoterCounts);
+
+static void BM_TrieGetSize(benchmark::State& state) {
+    Registry& registry = registryOfSize(static_cast<size_t>(state.range(0)));
+    LatencyRecorder latency;
+    for (auto _ : state) {
+        latency.measure([&] { benchmark::DoNotOptimize(registry.trie->getSize()); });
+    }
+    state.SetItemsProcessed(state.iterations());
+    latency.report(state);
+}
+BENCHMARK(BM_TrieGetSize)->Apply(VoterCounts);
+
+static std::vector<Digest> nullifiersOfSize(size_t n) {
+    std::vector<Digest> nullifiers(n);
+    for (size_t i = 0; i < n; i++) {
+        std::string input = voterInput(i);
+        nullifiers[i] = HashFusion::sha256Digest(input.data(), input.size());
+    }
+    return nullifiers;
+}
+
+static void BM_NullifierTreeInsertBatch(benchmark::State& state) {
+    std::vector<Digest> keys = nullifiersOfSize(state.range(0));
+    for (auto _ : state) {
+        NullifierTree tree;
+        tree.insertBatch(keys);
+        benchmark::DoNotOptimize(tree.getRoot());
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_NullifierTreeInsertBatch)->Arg(1000)->Arg(10000)->Unit(benchmark::kMillisecond);
+
+static void BM_NullifierTreeProof(benchmark::State& state) {
+    std::vector<Digest> keys = nullifiersOfSize(state.range(0));
+    NullifierTree tree;
+    tree.insertBatch(keys);
+    SparseMerkleProof proof;
+    Digest absent = HashFusion::sha256Digest("absent", 6);
+    size_t i = 0;
+    for (auto _ : state) {
+        // Alternate membership and non-membership proofs
+        const Digest& key = (i % 2) ? absent : keys[(i * 7919) % keys.size()];
+        i++;
+        tree.getProof(key, proof);
+        benchmark::DoNotOptimize(proof.siblings.data());
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_NullifierTreeProof)->Arg(10000);
+
+static void BM_TallyIngest(benchmark::State& state) {
+    size_t n = static_cast<size_t>(state.range(0));
+    std::vector<Digest> nullifiers = nullifiersOfSize(n);
+    std::vector<uint8_t> records(n * VoteTally::RECORD_BYTES);
+    for (size_t i = 0; i < n; i++) {
+        uint8_t* record = records.data() + i * VoteTally::RECORD_BYTES;
+        std::copy(nullifiers[i].begin(), nullifiers[i].end(), record);
+        record[sizeof(Digest)] = static_cast<uint8_t>(i % 8);
+    }
+    for (auto _ : state) {
+        VoteTally tally(8);
+        NullifierSet spent(n);
+        benchmark::DoNotOptimize(tally.ingest(records.data(), n, spent, nullptr));
+    }
+    state.SetItemsProcessed(state.iterations() * n);
+}
+BENCHMARK(BM_TallyIngest)->Arg(100000)->Arg(1000000)->Unit(benchmark::kMillisecond);
+
+// Several threads casting disjoint 10k-vote batches into one tally and
+// one sharded set, as concurrent castVotesAsync calls do
+static void BM_TallyIngestSharded(benchmark::State& state) {
+    static VoteTally tally(8);
+    static ShardedNullifierSet spent;
+    const size_t n = 10000;
+    std::vector<uint8_t> records(n * VoteTally::RECORD_BYTES, 0);
+    uint64_t next = uint64_t(state.thread_index()) << 40;
+    for (auto _ : state) {
+        for (size_t i = 0; i < n; i++) {
+            uint8_t* record = records.data() + i * VoteTally::RECORD_BYTES;
+            // Distinct counters suffice; the set hashes them with its key
+            ++next;
+            std::memcpy(record, &next, sizeof(next));
+            record[sizeof(Digest)] = static_cast<uint8_t>(i % 8);
+        }
+        benchmark::DoNotOptimize(tally.ingest(records.data(), n, spent, nullptr));
+    }
+    state.SetItemsProcessed(state.iterations() * n);
+}
+BENCHMARK(BM_TallyIngestSharded)->Threads(1)->Threads(4)->UseRealTime()->Unit(benchmark::kMillisecond);
+
+static void BM_TallyDelta(benchmark::State& state) {
+    VoteTally tally(static_cast<size_t>(state.range(0)));
+    NullifierSet spent;
+    uint8_t record[VoteTally::RECORD_BYTES] = {};
+    uint64_t since = tally.sequence();
+    uint64_t i = 0;
+    for (auto _ : state) {
+        // One new vote per read, as under a steady live stream
+        std::memcpy(record, &++i, sizeof(i));
+        tally.ingest(record, 1, spent, nullptr);
+        VoteTally::Totals totals = tally.delta(since);
+        since = totals.sequence;
+        benchmark::DoNotOptimize(totals.counts.data());
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_TallyDelta)->Arg(8)->Arg(1024);
+
+// The string API takes every leaf on each call, so the sizes stop at 1M
+static void BM_GenerateMerkleProof(benchmark::State& state) {
+    size_t n = static_cast<size_t>(state.range(0));
+    std::vector<std::string> leaves(n);
+    for (size_t i = 0; i < n; i++) {
+        leaves[i] = HashFusion::sha256(voterInput(i));
+    }
+    
+    LatencyRecorder latency;
+    size_t i = 0;
+    for (auto _ : state) {
+        const std::string& target = leaves[(i++ * 7919) % n];
+        latency.measure([&] { benchmark::DoNotOptimize(HashFusion::generateMerkleProof(leaves, target)); });
+    }
+    state.SetItemsProcessed(state.iterations() * n);
+    latency.report(state);
+}
+BENCHMARK(BM_GenerateMerkleProof)->RangeMultiplier(10)->Range(1000, 1000000)
+    ->Unit(benchmark::kMillisecond);
+
+static void BM_HexEncode(benchmark::State& state) {
+    std::vector<uint8_t> data(static_cast<size_t>(state.range(0)), 0xa5);
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(HashFusion::hexEncode(data));
+    }
+    state.SetBytesProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_HexEncode)->Arg(32)->Arg(1024);
+
+static void BM_HexDecode(benchmark::State& state) {
+    std::string hex = HashFusion::hexEncode(std::vector<uint8_t>(static_cast<size_t>(state.range(0)), 0xa5));
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(HashFusion::hexDecode(hex));
+    }
+    state.SetBytesProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_HexDecode)->Arg(32)->Arg(1024);
+
+static void BM_DigestToHex(benchmark::State& state) {
+    Digest digest = HashFusion::sha256Digest("voter", 5);
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(HashFusion::toHex(digest));
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_DigestToHex);
+
+static void BM_DigestFromHex(benchmark::State& state) {
+    std::string hex = HashFusion::sha256("voter");
+    Digest digest;
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(HashFusion::fromHex(hex, digest));
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_DigestFromHex);
+
+BENCHMARK_MAIN();
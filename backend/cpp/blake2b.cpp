@@ -0,0 +1,146 @@
+#include "include/blake2b.h"
+#include "include/metrics.h"
+#include <algorithm>
+#include <cstring>
+
+static const uint64_t INITIAL_STATE[8] = {
+    0x6a09e667f3bcc908ULL, 0xbb67ae8584caa73bULL, 0x3c6ef372fe94f82bULL, 0xa54ff53a5f1d36f1ULL,
+    0x510e527fade682d1ULL, 0x9b05688c2b3e6c1fULL, 0x1f83d9abfb41bd6bULL, 0x5be0cd19137e2179ULL
+};
+
+static const uint8_t SIGMA[12][16] = {
+    { 0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15 },
+    { 14, 10, 4, 8, 9, 15, 13, 6, 1, 12, 0, 2, 11, 7, 5, 3 },
+    { 11, 8, 12, 0, 5, 2, 15, 13, 10, 14, 3, 6, 7, 1, 9, 4 },
+    { 7, 9, 3, 1, 13, 12, 11, 14, 2, 6, 5, 10, 4, 0, 15, 8 },
+    { 9, 0, 5, 7, 2, 4, 10, 15, 14, 1, 11, 12, 6, 8, 3, 13 },
+    { 2, 12, 6, 10, 0, 11, 8, 3, 4, 13, 7, 5, 15, 14, 1, 9 },
+    { 12, 5, 1, 15, 14, 13, 4, 10, 0, 7, 6, 3, 9, 2, 8, 11 },
+    { 13, 11, 7, 14, 12, 1, 3, 9, 5, 0, 15, 4, 8, 6, 2, 10 },
+    { 6, 15, 14, 9, 11, 3, 0, 8, 12, 2, 13, 7, 1, 4, 10, 5 },
+    { 10, 2, 8, 4, 7, 6, 1, 5, 15, 11, 9, 14, 3, 12, 13, 0 },
+    { 0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15 },
+    { 14, 10, 4, 8, 9, 15, 13, 6, 1, 12, 0, 2, 11, 7, 5, 3 }
+};
+
+static inline uint64_t rotr(uint64_t x, int n) {
+    return (x >> n) | (x << (64 - n));
+}
+
+static inline uint64_t loadLittleEndian(const uint8_t* p) {
+    uint64_t v = 0;
+    for (int i = 7; i >= 0; i--) {
+        v = (v << 8) | p[i];
+    }
+    return v;
+}
+
+#define BLAKE2B_G(a, b, c, d, x, y)         \
+    do {                                    \
+        a = a + b + (x); d = rotr(d ^ a, 32);   \
+        c = c + d;       b = rotr(b ^ c, 24);   \
+        a = a + b + (y); d = rotr(d ^ a, 16);   \
+        c = c + d;       b = rotr(b ^ c, 63);   \
+    } while (0)
+
+Blake2bStream::Blake2bStream(size_t outputLength)
+    : bufferLength(0), outputLength(std::min(std::max<size_t>(outputLength, 1), MAX_OUTPUT)) {
+    std::memcpy(state, INITIAL_STATE, sizeof(state));
+    // Parameter block: digest length, no key, fanout 1, depth 1
+    state[0] ^= 0x01010000ULL ^ this->outputLength;
+    counter[0] = counter[1] = 0;
+}
+
+void Blake2bStream::compress(const uint8_t* block, bool last) {
+    uint64_t m[16];
+    for (int i = 0; i < 16; i++) {
+        m[i] = loadLittleEndian(block + 8 * i);
+    }
+    
+    uint64_t v0 = state[0], v1 = state[1], v2 = state[2], v3 = state[3];
+    uint64_t v4 = state[4], v5 = state[5], v6 = state[6], v7 = state[7];
+    uint64_t v8 = INITIAL_STATE[0], v9 = INITIAL_STATE[1];
+    uint64_t v10 = INITIAL_STATE[2], v11 = INITIAL_STATE[3];
+    uint64_t v12 = INITIAL_STATE[4] ^ counter[0];
+    uint64_t v13 = INITIAL_STATE[5] ^ counter[1];
+    uint64_t v14 = last ? ~INITIAL_STATE[6] : INITIAL_STATE[6];
+    uint64_t v15 = INITIAL_STATE[7];
+    
+    for (int round = 0; round < 12; round++) {
+        const uint8_t* s = SIGMA[round];
+        BLAKE2B_G(v0, v4, v8, v12, m[s[0]], m[s[1]]);
+        BLAKE2B_G(v1, v5, v9, v13, m[s[2]], m[s[3]]);
+        BLAKE2B_G(v2, v6, v10, v14, m[s[4]], m[s[5]]);
+        BLAKE2B_G(v3, v7, v11, v15, m[s[6]], m[s[7]]);
+        BLAKE2B_G(v0, v5, v10, v15, m[s[8]], m[s[9]]);
+        BLAKE2B_G(v1, v6, v11, v12, m[s[10]], m[s[11]]);
+        BLAKE2B_G(v2, v7, v8, v13, m[s[12]], m[s[13]]);
+        BLAKE2B_G(v3, v4, v9, v14, m[s[14]], m[s[15]]);
+    }
+    
+    state[0] ^= v0 ^ v8;  state[1] ^= v1 ^ v9;
+    state[2] ^= v2 ^ v10; state[3] ^= v3 ^ v11;
+    state[4] ^= v4 ^ v12; state[5] ^= v5 ^ v13;
+    state[6] ^= v6 ^ v14; state[7] ^= v7 ^ v15;
+}
+
+Blake2bStream& Blake2bStream::update(const void* data, size_t length) {
+    const uint8_t* bytes = static_cast<const uint8_t*>(data);
+    
+    // The final block is compressed with the last-block flag, so a full
+    // buffer is only flushed once more input arrives
+    while (length > 0) {
+        if (bufferLength == BLOCK_SIZE) {
+            counter[0] += BLOCK_SIZE;
+            if (counter[0] < BLOCK_SIZE) counter[1]++;
+            compress(buffer, false);
+            bufferLength = 0;
+        }
+        
+        if (bufferLength == 0 && length > BLOCK_SIZE) {
+            counter[0] += BLOCK_SIZE;
+            if (counter[0] < BLOCK_SIZE) counter[1]++;
+            compress(bytes, false);
+            bytes += BLOCK_SIZE;
+            length -= BLOCK_SIZE;
+            continue;
+        }
+        
+        size_t take = std::min(length, BLOCK_SIZE - bufferLength);
+        std::memcpy(buffer + bufferLength, bytes, take);
+        bufferLength += take;
+        bytes += take;
+        length -= take;
+    }
+    return *this;
+}
+
+Blake2bStream& Blake2bStream::update(const std::string& data) {
+    return update(data.data(), data.size());
+}
+
+Blake2bStream& Blake2bStream::update(char c) {
+    return update(&c, 1);
+}
+
+void Blake2bStream::finish(uint8_t* out) {
+    TRIE_METRIC_COUNT(BLAKE2B_HASHES, 1);
+    counter[0] += bufferLength;
+    if (counter[0] < bufferLength) counter[1]++;
+    std::memset(buffer + bufferLength, 0, BLOCK_SIZE - bufferLength);
+    compress(buffer, true);
+    
+    for (size_t i = 0; i < outputLength; i++) {
+        out[i] = static_cast<uint8_t>(state[i / 8] >> (8 * (i % 8)));
+    }
+}
+
+Digest Blake2bStream::finish() {
+    Digest digest;
+    finish(digest.data());
+    return digest;
+}
+
+Digest Blake2bStream::hash(const void* data, size_t length) {
+    return Blake2bStream().update(data, length).finish();
+}
@@ -1,118 +1,191 @@
 #include "include/hash_fusion.h"
-#include <openssl/sha.h>
-#include <openssl/evp.h>
-#include <iomanip>
-#include <sstream>
+#include "include/keccak.h"
+#include "include/blake2b.h"
+#include "include/merkle_tree.h"
+#include "include/metrics.h"
 #include <algorithm>
 #include <cstring>
 
+static const char HEX_DIGITS[] = "0123456789abcdef";
+
+// Streams already fed the layer tags; hashes copy them instead of
+// feeding the tag again
+static const Sha256Stream KECCAK_TAG = Sha256Stream().update("keccak:", 7);
+static const Sha256Stream BLAKE2B_TAG = Sha256Stream().update("blake2b:", 8);
+
 // SHA256 implementation
 std::string HashFusion::sha256(const std::string& input) {
-    std::vector<uint8_t> inputBytes(input.begin(), input.end());
-    std::vector<uint8_t> hash = computeSHA256(inputBytes);
-    return hexEncode(hash);
+    return toHex(sha256Digest(input.data(), input.size()));
+}
+
+Digest HashFusion::sha256Digest(const void* data, size_t length) {
+    return Sha256Stream().update(data, length).finish();
 }
 
-// Keccak256 implementation (simplified - using SHA256 for compatibility)
+std::vector<Digest> HashFusion::sha256Batch(const std::vector<std::string>& inputs) {
+    std::vector<const uint8_t*> data(inputs.size());
+    std::vector<size_t> lengths(inputs.size());
+    for (size_t i = 0; i < inputs.size(); i++) {
+        data[i] = reinterpret_cast<const uint8_t*>(inputs[i].data());
+        lengths[i] = inputs[i].size();
+    }
+    
+    std::vector<Digest> digests(inputs.size());
+    sha256Batch(data.data(), lengths.data(), inputs.size(), digests.data());
+    return digests;
+}
+
+void HashFusion::sha256Batch(const uint8_t* const* data, const size_t* lengths,
+                             size_t count, Digest* out) {
+    Sha256::hashMany(data, lengths, count, out);
+}
+
+// Tagged SHA-256 fusion layers. Every voter hash and nullifier already
+// issued goes through these, so they are not switched to the real
+// engines; use ethKeccak256/blake2b256 for the genuine functions
 std::string HashFusion::keccak256(const std::string& input) {
-    // In production, use proper Keccak256 implementation
-    // For now, using SHA256 as fallback
-    return sha256("keccak:" + input);
+    return toHex(Sha256Stream(KECCAK_TAG).update(input).finish());
 }
 
-// Blake2b implementation (simplified - using SHA256 for compatibility)
 std::string HashFusion::blake2b(const std::string& input) {
-    // In production, use proper Blake2b implementation
-    // For now, using SHA256 as fallback
-    return sha256("blake2b:" + input);
+    return toHex(Sha256Stream(BLAKE2B_TAG).update(input).finish());
+}
+
+// Ethereum Keccak-256, equal to Solidity keccak256() / ethers.keccak256
+std::string HashFusion::ethKeccak256(const std::string& input) {
+    return toHex(Keccak256Stream::hash(input.data(), input.size()));
+}
+
+std::string HashFusion::blake2b256(const std::string& input) {
+    return toHex(Blake2bStream::hash(input.data(), input.size()));
+}
+
+std::string HashFusion::blake2b512(const std::string& input) {
+    uint8_t digest[Blake2bStream::MAX_OUTPUT];
+    Blake2bStream(sizeof(digest)).update(input).finish(digest);
+    return bytesToHex(digest, sizeof(digest));
 }
 
 // Trie-specific hash fusion combining multiple algorithms
 std::string HashFusion::trieHashFusion(const std::string& input, 
                                       const std::string& salt, 
                                       uint64_t timestamp) {
-    // Multi-layer hash fusion for enhanced security
-    std::string layer1 = sha256(input + salt);
-    std::string layer2 = keccak256(layer1 + std::to_string(timestamp));
-    std::string layer3 = blake2b(layer2 + input);
-    
-    // Final fusion
-    std::string finalInput = layer1 + layer2 + layer3 + salt;
-    return sha256(finalInput);
+    return toHex(trieHashFusionDigest(input, salt, timestamp));
+}
+
+Digest HashFusion::trieHashFusionDigest(const std::string& input,
+                                        const std::string& salt,
+                                        uint64_t timestamp) {
+    return FusionContext(salt, timestamp).trieHashFusion(input);
 }
 
 // Voter-specific hash fusion
 std::string HashFusion::voterHashFusion(const std::string& voterInput,
                                        const std::string& salt,
                                        uint64_t timestamp) {
-    // Step 1: Basic hash of voter input
-    std::string baseHash = sha256(voterInput);
-    
-    // Step 2: Add temporal component
-    std::string timeHash = sha256(baseHash + std::to_string(timestamp));
-    
-    // Step 3: Add salt for uniqueness
-    std::string saltedHash = keccak256(timeHash + salt);
-    
-    // Step 4: Final trie hash fusion
-    return trieHashFusion(saltedHash, salt, timestamp);
+    return toHex(voterHashFusionDigest(voterInput, salt, timestamp));
+}
+
+Digest HashFusion::voterHashFusionDigest(const std::string& voterInput,
+                                         const std::string& salt,
+                                         uint64_t timestamp) {
+    return FusionContext(salt, timestamp).voterHashFusion(voterInput);
 }
 
 // Generate nullifier hash to prevent double voting
 std::string HashFusion::generateNullifier(const std::string& voterHash,
                                          const std::string& secret) {
     // Nullifier = Hash(voterHash + secret + "NULLIFIER")
-    std::string nullifierInput = voterHash + secret + "NULLIFIER";
-    return sha256(nullifierInput);
+    return toHex(Sha256Stream().update(voterHash).update(secret).update("NULLIFIER", 9).finish());
+}
+
+Digest HashFusion::nullifierDigest(const Digest& voterHash, const std::string& secret) {
+    return Sha256Stream().updateHex(voterHash).update(secret).update("NULLIFIER", 9).finish();
 }
 
 // Combine two hashes (for Merkle tree operations)
 std::string HashFusion::combineHashes(const std::string& left, const std::string& right) {
     // Sort hashes to ensure consistent ordering
-    std::string first = left < right ? left : right;
-    std::string second = left < right ? right : left;
+    const std::string& first = left < right ? left : right;
+    const std::string& second = left < right ? right : left;
+    
+    return toHex(Sha256Stream().update(first).update(second).finish());
+}
+
+Digest HashFusion::combineDigests(const Digest& left, const Digest& right) {
+    // Lowercase hex preserves byte order, so this matches combineHashes
+    bool leftFirst = left < right;
+    const Digest& first = leftFirst ? left : right;
+    const Digest& second = leftFirst ? right : left;
     
-    return sha256(first + second);
+    return Sha256Stream().updateHex(first).updateHex(second).finish();
 }
 
 // Generate Merkle proof for a set of leaves
 std::vector<std::string> HashFusion::generateMerkleProof(const std::vector<std::string>& leaves,
                                                         const std::string& target) {
     std::vector<std::string> proof;
-    std::vector<std::string> currentLevel = leaves;
     
     // Find target index
-    auto it = std::find(currentLevel.begin(), currentLevel.end(), target);
-    if (it == currentLevel.end()) {
+    auto it = std::find(leaves.begin(), leaves.end(), target);
+    if (it == leaves.end()) {
         return proof; // Target not found
     }
     
-    size_t targetIndex = std::distance(currentLevel.begin(), it);
+    size_t targetIndex = std::distance(leaves.begin(), it);
+    
+    // Lowercase hex digests (every hash this module emits) order the same
+    // as their bytes, so MerkleTree builds the identical tree in place
+    std::vector<Digest> digests(leaves.size());
+    bool allDigests = true;
+    for (size_t i = 0; i < leaves.size() && allDigests; i++) {
+        allDigests = leaves[i].find_first_not_of("0123456789abcdef") == std::string::npos &&
+                     fromHex(leaves[i], digests[i]);
+    }
     
-    // Build proof by traversing up the tree
+    if (allDigests) {
+        MerkleTree<Sha256HexPolicy> tree(digests);
+        for (const auto& sibling : tree.getProof(targetIndex)) {
+            proof.push_back(toHex(sibling));
+        }
+        return proof;
+    }
+    
+    // Arbitrary strings: build level by level; each level's pairs are
+    // independent and hashed together on the multi-buffer kernel
+    std::vector<std::string> currentLevel = leaves;
     while (currentLevel.size() > 1) {
-        std::vector<std::string> nextLevel;
+        size_t pairs = currentLevel.size() / 2;
+        std::vector<std::string> pairInputs(pairs);
         
-        for (size_t i = 0; i < currentLevel.size(); i += 2) {
-            if (i + 1 < currentLevel.size()) {
-                // Add sibling to proof if current index is target or its sibling
-                if (i == targetIndex || i + 1 == targetIndex) {
-                    size_t siblingIndex = (i == targetIndex) ? i + 1 : i;
-                    proof.push_back(currentLevel[siblingIndex]);
-                }
-                
-                // Combine hashes for next level
-                std::string combined = combineHashes(currentLevel[i], currentLevel[i + 1]);
-                nextLevel.push_back(combined);
-            } else {
-                // Odd number of elements, carry forward
-                nextLevel.push_back(currentLevel[i]);
+        for (size_t i = 0; i + 1 < currentLevel.size(); i += 2) {
+            // Add sibling to proof if current index is target or its sibling
+            if (i == targetIndex || i + 1 == targetIndex) {
+                size_t siblingIndex = (i == targetIndex) ? i + 1 : i;
+                proof.push_back(currentLevel[siblingIndex]);
             }
+            
+            // Sorted concatenation, as in combineHashes
+            const std::string& left = currentLevel[i];
+            const std::string& right = currentLevel[i + 1];
+            pairInputs[i / 2] = left < right ? left + right : right + left;
+        }
+        
+        std::vector<Digest> combined = sha256Batch(pairInputs);
+        std::vector<std::string> nextLevel;
+        nextLevel.reserve(pairs + 1);
+        for (const auto& digest : combined) {
+            nextLevel.push_back(toHex(digest));
+        }
+        
+        // Odd number of elements, carry forward
+        if (currentLevel.size() % 2 == 1) {
+            nextLevel.push_back(currentLevel.back());
         }
         
         // Update target index for next level
         targetIndex = targetIndex / 2;
-        currentLevel = nextLevel;
+        currentLevel.swap(nextLevel);
     }
     
     return proof;
@@ -120,49 +193,141 @@ std::vector<std::string> HashFusion::generateMerkleProof(const std::vector<std::
 
 // Utility functions
 std::string HashFusion::hexEncode(const std::vector<uint8_t>& data) {
-    std::stringstream ss;
-    ss << std::hex << std::setfill('0');
-    for (uint8_t byte : data) {
-        ss << std::setw(2) << static_cast<int>(byte);
-    }
-    return ss.str();
+    return bytesToHex(data.data(), data.size());
 }
 
 std::vector<uint8_t> HashFusion::hexDecode(const std::string& hex) {
+    // Table-driven; malformed pairs decode like the old strtol parse: a
+    // non-hex second character keeps the first nibble, a non-hex first 0
+    static const struct NibbleTable {
+        int8_t value[256];
+        NibbleTable() {
+            std::memset(value, -1, sizeof(value));
+            for (int i = 0; i < 10; i++) value['0' + i] = static_cast<int8_t>(i);
+            for (int i = 0; i < 6; i++) {
+                value['a' + i] = static_cast<int8_t>(10 + i);
+                value['A' + i] = static_cast<int8_t>(10 + i);
+            }
+        }
+    } table;
+    
     std::vector<uint8_t> result;
+    result.reserve((hex.length() + 1) / 2);
     for (size_t i = 0; i < hex.length(); i += 2) {
-        std::string byteString = hex.substr(i, 2);
-        uint8_t byte = static_cast<uint8_t>(std::strtol(byteString.c_str(), nullptr, 16));
-        result.push_back(byte);
+        int high = table.value[static_cast<uint8_t>(hex[i])];
+        int low = i + 1 < hex.length() ? table.value[static_cast<uint8_t>(hex[i + 1])] : -1;
+        
+        if (high < 0) {
+            result.push_back(0);
+        } else if (low < 0) {
+            result.push_back(static_cast<uint8_t>(high));
+        } else {
+            result.push_back(static_cast<uint8_t>((high << 4) | low));
+        }
     }
     return result;
 }
 
 std::string HashFusion::bytesToHex(const uint8_t* data, size_t length) {
-    std::vector<uint8_t> vec(data, data + length);
-    return hexEncode(vec);
+    std::string hex(length * 2, '\0');
+    hexEncodeTo(data, length, &hex[0]);
+    return hex;
+}
+
+void HashFusion::hexEncodeTo(const uint8_t* data, size_t length, char* out) {
+    for (size_t i = 0; i < length; i++) {
+        out[2 * i] = HEX_DIGITS[data[i] >> 4];
+        out[2 * i + 1] = HEX_DIGITS[data[i] & 0x0f];
+    }
+}
+
+std::string HashFusion::toHex(const Digest& digest) {
+    return bytesToHex(digest.data(), digest.size());
+}
+
+bool HashFusion::fromHex(const std::string& hex, Digest& digest) {
+    if (hex.length() != digest.size() * 2 ||
+        hex.find_first_not_of("0123456789abcdefABCDEF") != std::string::npos) {
+        return false;
+    }
+    
+    std::vector<uint8_t> bytes = hexDecode(hex);
+    std::copy(bytes.begin(), bytes.end(), digest.begin());
+    return true;
 }
 
 // Internal hash computation helpers
 std::vector<uint8_t> HashFusion::computeSHA256(const std::vector<uint8_t>& input) {
-    std::vector<uint8_t> hash(SHA256_DIGEST_LENGTH);
-    
-    SHA256_CTX sha256;
-    SHA256_Init(&sha256);
-    SHA256_Update(&sha256, input.data(), input.size());
-    SHA256_Final(hash.data(), &sha256);
-    
-    return hash;
+    Digest hash = sha256Digest(input.data(), input.size());
+    return std::vector<uint8_t>(hash.begin(), hash.end());
 }
 
 std::vector<uint8_t> HashFusion::computeKeccak256(const std::vector<uint8_t>& input) {
-    // Fallback to SHA256 for compatibility
-    // In production, implement proper Keccak256
-    return computeSHA256(input);
+    Digest hash = Keccak256Stream::hash(input.data(), input.size());
+    return std::vector<uint8_t>(hash.begin(), hash.end());
 }
 
 std::vector<uint8_t> HashFusion::computeBlake2b(const std::vector<uint8_t>& input) {
-    // Fallback to SHA256 for compatibility
-    // In production, implement proper Blake2b
-    return computeSHA256(input);
-}
\ No newline at end of file
+    Digest hash = Blake2bStream::hash(input.data(), input.size());
+    return std::vector<uint8_t>(hash.begin(), hash.end());
+}
+
+// FusionContext implementation
+FusionContext::FusionContext(const std::string& salt, uint64_t timestamp)
+    : salt(salt),
+      time(std::to_string(timestamp)),
+      saltTail(1, salt),
+      timeTail(1, time),
+      fusionTail(3, salt),
+      nullifierTail(1, salt + "NULLIFIER") {}
+
+// Multi-layer hash fusion for enhanced security; each layer hashes the
+// hex form of the previous one, streamed without building the strings
+Digest FusionContext::fuseLayers(const char* input, size_t inputLength) const {
+    char layers[3 * 64];
+    
+    Digest layer1 = inputLength == 64
+        ? saltTail.hash(reinterpret_cast<const uint8_t*>(input))
+        : Sha256Stream().update(input, inputLength).update(salt).finish();
+    HashFusion::hexEncodeTo(layer1.data(), layer1.size(), layers);
+    
+    Digest layer2 = Sha256Stream(KECCAK_TAG).update(layers, 64).update(time).finish();
+    HashFusion::hexEncodeTo(layer2.data(), layer2.size(), layers + 64);
+    
+    Digest layer3 = Sha256Stream(BLAKE2B_TAG).update(layers + 64, 64)
+        .update(input, inputLength).finish();
+    HashFusion::hexEncodeTo(layer3.data(), layer3.size(), layers + 128);
+    
+    // Final fusion
+    return fusionTail.hash(reinterpret_cast<const uint8_t*>(layers));
+}
+
+Digest FusionContext::trieHashFusion(const std::string& input) const {
+    return fuseLayers(input.data(), input.size());
+}
+
+Digest FusionContext::voterHashFusion(const std::string& voterInput) const {
+    TRIE_METRIC_TIME(VOTER_HASH_FUSION);
+    char hex[64];
+    
+    // Step 1: Basic hash of voter input
+    Digest baseHash = HashFusion::sha256Digest(voterInput.data(), voterInput.size());
+    HashFusion::hexEncodeTo(baseHash.data(), baseHash.size(), hex);
+    
+    // Step 2: Add temporal component
+    Digest timeHash = timeTail.hash(reinterpret_cast<const uint8_t*>(hex));
+    HashFusion::hexEncodeTo(timeHash.data(), timeHash.size(), hex);
+    
+    // Step 3: Add salt for uniqueness
+    Digest saltedHash = Sha256Stream(KECCAK_TAG).update(hex, sizeof(hex)).update(salt).finish();
+    HashFusion::hexEncodeTo(saltedHash.data(), saltedHash.size(), hex);
+    
+    // Step 4: Final trie hash fusion
+    return fuseLayers(hex, sizeof(hex));
+}
+
+Digest FusionContext::nullifier(const Digest& voterHash) const {
+    char hex[64];
+    HashFusion::hexEncodeTo(voterHash.data(), voterHash.size(), hex);
+    return nullifierTail.hash(reinterpret_cast<const uint8_t*>(hex));
+}
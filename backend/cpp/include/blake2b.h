@@ -0,0 +1,40 @@
+#ifndef BLAKE2B_H
+#define BLAKE2B_H
+
+#include <string>
+#include <cstddef>
+#include <cstdint>
+#include "sha256.h"
+
+// Unkeyed BLAKE2b (RFC 7693) with a 1..64 byte output length. The
+// output length is part of the parameter block, so BLAKE2b-256 is not a
+// truncated BLAKE2b-512.
+class Blake2bStream {
+public:
+    static constexpr size_t BLOCK_SIZE = 128;
+    static constexpr size_t MAX_OUTPUT = 64;
+    
+    explicit Blake2bStream(size_t outputLength = 32);
+    
+    Blake2bStream& update(const void* data, size_t length);
+    Blake2bStream& update(const std::string& data);
+    Blake2bStream& update(char c);
+    
+    // Writes outputLength bytes
+    void finish(uint8_t* out);
+    // BLAKE2b-256; the stream must have been built with outputLength 32
+    Digest finish();
+    
+    static Digest hash(const void* data, size_t length);
+
+private:
+    uint64_t state[8];
+    uint64_t counter[2];
+    uint8_t buffer[BLOCK_SIZE];
+    size_t bufferLength;
+    size_t outputLength;
+    
+    void compress(const uint8_t* block, bool last);
+};
+
+#endif // BLAKE2B_H
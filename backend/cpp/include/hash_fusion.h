@@ -3,18 +3,24 @@
 
 #include <string>
 #include <vector>
-#include <cstdint>
+#include "sha256.h"
 
 class HashFusion {
 public:
-    // Core hash fusion algorithms
+    // Core hash fusion algorithms; keccak256/blake2b are the tagged
+    // SHA-256 layers the voter hashes were defined with
     static std::string sha256(const std::string& input);
     static std::string keccak256(const std::string& input);
     static std::string blake2b(const std::string& input);
     
+    // Genuine Keccak-256 (Ethereum padding) and BLAKE2b
+    static std::string ethKeccak256(const std::string& input);
+    static std::string blake2b256(const std::string& input);
+    static std::string blake2b512(const std::string& input);
+    
     // Trie-specific hash fusion
-    static std::string trieHashFusion(const std::string& input, 
-                                     const std::string& salt, 
+    static std::string trieHashFusion(const std::string& input,
+                                     const std::string& salt,
                                      uint64_t timestamp);
     
     // Multi-layer hash fusion for voter ID
@@ -31,11 +37,31 @@ public:
     static std::vector<std::string> generateMerkleProof(const std::vector<std::string>& leaves,
                                                        const std::string& target);
     
+    // Binary digest variants; toHex() of each equals the string API result
+    static Digest sha256Digest(const void* data, size_t length);
+    static Digest trieHashFusionDigest(const std::string& input,
+                                       const std::string& salt,
+                                       uint64_t timestamp);
+    static Digest voterHashFusionDigest(const std::string& voterInput,
+                                        const std::string& salt,
+                                        uint64_t timestamp);
+    static Digest nullifierDigest(const Digest& voterHash, const std::string& secret);
+    static Digest combineDigests(const Digest& left, const Digest& right);
+    
+    // Hash many independent messages at once on the multi-buffer kernel
+    static std::vector<Digest> sha256Batch(const std::vector<std::string>& inputs);
+    static void sha256Batch(const uint8_t* const* data, const size_t* lengths,
+                            size_t count, Digest* out);
+    
     // Utility functions
     static std::string hexEncode(const std::vector<uint8_t>& data);
     static std::vector<uint8_t> hexDecode(const std::string& hex);
     static std::string bytesToHex(const uint8_t* data, size_t length);
-    
+    static void hexEncodeTo(const uint8_t* data, size_t length, char* out);
+    static std::string toHex(const Digest& digest);
+    // Returns false unless hex is exactly 64 hex characters
+    static bool fromHex(const std::string& hex, Digest& digest);
+
 private:
     // Internal hash computation helpers
     static std::vector<uint8_t> computeSHA256(const std::vector<uint8_t>& input);
@@ -43,4 +69,28 @@ private:
     static std::vector<uint8_t> computeBlake2b(const std::vector<uint8_t>& input);
 };
 
-#endif // HASH_FUSION_H
\ No newline at end of file
+// Hash fusion for one salt and timestamp, e.g. a whole registration batch.
+// Their suffix blocks are padded once up front (see Sha256Tail), so each
+// voter only pays for its compressions. Digests equal the HashFusion
+// functions called with the same salt and timestamp.
+class FusionContext {
+public:
+    FusionContext(const std::string& salt, uint64_t timestamp);
+    
+    Digest trieHashFusion(const std::string& input) const;
+    Digest voterHashFusion(const std::string& voterInput) const;
+    // HashFusion::nullifierDigest(voterHash, salt)
+    Digest nullifier(const Digest& voterHash) const;
+
+private:
+    std::string salt;
+    std::string time;
+    Sha256Tail saltTail;        // hex digest | salt
+    Sha256Tail timeTail;        // hex digest | time
+    Sha256Tail fusionTail;      // three hex layers | salt
+    Sha256Tail nullifierTail;   // hex voter hash | salt | "NULLIFIER"
+    
+    Digest fuseLayers(const char* input, size_t inputLength) const;
+};
+
+#endif // HASH_FUSION_H
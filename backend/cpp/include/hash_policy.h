@@ -0,0 +1,83 @@
+#ifndef HASH_POLICY_H
+#define HASH_POLICY_H
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include "hash_fusion.h"
+#include "keccak.h"
+#include "blake2b.h"
+
+// Compile-time hash backends for BasicMerkleTrie and MerkleTree. A policy
+// supplies an incremental Stream, a batch entry point, the way a child
+// digest is encoded inside a parent's input, and the sorted-pair combine.
+//
+// Sha256HexPolicy is the original encoding (child digests enter as
+// lowercase hex) and keeps every existing root. The binary policies feed
+// the raw 32 bytes, so Keccak256Policy pairs are abi.encodePacked(a, b)
+// exactly as VotingWithMerkle.sol and merkletreejs (sortPairs) hash them.
+
+struct Sha256HexPolicy {
+    typedef Sha256Stream Stream;
+    static constexpr size_t ENCODED_DIGEST_SIZE = 64;
+    
+    static const char* name() { return "sha256"; }
+    
+    static void encodeDigest(const Digest& digest, char* out) {
+        HashFusion::hexEncodeTo(digest.data(), digest.size(), out);
+    }
+    static void updateDigest(Stream& stream, const Digest& digest) {
+        stream.updateHex(digest);
+    }
+    static Digest hash(const void* data, size_t length) {
+        return HashFusion::sha256Digest(data, length);
+    }
+    static void hashMany(const uint8_t* const* data, const size_t* lengths,
+                         size_t count, Digest* out) {
+        HashFusion::sha256Batch(data, lengths, count, out);
+    }
+    static Digest combine(const Digest& left, const Digest& right) {
+        return HashFusion::combineDigests(left, right);
+    }
+};
+
+// Shared by the binary policies: digests are fed as raw bytes and pairs
+// are hashed smaller-first, one message at a time
+template <typename StreamType>
+struct BinaryHashPolicy {
+    typedef StreamType Stream;
+    static constexpr size_t ENCODED_DIGEST_SIZE = 32;
+    
+    static void encodeDigest(const Digest& digest, char* out) {
+        std::memcpy(out, digest.data(), digest.size());
+    }
+    static void updateDigest(Stream& stream, const Digest& digest) {
+        stream.update(digest.data(), digest.size());
+    }
+    static Digest hash(const void* data, size_t length) {
+        return Stream::hash(data, length);
+    }
+    static void hashMany(const uint8_t* const* data, const size_t* lengths,
+                         size_t count, Digest* out) {
+        for (size_t i = 0; i < count; i++) {
+            out[i] = Stream::hash(data[i], lengths[i]);
+        }
+    }
+    static Digest combine(const Digest& left, const Digest& right) {
+        bool leftFirst = left < right;
+        Stream stream;
+        updateDigest(stream, leftFirst ? left : right);
+        updateDigest(stream, leftFirst ? right : left);
+        return stream.finish();
+    }
+};
+
+struct Keccak256Policy : BinaryHashPolicy<Keccak256Stream> {
+    static const char* name() { return "keccak256-eth"; }
+};
+
+struct Blake2bPolicy : BinaryHashPolicy<Blake2bStream> {
+    static const char* name() { return "blake2b-256"; }
+};
+
+#endif // HASH_POLICY_H
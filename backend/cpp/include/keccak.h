@@ -0,0 +1,32 @@
+#ifndef KECCAK_H
+#define KECCAK_H
+
+#include <string>
+#include <cstddef>
+#include <cstdint>
+#include "sha256.h"
+
+// Keccak-256 as used by Ethereum and Solidity's keccak256(): the original
+// Keccak submission padding (0x01 ... 0x80), not FIPS-202 SHA3-256
+class Keccak256Stream {
+public:
+    // Sponge rate in bytes for a 512-bit capacity
+    static constexpr size_t RATE = 136;
+    
+    Keccak256Stream();
+    
+    Keccak256Stream& update(const void* data, size_t length);
+    Keccak256Stream& update(const std::string& data);
+    Keccak256Stream& update(char c);
+    
+    Digest finish();
+    
+    static Digest hash(const void* data, size_t length);
+    static void permute(uint64_t state[25]);
+
+private:
+    uint64_t state[25];
+    size_t position;    // bytes absorbed into the current block
+};
+
+#endif // KECCAK_H
@@ -0,0 +1,83 @@
+#ifndef MERKLE_TREE_H
+#define MERKLE_TREE_H
+
+#include <vector>
+#include <unordered_map>
+#include <cstddef>
+#include <cstdint>
+#include "hash_policy.h"
+
+// Proof for several leaves at once; siblings shared between their paths
+// or derivable from the other leaves appear once or not at all
+struct MerkleMultiProof {
+    size_t leafCount;
+    std::vector<size_t> indices;    // ascending and unique
+    std::vector<Digest> leaves;     // leaves[i] sits at indices[i]
+    std::vector<Digest> proof;      // in the order verification consumes them
+    // OpenZeppelin MerkleProof.multiProofVerify flags for the same hash
+    // steps: true pairs two computed nodes, false takes the next proof item.
+    // Its queue cannot pass a node up unchanged, so the flags are only
+    // usable on-chain when contractCompatible is set (always the case for
+    // power-of-two trees); verifyMultiProof handles every layout
+    std::vector<bool> proofFlags;
+    bool contractCompatible;
+};
+
+// Binary Merkle tree over digest leaves with sorted-pair hashing. An odd
+// node at the end of a level is carried up unchanged, the layout of
+// HashFusion::generateMerkleProof and of merkletreejs with sortPairs, so
+// MerkleTree<Keccak256Policy> roots and proofs verify in the contract.
+//
+// The tree is stateful: every level lives in one flat array (level k at
+// levelOffset(k), capacity >> k slots), appends rehash only the right
+// spine, and proofs are read straight out of the stored levels.
+template <typename HashPolicy>
+class MerkleTree {
+public:
+    static constexpr size_t NOT_FOUND = SIZE_MAX;
+    
+    MerkleTree();
+    explicit MerkleTree(const std::vector<Digest>& leaves);
+    
+    // O(log n); returns the new leaf's index
+    size_t append(const Digest& leaf);
+    // Rehashes each level once over the appended range
+    void append(const std::vector<Digest>& leaves);
+    
+    size_t size() const { return leafCount; }
+    const Digest& getLeaf(size_t index) const { return nodes[index]; }
+    // First index holding leaf, or NOT_FOUND
+    size_t indexOf(const Digest& leaf) const;
+    
+    // All-zero digest for an empty tree, as the frontend publishes
+    Digest getRoot() const;
+    // Sibling digests from the leaf up; empty if index is out of range
+    std::vector<Digest> getProof(size_t index) const;
+    // Deduplicated proof for a set of leaf indices; out-of-range indices
+    // are dropped and duplicates merged
+    MerkleMultiProof getMultiProof(std::vector<size_t> indices) const;
+    
+    // One-shot helpers over a leaf vector
+    static Digest computeRoot(const std::vector<Digest>& leaves);
+    static std::vector<Digest> computeProof(const std::vector<Digest>& leaves, size_t index);
+    static bool verifyProof(const Digest& leaf, const std::vector<Digest>& proof,
+                            const Digest& root);
+    // One level-by-level pass; false on any malformed or unused input
+    static bool verifyMultiProof(const MerkleMultiProof& multiProof, const Digest& root);
+    
+    // out[i] = combine(level[2i], level[2i + 1]); one batch per level
+    static void combineLevel(const Digest* level, size_t pairs, Digest* out);
+
+private:
+    std::vector<Digest> nodes;
+    size_t leafCount;
+    size_t capacity;    // power of two, leaf slots in level 0
+    std::unordered_map<Digest, size_t, DigestHash> leafIndex;
+    
+    size_t levelOffset(size_t level) const { return 2 * capacity - ((2 * capacity) >> level); }
+    void reserve(size_t leaves);
+    // Recompute every ancestor of leaves [first, leafCount)
+    void rehashFrom(size_t first);
+};
+
+#endif // MERKLE_TREE_H
@@ -3,48 +3,219 @@
 
 #include <string>
 #include <vector>
-#include <unordered_map>
-#include <memory>
+#include <map>
+#include <cstdint>
+#include "hash_fusion.h"
+#include "hash_policy.h"
 
-class TrieNode {
-public:
-    std::unordered_map<char, std::shared_ptr<TrieNode>> children;
-    std::string hash;
+// Path-compressed trie node stored in the MerkleTrie arena. Children are
+// referenced by index and kept in a sibling list sorted by edge character,
+// so a hex voter key costs one leaf node instead of one node per character.
+//
+// Hashes are identical to an uncompressed character trie: `hash` is the
+// digest of this node, `edgeHash` the digest of the implicit single-child
+// node just below the parent, which is what the parent combines.
+struct TrieNode {
+    Digest hash;
+    Digest edgeHash;
+    uint64_t labelOffset;   // incoming edge label in BasicMerkleTrie::labels
+    uint64_t valueOffset;   // value bytes in BasicMerkleTrie::values
+    uint32_t labelLength;
+    uint32_t valueLength;
+    uint32_t firstChild;
+    uint32_t nextSibling;
+    uint8_t flags;
+    
+    static constexpr uint32_t NIL = UINT32_MAX;
+    static constexpr uint8_t END_OF_WORD = 1;
+    static constexpr uint8_t DIRTY = 2;
+    
+    bool isEndOfWord() const { return flags & END_OF_WORD; }
+};
+
+// One character-level node on a proof path. Implicit nodes inside a
+// compressed edge have no value, no end marker and no siblings.
+struct TrieProofLevel {
     std::string value;
-    bool isEndOfWord;
+    bool endOfWord;
+    // Children off the path as (edge char, child hash), in char order
+    std::vector<std::pair<char, Digest>> siblings;
+};
+
+// Membership proof for key: levels[d] is the node reached after key[0..d),
+// so levels.front() is the root and levels.back() holds the key's value
+struct TrieProof {
+    std::string key;
+    std::vector<TrieProofLevel> levels;
+};
+
+// Read-only view of a trie arena: the live vectors of a BasicMerkleTrie
+// or the sections of a mapped TrieSnapshot. All lookups and proofs run on
+// a view, so both serve them through the same code.
+struct TrieView {
+    const TrieNode* nodes;
+    size_t nodeCount;
+    const char* labels;
+    size_t labelBytes;
+    const char* values;
+    size_t valueBytes;
+    uint32_t root;
+    size_t keyCount;    // UNKNOWN_SIZE makes getSize() walk the trie
     
-    TrieNode();
-    void updateHash();
+    static constexpr size_t UNKNOWN_SIZE = SIZE_MAX;
+    
+    uint32_t findChild(uint32_t node, char c) const;
+    uint32_t locate(const std::string& key) const;
+    
+    bool search(const std::string& key) const;
+    std::string getValue(const std::string& key) const;
+    const Digest& getRootDigest() const { return nodes[root].hash; }
+    std::vector<std::string> getMerkleProof(const std::string& key) const;
+    bool getTrieProof(const std::string& key, TrieProof& proof) const;
+    size_t getSize() const;
+    std::vector<std::string> getAllKeys() const;
+    // Up to limit keys starting with prefix and ordered after the cursor
+    // `after` (empty: from the first key), in byte order. Seeks past
+    // earlier subtrees instead of walking them.
+    std::vector<std::string> listKeys(const std::string& prefix, const std::string& after,
+                                      size_t limit) const;
+
+private:
+    void fillProofLevel(uint32_t node, const std::string& key, size_t depth,
+                        TrieProofLevel& level) const;
 };
 
-class MerkleTrie {
+// Merkle trie over a compile-time hash policy (see hash_policy.h); the
+// policy decides the digest function and how child digests are encoded
+// into the parent's input.
+template <typename HashPolicy>
+class BasicMerkleTrie {
 private:
-    std::shared_ptr<TrieNode> root;
-    std::string computeNodeHash(const std::shared_ptr<TrieNode>& node);
-    void updateHashesRecursive(std::shared_ptr<TrieNode> node);
+    // Node arena; nodes[root] is the root and has an empty label
+    std::vector<TrieNode> nodes;
+    std::string labels;
+    std::string values;
+    uint32_t root;
+    size_t keyCount;
+    
+    struct VersionRoot {
+        uint32_t root;
+        size_t keyCount;
+    };
+    
+    // Committed versions by number. Nodes below frozenNodes belong to at
+    // least one of them and are never modified; inserts copy them instead
+    std::map<uint64_t, VersionRoot> versionRoots;
+    uint64_t nextVersion;
+    uint32_t frozenNodes;
+    
+    // Open savepoint: sizes and root to return to, and the prior contents
+    // of every existing node modified since, in modification order
+    struct Savepoint {
+        bool active;
+        size_t nodeCount;
+        size_t labelBytes;
+        size_t valueBytes;
+        uint32_t root;
+        size_t keyCount;
+        std::vector<std::pair<uint32_t, TrieNode>> saved;
+    };
+    Savepoint undo;
+    
+    // Batches at least this large are rehashed level by level on the
+    // policy's batch hash, split into chunks across the pool
+    static constexpr size_t LEVEL_REHASH_THRESHOLD = 64;
+    static constexpr size_t LEVEL_CHUNK_SIZE = 512;
+    static constexpr size_t VERIFY_CHUNK_SIZE = 64;
+    
+    uint32_t newNode(uint64_t labelOffset, uint32_t labelLength);
+    void linkChild(uint32_t parent, uint32_t child);
+    // Path copying: a writable copy of a frozen node, or the node itself
+    uint32_t thawNode(uint32_t node);
+    // Thaw child under the writable parent, along with the frozen siblings
+    // ahead of it whose nextSibling link has to change
+    uint32_t thawChild(uint32_t parent, uint32_t child);
+    // Record node's contents before its first change under a savepoint.
+    // Nodes on an insert path are saved when still clean, so marking them
+    // dirty is what keeps a batch from saving them twice
+    void saveNode(uint32_t node);
     
+    // Structural insert; marks every node on the path dirty, no hashing
+    void insertPath(const std::string& key, const std::string& value);
+    void rehashNode(uint32_t node);
+    void rehashDirty(uint32_t node);
+    void rehashDirtyLevels();
+    void rehashLevel(const uint32_t* level, size_t count);
+
 public:
-    MerkleTrie();
+    BasicMerkleTrie();
+    // Bulk-load a voter roll; every node is hashed exactly once
+    explicit BasicMerkleTrie(const std::vector<std::pair<std::string, std::string>>& entries);
+    // Copy a snapshot's arena back into a writable trie; nothing is rehashed
+    explicit BasicMerkleTrie(const TrieView& snapshot);
+    
+    // Invalidated by the next insert
+    TrieView view() const;
+    
+    // Persistent versions: commit() freezes the current trie in O(1) and
+    // later inserts copy only the root-to-leaf paths they change, so every
+    // version shares its untouched subtrees with the next one
+    typedef uint64_t Version;
+    Version commit();
+    // False if version was never committed or has been released
+    bool view(Version version, TrieView& out) const;
+    bool releaseVersion(Version version);
+    std::vector<Version> getVersions() const;
+    // Compact the arena to the nodes reachable from the current trie and
+    // the retained versions; returns the number of nodes freed
+    size_t collectGarbage();
     
     // Core trie operations
     void insert(const std::string& key, const std::string& value);
-    bool search(const std::string& key);
-    std::string getValue(const std::string& key);
+    void insertBatch(const std::vector<std::pair<std::string, std::string>>& entries);
+    // Undo point for inserts that may have to be backed out, such as ones
+    // whose log record could not be written: rollback() restores the trie
+    // exactly as it was, release() keeps the inserts. Costs one node copy
+    // per existing node the inserts change. commit() and collectGarbage()
+    // throw while a savepoint is open.
+    void savepoint();
+    void rollback();
+    void release();
+    bool search(const std::string& key) const;
+    std::string getValue(const std::string& key) const;
     
     // Merkle operations
-    std::string getRootHash();
-    std::vector<std::string> getMerkleProof(const std::string& key);
-    bool verifyProof(const std::string& key, const std::string& value, 
-                     const std::vector<std::string>& proof, const std::string& rootHash);
+    std::string getRootHash() const;
+    // Sibling hashes only, for display; the list lacks the edge characters
+    // a verifier needs, so check proofs with getTrieProof/verifyTrieProof
+    std::vector<std::string> getMerkleProof(const std::string& key) const;
+    
+    // Structured proofs recompute the root exactly, without the trie
+    bool getTrieProof(const std::string& key, TrieProof& proof) const;
+    static bool verifyTrieProof(const TrieProof& proof, const Digest& root);
+    // results[i] = verifyTrieProof(proofs[i], root), checked across the pool
+    static std::vector<uint8_t> verifyTrieProofs(const std::vector<TrieProof>& proofs,
+                                                 const Digest& root);
     
     // Hash fusion operations
     std::string generateFusedHash(const std::string& input, const std::string& salt, uint64_t timestamp);
     std::string generateNullifierHash(const std::string& voterHash, const std::string& salt);
     
-    // Utility functions
+    // Utility functions; the counts are maintained, not walked
     void printTrie();
-    size_t getSize();
-    std::vector<std::string> getAllKeys();
+    size_t getSize() const;
+    size_t getNodeCount() const { return nodes.size(); }
+    // Arena bytes in use: nodes, labels and values
+    size_t getMemoryBytes() const;
+    std::vector<std::string> getAllKeys() const;
+    std::vector<std::string> listKeys(const std::string& prefix, const std::string& after,
+                                      size_t limit) const;
 };
 
-#endif // MERKLE_TRIE_H
\ No newline at end of file
+// The original SHA-256 trie; its roots are the ones already published
+typedef BasicMerkleTrie<Sha256HexPolicy> MerkleTrie;
+// Contract-compatible Keccak-256 trie and a BLAKE2b-256 variant
+typedef BasicMerkleTrie<Keccak256Policy> KeccakMerkleTrie;
+typedef BasicMerkleTrie<Blake2bPolicy> Blake2bMerkleTrie;
+
+#endif // MERKLE_TRIE_H
@@ -0,0 +1,104 @@
+#ifndef METRICS_H
+#define METRICS_H
+
+#include <string>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+
+// Compile with -DTRIE_METRICS=0 to turn every TRIE_METRIC_* site into a
+// no-op; Metrics itself still links and reports zeros
+#ifndef TRIE_METRICS
+#define TRIE_METRICS 1
+#endif
+
+// Process-wide counters and latency histograms for the hot paths.
+// Updates are relaxed atomics on per-thread stripes, so hashing on the
+// pool does not bounce one cache line between cores; reads sum stripes.
+class Metrics {
+public:
+    enum Counter {
+        SHA256_HASHES,
+        KECCAK256_HASHES,
+        BLAKE2B_HASHES,
+        TRIE_NODES_CREATED,
+        TRIE_BYTES_ALLOCATED,   // node, label and value bytes appended to arenas
+        COUNTER_COUNT
+    };
+    
+    enum Operation {
+        PROCESS_VOTER,
+        PROCESS_VOTER_BATCH,
+        VOTER_HASH_FUSION,
+        TRIE_INSERT,
+        TRIE_INSERT_BATCH,
+        TRIE_REHASH,
+        TRIE_PROOF,
+        TRIE_SIZE,
+        SNAPSHOT_WRITE,
+        WAL_SYNC,
+        TALLY_INGEST,
+        OPERATION_COUNT
+    };
+    
+    // Bucket i counts durations up to 2^(MIN_BUCKET_BITS + i) ns (64ns to
+    // ~0.5s); the extra last bucket is everything slower
+    static constexpr size_t BUCKETS = 24;
+    static constexpr unsigned MIN_BUCKET_BITS = 6;
+    
+    struct Histogram {
+        uint64_t count;
+        uint64_t sumNanoseconds;
+        uint64_t buckets[BUCKETS + 1];  // per bucket, not cumulative
+    };
+    
+    static constexpr bool enabled() { return TRIE_METRICS != 0; }
+    
+    static void count(Counter counter, uint64_t amount);
+    static void observe(Operation operation, uint64_t nanoseconds);
+    
+    static uint64_t counterValue(Counter counter);
+    static Histogram histogram(Operation operation);
+    static const char* counterName(Counter counter);
+    static const char* operationName(Operation operation);
+    // Upper bound of bucket i in seconds
+    static double bucketBound(size_t bucket);
+    
+    // Prometheus text exposition format, version 0.0.4
+    static std::string prometheusText();
+    static void reset();
+};
+
+// Observes the enclosing scope's duration on destruction
+class ScopedTimer {
+public:
+    explicit ScopedTimer(Metrics::Operation operation)
+        : operation(operation), start(std::chrono::steady_clock::now()) {}
+    
+    ~ScopedTimer() {
+        auto elapsed = std::chrono::steady_clock::now() - start;
+        Metrics::observe(operation,
+            std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count());
+    }
+    
+    ScopedTimer(const ScopedTimer&) = delete;
+    ScopedTimer& operator=(const ScopedTimer&) = delete;
+
+private:
+    Metrics::Operation operation;
+    std::chrono::steady_clock::time_point start;
+};
+
+#define TRIE_METRIC_CONCAT_(a, b) a##b
+#define TRIE_METRIC_CONCAT(a, b) TRIE_METRIC_CONCAT_(a, b)
+
+#if TRIE_METRICS
+#define TRIE_METRIC_COUNT(counter, amount) Metrics::count(Metrics::counter, (amount))
+#define TRIE_METRIC_TIME(operation) \
+    ScopedTimer TRIE_METRIC_CONCAT(trieMetricTimer, __LINE__)(Metrics::operation)
+#else
+#define TRIE_METRIC_COUNT(counter, amount) ((void)0)
+#define TRIE_METRIC_TIME(operation) ((void)0)
+#endif
+
+#endif // METRICS_H
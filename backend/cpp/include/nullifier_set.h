@@ -0,0 +1,93 @@
+#ifndef NULLIFIER_SET_H
+#define NULLIFIER_SET_H
+
+#include <vector>
+#include <memory>
+#include <shared_mutex>
+#include <cstddef>
+#include <cstdint>
+#include "sha256.h"
+
+// Set of spent nullifiers: an open-addressing table of digests with linear
+// probing, fronted by a blocked Bloom filter so most fresh nullifiers are
+// rejected from one small cache line without touching the table.
+//
+// Nullifiers arrive from clients who can grind them, so positions come
+// from DigestHash::keyed over all 32 bytes rather than from the raw bytes:
+// the low bits of the first word pick the table slot, its high bits the
+// Bloom block, and the second word the bits set inside it. Not
+// thread-safe; the N-API layer locks around it.
+class NullifierSet {
+public:
+    explicit NullifierSet(size_t expectedEntries = 0);
+    
+    bool contains(const Digest& nullifier) const;
+    // Adds nullifier unless present; false means it was already spent
+    bool insert(const Digest& nullifier);
+    
+    size_t size() const { return count; }
+    size_t capacity() const { return slots.size(); }
+    size_t memoryBytes() const;
+    void clear();
+
+private:
+    // Bloom blocks are one cache line; BLOOM_BITS_PER_SLOT * slots bits in all
+    static constexpr size_t BLOOM_BLOCK_WORDS = 8;
+    static constexpr size_t BLOOM_BITS_PER_SLOT = 8;
+    static constexpr size_t BLOOM_HASHES = 8;
+    // Grow past 70% occupancy
+    static constexpr size_t MAX_LOAD_PERCENT = 70;
+    static constexpr size_t MIN_SLOTS = 64;
+    
+    // All-zero digest marks an empty slot; a zero nullifier is kept aside
+    std::vector<Digest> slots;
+    std::vector<uint64_t> bloom;
+    size_t count;
+    bool hasZero;
+    
+    struct Key {
+        uint64_t words[2];
+    };
+    
+    static Key keyOf(const Digest& nullifier);
+    size_t findSlot(const Digest& nullifier, const Key& key) const;
+    bool bloomMayContain(const Key& key) const;
+    void bloomAdd(const Key& key);
+    void resize(size_t slotCount);
+};
+
+// NullifierSet split SHARDS ways by a keyed hash of the nullifier, each
+// shard behind its own lock. Batches are grouped by shard and each shard
+// is locked once, so batches from different threads dedupe concurrently
+// unless they hit the same shard at the same moment.
+class ShardedNullifierSet {
+public:
+    static constexpr size_t SHARDS = 16;
+    
+    ShardedNullifierSet();
+    
+    bool contains(const Digest& nullifier) const;
+    bool insert(const Digest& nullifier);
+    // fresh[i] is set to 1 if nullifiers[i] was added, 0 if it was already
+    // spent or came earlier in the batch
+    void insertMany(const Digest* nullifiers, size_t count, uint8_t* fresh);
+    
+    // Summed shard by shard, so only exact while no insert runs
+    size_t size() const;
+    size_t capacity() const;
+    size_t memoryBytes() const;
+    void clear();
+
+private:
+    struct Shard {
+        NullifierSet set;
+        mutable std::shared_mutex mutex;
+    };
+    
+    std::vector<std::unique_ptr<Shard>> shards;
+    
+    // Independent of the positions NullifierSet takes from DigestHash
+    static size_t shardOf(const Digest& nullifier);
+};
+
+#endif // NULLIFIER_SET_H
@@ -0,0 +1,116 @@
+#ifndef ROLL_IMPORT_H
+#define ROLL_IMPORT_H
+
+#include <atomic>
+#include <functional>
+#include <string>
+#include <utility>
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+#include "hash_fusion.h"
+
+// Layout of an electoral-roll file
+struct RollFormat {
+    enum Kind { CSV, FIXED_WIDTH };
+
+    Kind kind;
+    // CSV (RFC 4180 quoting, LF or CRLF): the voter ID is field `column`,
+    // counted from 0; the first line is skipped when hasHeader is set
+    size_t column;
+    char delimiter;
+    bool hasHeader;
+    // FIXED_WIDTH: back-to-back records of recordBytes, the voter ID being
+    // fieldBytes at fieldOffset with surrounding spaces and NULs trimmed
+    size_t recordBytes;
+    size_t fieldOffset;
+    size_t fieldBytes;
+
+    static RollFormat csv(size_t column = 0, char delimiter = ',', bool hasHeader = false);
+    static RollFormat fixedWidth(size_t recordBytes, size_t fieldOffset, size_t fieldBytes);
+};
+
+// Read-only mapping of a roll file, advised for one sequential pass.
+// Throws std::runtime_error if the file cannot be opened or mapped.
+class RollFile {
+public:
+    explicit RollFile(const std::string& path);
+    ~RollFile();
+
+    RollFile(const RollFile&) = delete;
+    RollFile& operator=(const RollFile&) = delete;
+
+    const char* data() const { return static_cast<const char*>(mapping); }
+    size_t size() const { return mappedBytes; }
+
+private:
+    void* mapping;
+    size_t mappedBytes;
+};
+
+// Counters a running import publishes; any thread may read them
+struct RollProgress {
+    std::atomic<uint64_t> bytesRead;      // through the last batch handed to the sink
+    std::atomic<uint64_t> totalBytes;
+    std::atomic<uint64_t> imported;
+    std::atomic<uint64_t> skipped;        // rows without a usable voter ID
+
+    RollProgress() : bytesRead(0), totalBytes(0), imported(0), skipped(0) {}
+};
+
+// Streams a mapped roll through three overlapping stages: a parser thread
+// cuts voter IDs out of the mapping without copying them, a hashing thread
+// fuses each batch across the pool, and the calling thread hands finished
+// batches to the sink in file order. Queues between stages hold at most
+// queueDepth batches, so memory stays bounded whatever the file size.
+class RollImporter {
+public:
+    struct Batch {
+        // (hex voter hash, voter ID) pairs for insertBatch, and the same
+        // hashes as digests, in file order
+        std::vector<std::pair<std::string, std::string>> entries;
+        std::vector<Digest> leaves;
+        size_t endOffset;   // file bytes consumed through this batch
+        size_t skipped;
+    };
+    typedef std::function<void(Batch&)> Sink;
+
+    static constexpr size_t DEFAULT_BATCH_RECORDS = 65536;
+    static constexpr size_t DEFAULT_QUEUE_DEPTH = 4;
+
+    RollImporter(const RollFile& file, const RollFormat& format,
+                 size_t batchRecords = DEFAULT_BATCH_RECORDS, size_t queueDepth = DEFAULT_QUEUE_DEPTH);
+
+    // Import the whole file, updating progress as batches reach the sink.
+    // An exception from any stage stops the others and is rethrown here;
+    // batches already sunk stay sunk.
+    void run(const FusionContext& fusion, const Sink& sink, RollProgress& progress);
+
+private:
+    // A voter ID inside the mapping; quoted CSV fields holding "" escapes
+    // are unescaped when the ID is materialized
+    struct Token {
+        const char* data;
+        uint32_t length;
+        bool escaped;
+    };
+
+    struct ParsedBatch {
+        std::vector<Token> tokens;
+        size_t endOffset;
+        size_t skipped;
+    };
+
+    const RollFile& file;
+    RollFormat format;
+    size_t batchRecords;
+    size_t queueDepth;
+
+    // Parse from offset up to batchRecords IDs into batch; returns the
+    // offset after the last record consumed
+    size_t parseCsv(size_t offset, ParsedBatch& batch) const;
+    size_t parseFixedWidth(size_t offset, ParsedBatch& batch) const;
+    static std::string materialize(const Token& token);
+};
+
+#endif // ROLL_IMPORT_H
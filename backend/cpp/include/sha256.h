@@ -0,0 +1,92 @@
+#ifndef SHA256_H
+#define SHA256_H
+
+#include <string>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+// Raw 32-byte digest; hex only appears at the N-API boundary and inside
+// the legacy hash inputs, which concatenate hex-encoded layers
+typedef std::array<uint8_t, 32> Digest;
+
+// Bucket hash for digests. Clients can grind inputs until chosen digest
+// bytes collide, so buckets come from SipHash-1-3 over all 32 bytes under
+// a key drawn at random once per process.
+struct DigestHash {
+    size_t operator()(const Digest& digest) const {
+        uint64_t h[2];
+        keyed(digest, h);
+        return static_cast<size_t>(h[0]);
+    }
+    
+    // 128-bit output, for tables that need more than one position
+    static void keyed(const Digest& digest, uint64_t out[2]);
+};
+
+// SHA-256 with kernels picked at runtime from the CPU features:
+// SHA-NI for single streams, AVX-512/AVX2 for multi-buffer batches of
+// independent messages, and a portable scalar fallback for both.
+class Sha256 {
+public:
+    enum Kernel { SCALAR, SHA_NI, AVX2, AVX512 };
+    
+    static const uint32_t INITIAL_STATE[8];
+    
+    // Compress `count` consecutive 64-byte blocks into state
+    static void compress(uint32_t state[8], const uint8_t* blocks, size_t count);
+    
+    // Hash `count` independent messages; out[i] = SHA-256(data[i])
+    static void hashMany(const uint8_t* const* data, const size_t* lengths,
+                         size_t count, Digest* out);
+    
+    static Kernel singleKernel();
+    static Kernel batchKernel();
+    static const char* kernelName(Kernel kernel);
+    
+    // Override dispatch (benchmarks); false if the CPU lacks the kernel
+    static bool setKernels(Kernel single, Kernel batch);
+};
+
+// Incremental SHA-256 over several byte ranges without concatenating them
+class Sha256Stream {
+public:
+    Sha256Stream();
+    
+    Sha256Stream& update(const void* data, size_t length);
+    Sha256Stream& update(const std::string& data);
+    Sha256Stream& update(char c);
+    // Feed the lowercase hex form of a digest, as the string APIs hash it
+    Sha256Stream& updateHex(const Digest& digest);
+    
+    Digest finish();
+
+private:
+    uint32_t state[8];
+    uint8_t buffer[64];
+    size_t bufferLength;
+    uint64_t totalLength;
+};
+
+// Hashes of messages that are a fixed number of varying 64-byte blocks
+// followed by a constant suffix. The suffix, padding and length field
+// are laid out once, so each hash only compresses: no buffering, no
+// padding. Suffixes too long to keep inline are streamed instead.
+class Sha256Tail {
+public:
+    static constexpr size_t MAX_INLINE_SUFFIX = 2 * 64 - 9;
+    
+    Sha256Tail(size_t prefixBlocks, const std::string& suffix);
+    
+    // SHA-256(prefix || suffix); prefix is prefixBlocks * 64 bytes
+    Digest hash(const uint8_t* prefix) const;
+
+private:
+    size_t prefixBlocks;
+    size_t tailBlocks;          // 0 when the suffix is streamed
+    uint8_t blocks[2 * 64];
+    std::string longSuffix;
+};
+
+#endif // SHA256_H
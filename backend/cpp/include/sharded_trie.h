@@ -0,0 +1,78 @@
+#ifndef SHARDED_TRIE_H
+#define SHARDED_TRIE_H
+
+#include <string>
+#include <vector>
+#include <memory>
+#include <shared_mutex>
+#include <cstddef>
+#include <cstdint>
+#include "merkle_trie.h"
+#include "hash_policy.h"
+
+// Membership proof in a sharded trie: the key's proof inside its shard,
+// then the shard root's siblings from the bottom of the shard-root tree
+struct ShardedTrieProof {
+    uint32_t shard;
+    Digest shardRoot;
+    TrieProof shardProof;
+    std::vector<Digest> shardPath;
+};
+
+// Registry split into 16^shardNibbles independent tries by the leading
+// hex nibbles of the key (voter hashes are hex). Each shard has its own
+// lock, so inserts into different shards run concurrently, and batches
+// are partitioned and inserted shard by shard across the pool.
+//
+// The root is a complete binary tree over the shard roots in shard order,
+// each parent hashing its children left then right, so a path only
+// verifies at the position the shard number names.
+//
+// Not persisted: there is no log or snapshot behind it yet.
+template <typename HashPolicy>
+class ShardedMerkleTrie {
+public:
+    static constexpr unsigned MAX_SHARD_NIBBLES = 3;
+    
+    // shardNibbles is clamped to [1, MAX_SHARD_NIBBLES]
+    explicit ShardedMerkleTrie(unsigned shardNibbles = 1);
+    
+    size_t shardCount() const { return shards.size(); }
+    // Hex digits select the shard; any other byte contributes its low nibble
+    size_t shardOf(const std::string& key) const;
+    
+    // Locks only the key's shard
+    void insert(const std::string& key, const std::string& value);
+    void insertBatch(const std::vector<std::pair<std::string, std::string>>& entries);
+    bool search(const std::string& key) const;
+    std::string getValue(const std::string& key) const;
+    
+    Digest getRootDigest() const;
+    std::string getRootHash() const;
+    size_t getSize() const;
+    void clear();
+    
+    // Root and proof are taken under every shard lock, so they agree;
+    // false if key is absent
+    bool getProof(const std::string& key, ShardedTrieProof& proof, Digest& root) const;
+    // Also checks that proof.shard is the key's shard in this layout
+    bool verifyProof(const ShardedTrieProof& proof, const Digest& root) const;
+
+private:
+    struct Shard {
+        BasicMerkleTrie<HashPolicy> trie;
+        mutable std::shared_mutex mutex;
+    };
+    
+    unsigned shardNibbles;
+    std::vector<std::unique_ptr<Shard>> shards;
+    
+    // Caller holds every shard lock
+    std::vector<Digest> shardRoots() const;
+    
+    static Digest combineOrdered(const Digest& left, const Digest& right);
+    static Digest rootOf(std::vector<Digest> level);
+    static std::vector<Digest> pathOf(std::vector<Digest> level, size_t index);
+};
+
+#endif // SHARDED_TRIE_H
@@ -0,0 +1,102 @@
+#ifndef SPARSE_MERKLE_TREE_H
+#define SPARSE_MERKLE_TREE_H
+
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+#include "hash_policy.h"
+
+// Compressed proof for one key: bit i of bitmap (most significant bit of
+// byte 0 first, like the key) is set when the sibling at depth i + 1 is
+// not the default node; siblings holds those, in increasing depth
+struct SparseMerkleProof {
+    Digest key;
+    bool included;
+    Digest bitmap;
+    std::vector<Digest> siblings;
+};
+
+// 256-level sparse Merkle tree over digest keys, the leaf of key k being
+// HashPolicy::hash(k) when k is present and all zeros otherwise. Inner
+// nodes hash (left, right) in order through the policy's digest encoding,
+// so Keccak256Policy nodes are keccak256(abi.encodePacked(left, right)).
+//
+// Only branch points are stored, as a binary radix tree: `hash` is the
+// subtree digest at the node's own height and `edgeHash` the digest of
+// the single-key chain just below the parent, which the parent combines.
+// Roots are identical to a full 256-level tree. Each new key still costs
+// one hash per level, paid across the pool for batches.
+//
+// Not thread-safe; the N-API layer locks around it.
+template <typename HashPolicy>
+class SparseMerkleTree {
+public:
+    static constexpr size_t DEPTH = 256;
+
+    SparseMerkleTree();
+
+    bool contains(const Digest& key) const;
+    // Adds key unless present; false means it already was
+    bool insert(const Digest& key);
+    // Adds every absent key and rehashes each changed node once;
+    // returns the number added
+    size_t insertBatch(const std::vector<Digest>& keys);
+
+    size_t size() const { return keyCount; }
+    const Digest& getRoot() const { return nodes[ROOT].hash; }
+    size_t memoryBytes() const;
+    void clear();
+
+    // Membership or non-membership proof; returns proof.included
+    bool getProof(const Digest& key, SparseMerkleProof& proof) const;
+    // getProof for every key, across the pool
+    std::vector<SparseMerkleProof> getProofs(const std::vector<Digest>& keys) const;
+    static bool verifyProof(const SparseMerkleProof& proof, const Digest& root);
+
+    // Root of an empty subtree of the given height; height 0 is the empty leaf
+    static const Digest& defaultNode(size_t height);
+    static Digest hashPair(const Digest& left, const Digest& right);
+    static Digest leafHash(const Digest& key);
+
+private:
+    struct Node {
+        Digest hash;
+        Digest edgeHash;
+        uint32_t children[2];
+        uint32_t keyIndex;      // this leaf's key, or any key below
+        uint16_t height;        // 0 for leaves, DEPTH for the root
+        uint8_t flags;
+    };
+
+    static constexpr uint32_t NIL = UINT32_MAX;
+    static constexpr uint32_t ROOT = 0;
+    static constexpr uint8_t DIRTY = 1;
+    static constexpr size_t LEAF_CHUNK_SIZE = 64;
+    static constexpr size_t PROOF_CHUNK_SIZE = 16;
+
+    std::vector<Node> nodes;
+    std::vector<Digest> keys;
+    size_t keyCount;
+
+    const Digest& keyOf(uint32_t node) const { return keys[nodes[node].keyIndex]; }
+    uint32_t newNode(uint16_t height, uint32_t keyIndex);
+    // Structural insert of an absent key; marks the path dirty, no hashing
+    void insertPath(const Digest& key);
+    // Hash the new leaves' chains across the pool, then the dirty branch
+    // points bottom-up
+    void rehashDirty();
+    // Leaf hashes and edge chains for (leaf, parent height) pairs
+    void hashLeafChains(const std::pair<uint32_t, uint16_t>* leaves, size_t count);
+    void collectDirtyLeaves(uint32_t node, std::vector<std::pair<uint32_t, uint16_t>>& leaves);
+    void rehashBranches(uint32_t node, uint16_t parentHeight);
+
+    // Digest at toHeight of the single-key chain holding digest at fromHeight
+    static Digest hashChain(Digest digest, size_t fromHeight, size_t toHeight, const Digest& key);
+};
+
+// Spent-nullifier tree. SHA-256 rides the SHA-NI and multi-buffer kernels
+// and verifies with any sha256 over the hex pairs; the Keccak tree has
+// the same interface for on-chain checks but hashes several times slower
+typedef SparseMerkleTree<Sha256HexPolicy> NullifierTree;
+
+#endif // SPARSE_MERKLE_TREE_H
@@ -0,0 +1,46 @@
+#ifndef THREAD_POOL_H
+#define THREAD_POOL_H
+
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <condition_variable>
+#include <deque>
+#include <thread>
+#include <vector>
+
+// Fixed-size worker pool used for data-parallel trie and hashing work.
+// The calling thread always takes part in parallelFor, so nested calls
+// from inside a task cannot deadlock even when every worker is busy.
+class ThreadPool {
+public:
+    explicit ThreadPool(size_t threads = 0);
+    ~ThreadPool();
+    
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+    
+    // Run task(i) for every i in [0, count) and wait for completion.
+    // The first exception thrown by a task is rethrown here.
+    void parallelFor(size_t count, const std::function<void(size_t)>& task);
+    
+    size_t size() const { return workers.size() + 1; }
+    
+    // Process-wide pool sized to the hardware concurrency
+    static ThreadPool& shared();
+
+private:
+    struct Batch;
+    
+    void workerLoop();
+    static void runBatch(Batch& batch);
+    
+    std::vector<std::thread> workers;
+    std::deque<std::shared_ptr<Batch>> pending;
+    std::mutex mutex;
+    std::condition_variable wake;
+    bool stopping;
+};
+
+#endif // THREAD_POOL_H
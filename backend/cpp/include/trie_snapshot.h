@@ -0,0 +1,75 @@
+#ifndef TRIE_SNAPSHOT_H
+#define TRIE_SNAPSHOT_H
+
+#include <string>
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+#include "merkle_trie.h"
+
+// Snapshot file, version 2, every section 64-byte aligned:
+//
+//   SnapshotHeader | TrieNode[nodeCount] | labels | values | Digest[leafCount]
+//
+// Nodes refer to each other and to the byte sections by index and offset
+// only, so the file is position independent and is used in place once
+// mapped. The optional leaves section carries an ordered digest list
+// (the voter list tree) alongside the trie.
+struct SnapshotHeader {
+    char magic[8];          // "MTRIESNP"
+    uint32_t version;
+    uint32_t byteOrder;     // BYTE_ORDER_MARK as the writer stored it
+    uint32_t nodeSize;      // sizeof(TrieNode) of the writer
+    uint32_t root;
+    char hashPolicy[16];    // HashPolicy::name(), NUL padded
+    uint64_t nodeCount;
+    uint64_t labelBytes;
+    uint64_t valueBytes;
+    uint64_t leafCount;
+    uint64_t keyCount;      // keys reachable from root; other nodes may be old versions
+    uint64_t nodesOffset;
+    uint64_t labelsOffset;
+    uint64_t valuesOffset;
+    uint64_t leavesOffset;
+    Digest rootHash;
+};
+
+// Read-only memory-mapped snapshot. Lookups and proofs run directly on
+// the mapping through view(); BasicMerkleTrie(snapshot.view()) copies it
+// back into a writable trie.
+class TrieSnapshot {
+public:
+    static constexpr uint32_t VERSION = 2;
+    static constexpr uint32_t BYTE_ORDER_MARK = 0x01020304;
+    
+    // Write to a temporary file, fsync it and rename it over path, so
+    // readers see either the old snapshot or the complete new one.
+    // Throws std::runtime_error on I/O failure.
+    static void write(const std::string& path, const TrieView& trie, const char* hashPolicy,
+                      const std::vector<Digest>& leaves = std::vector<Digest>());
+    
+    // Map and validate path; throws std::runtime_error if it is not a
+    // well-formed snapshot for this build
+    explicit TrieSnapshot(const std::string& path);
+    ~TrieSnapshot();
+    
+    TrieSnapshot(const TrieSnapshot&) = delete;
+    TrieSnapshot& operator=(const TrieSnapshot&) = delete;
+    
+    const TrieView& view() const { return trieView; }
+    std::string hashPolicy() const;
+    const Digest* leaves() const { return leafData; }
+    size_t leafCount() const { return leafTotal; }
+    size_t fileSize() const { return mappedBytes; }
+
+private:
+    void* mapping;
+    size_t mappedBytes;
+    TrieView trieView;
+    const Digest* leafData;
+    size_t leafTotal;
+    
+    void validate(const std::string& path) const;
+};
+
+#endif // TRIE_SNAPSHOT_H
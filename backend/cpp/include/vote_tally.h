@@ -0,0 +1,97 @@
+#ifndef VOTE_TALLY_H
+#define VOTE_TALLY_H
+
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+#include "nullifier_set.h"
+
+// Per-candidate vote counters for live results. Counts sit in STRIPES
+// rows of relaxed atomics, each row starting on its own cache line and
+// written by the threads hashed to it, so counting on the pool does not
+// bounce lines between cores; reads merge the rows lazily.
+//
+// Every change takes the next sequence number and stamps the candidates
+// it touched, so delta(since) returns just the totals that changed after
+// a sequence the reader has already seen. Sequences never go backwards,
+// and reset() stamps every candidate so stale readers resync in full.
+class VoteTally {
+public:
+    // Packed vote record: the 32-byte nullifier, then the candidate index
+    // as a little-endian uint32
+    static constexpr size_t RECORD_BYTES = sizeof(Digest) + 4;
+    static constexpr size_t MAX_CANDIDATES = 65536;
+
+    enum VoteStatus : uint8_t {
+        ACCEPTED,
+        DUPLICATE,          // nullifier already spent
+        UNKNOWN_CANDIDATE   // nullifier left unspent
+    };
+
+    struct IngestResult {
+        size_t accepted;
+        size_t duplicates;
+        size_t invalid;
+        uint64_t sequence;      // after this ingest
+    };
+
+    struct Totals {
+        uint64_t sequence;
+        uint64_t totalVotes;                // every candidate combined
+        std::vector<uint32_t> candidates;   // ascending
+        std::vector<uint64_t> counts;       // counts[i] is for candidates[i]
+    };
+
+    explicit VoteTally(size_t candidateCount = 0);
+
+    // Zero every count and switch to candidateCount candidates
+    void reset(size_t candidateCount);
+    size_t candidateCount() const { return candidates; }
+    uint64_t sequence() const { return sequenceNumber.load(std::memory_order_acquire); }
+
+    // Count every record with a known candidate whose nullifier spent did
+    // not hold yet, adding the nullifier. status, when given, receives one
+    // VoteStatus per record. The caller must own spent exclusively
+    IngestResult ingest(const uint8_t* records, size_t count, NullifierSet& spent, uint8_t* status);
+    // The same against a sharded set, which locks itself shard by shard,
+    // so ingests from several threads may run at once
+    IngestResult ingest(const uint8_t* records, size_t count, ShardedNullifierSet& spent, uint8_t* status);
+
+    // Every candidate's total
+    Totals snapshot() const;
+    // Totals of the candidates changed after sequence `since`
+    Totals delta(uint64_t since) const;
+
+    // snapshot, delta and sequence may run alongside ingests; reset must
+    // not overlap anything
+
+private:
+    static constexpr size_t STRIPES = 16;
+    static constexpr size_t WORDS_PER_LINE = 8;
+    static constexpr size_t COUNT_CHUNK_SIZE = 1 << 16;
+
+    struct alignas(64) Line {
+        std::atomic<uint64_t> words[WORDS_PER_LINE];
+    };
+
+    size_t candidates;
+    size_t lineCount;                       // lines per stripe
+    std::unique_ptr<Line[]> lines;          // STRIPES * lineCount
+    std::unique_ptr<std::atomic<uint64_t>[]> changedAt;
+    std::atomic<uint64_t> votesCounted;
+    std::atomic<uint64_t> sequenceNumber;
+    std::mutex stampMutex;                  // orders concurrent ingests' stamps
+
+    std::atomic<uint64_t>& counter(size_t stripe, uint32_t candidate) const;
+    uint64_t merged(uint32_t candidate) const;
+    void count(const uint32_t* votes, size_t count);
+    // spend(nullifiers, n, fresh) marks which of n nullifiers were unspent
+    template <typename Spend>
+    IngestResult ingestWith(const uint8_t* records, size_t count, uint8_t* status, Spend spend);
+    Totals collect(uint64_t since) const;
+};
+
+#endif // VOTE_TALLY_H
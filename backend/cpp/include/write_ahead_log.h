@@ -0,0 +1,76 @@
+#ifndef WRITE_AHEAD_LOG_H
+#define WRITE_AHEAD_LOG_H
+
+#include <string>
+#include <vector>
+#include <functional>
+#include <mutex>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include "sha256.h"
+
+// Append-only log of trie inserts since the last snapshot. Each record
+// holds one insert or batch and the root hash after applying it:
+//
+//   header:  "MTRIEWAL" | version | reserved | base root
+//   record:  payload length | CRC-32 | sequence | count | root
+//            | (key length, value length, key, value) * count
+//
+// append() only writes into the page cache; sync() makes records durable
+// and lets one fsync cover every caller waiting at the time (group commit).
+//
+// A write that fails partway is cut back off the file, so the next record
+// never lands behind torn bytes. If that truncation fails, or an fsync
+// fails (the kernel may already have dropped the dirty pages), the log is
+// marked failed and every later append() and sync() throws until reset().
+class WriteAheadLog {
+public:
+    typedef std::vector<std::pair<std::string, std::string>> Entries;
+    // Called for each intact record in order; throw to abort recovery
+    typedef std::function<void(const Entries& entries, const Digest& root)> ReplayFn;
+    
+    static constexpr uint32_t VERSION = 1;
+    
+    // Open or create the log for a trie whose current root is baseRoot,
+    // replaying its records first. A torn tail from a crash is cut off; a
+    // log already folded into the snapshot (its last root is baseRoot) is
+    // restarted empty. Throws std::runtime_error if the log belongs to a
+    // different base or cannot be opened.
+    WriteAheadLog(const std::string& path, const Digest& baseRoot, const ReplayFn& replay);
+    ~WriteAheadLog();
+    
+    WriteAheadLog(const WriteAheadLog&) = delete;
+    WriteAheadLog& operator=(const WriteAheadLog&) = delete;
+    
+    // Returns the record's sequence number for sync(). Throws
+    // std::runtime_error, leaving no trace of the record, if it cannot be
+    // written
+    uint64_t append(const Entries& entries, const Digest& root);
+    // Block until every record up to sequence is on disk
+    void sync(uint64_t sequence);
+    // Checkpoint: start an empty log on top of a new snapshot; clears a
+    // failure once the fresh log is on disk
+    void reset(const Digest& baseRoot);
+    
+    size_t recordCount() const;
+    bool failed() const;
+
+private:
+    std::string path;
+    int fd;
+    
+    mutable std::mutex mutex;
+    std::condition_variable synced;
+    uint64_t nextSequence;      // next record to append
+    uint64_t durableSequence;   // every record below this is on disk
+    bool syncing;
+    size_t records;
+    size_t length;              // bytes of intact header and records
+    std::string failure;        // why the log stopped; empty while healthy
+    
+    void writeHeader(const Digest& baseRoot);
+    void checkHealthy() const;
+};
+
+#endif // WRITE_AHEAD_LOG_H
@@ -0,0 +1,138 @@
+#include "include/keccak.h"
+#include "include/metrics.h"
+#include <cstring>
+
+static const uint64_t ROUND_CONSTANTS[24] = {
+    0x0000000000000001ULL, 0x0000000000008082ULL, 0x800000000000808aULL, 0x8000000080008000ULL,
+    0x000000000000808bULL, 0x0000000080000001ULL, 0x8000000080008081ULL, 0x8000000000008009ULL,
+    0x000000000000008aULL, 0x0000000000000088ULL, 0x0000000080008009ULL, 0x000000008000000aULL,
+    0x000000008000808bULL, 0x800000000000008bULL, 0x8000000000008089ULL, 0x8000000000008003ULL,
+    0x8000000000008002ULL, 0x8000000000000080ULL, 0x000000000000800aULL, 0x800000008000000aULL,
+    0x8000000080008081ULL, 0x8000000000008080ULL, 0x0000000080000001ULL, 0x8000000080008008ULL
+};
+
+static inline uint64_t rotl(uint64_t x, int n) {
+    return (x << n) | (x >> (64 - n));
+}
+
+static inline uint64_t loadLittleEndian(const uint8_t* p) {
+    uint64_t v = 0;
+    for (int i = 7; i >= 0; i--) {
+        v = (v << 8) | p[i];
+    }
+    return v;
+}
+
+// Keccak-f[1600]; lane (x, y) is a[x + 5y]. Theta, rho and pi are fused
+// into one pass per round with the rotation offsets written out
+void Keccak256Stream::permute(uint64_t a[25]) {
+    uint64_t b[25];
+    
+    for (int round = 0; round < 24; round++) {
+        uint64_t c0 = a[0] ^ a[5] ^ a[10] ^ a[15] ^ a[20];
+        uint64_t c1 = a[1] ^ a[6] ^ a[11] ^ a[16] ^ a[21];
+        uint64_t c2 = a[2] ^ a[7] ^ a[12] ^ a[17] ^ a[22];
+        uint64_t c3 = a[3] ^ a[8] ^ a[13] ^ a[18] ^ a[23];
+        uint64_t c4 = a[4] ^ a[9] ^ a[14] ^ a[19] ^ a[24];
+        uint64_t d0 = c4 ^ rotl(c1, 1);
+        uint64_t d1 = c0 ^ rotl(c2, 1);
+        uint64_t d2 = c1 ^ rotl(c3, 1);
+        uint64_t d3 = c2 ^ rotl(c4, 1);
+        uint64_t d4 = c3 ^ rotl(c0, 1);
+        
+        b[0] = a[0] ^ d0;
+        b[1] = rotl(a[6] ^ d1, 44);
+        b[2] = rotl(a[12] ^ d2, 43);
+        b[3] = rotl(a[18] ^ d3, 21);
+        b[4] = rotl(a[24] ^ d4, 14);
+        b[5] = rotl(a[3] ^ d3, 28);
+        b[6] = rotl(a[9] ^ d4, 20);
+        b[7] = rotl(a[10] ^ d0, 3);
+        b[8] = rotl(a[16] ^ d1, 45);
+        b[9] = rotl(a[22] ^ d2, 61);
+        b[10] = rotl(a[1] ^ d1, 1);
+        b[11] = rotl(a[7] ^ d2, 6);
+        b[12] = rotl(a[13] ^ d3, 25);
+        b[13] = rotl(a[19] ^ d4, 8);
+        b[14] = rotl(a[20] ^ d0, 18);
+        b[15] = rotl(a[4] ^ d4, 27);
+        b[16] = rotl(a[5] ^ d0, 36);
+        b[17] = rotl(a[11] ^ d1, 10);
+        b[18] = rotl(a[17] ^ d2, 15);
+        b[19] = rotl(a[23] ^ d3, 56);
+        b[20] = rotl(a[2] ^ d2, 62);
+        b[21] = rotl(a[8] ^ d3, 55);
+        b[22] = rotl(a[14] ^ d4, 39);
+        b[23] = rotl(a[15] ^ d0, 41);
+        b[24] = rotl(a[21] ^ d1, 2);
+        
+        // Chi row by row, then iota
+        for (int y = 0; y < 25; y += 5) {
+            a[y] = b[y] ^ (~b[y + 1] & b[y + 2]);
+            a[y + 1] = b[y + 1] ^ (~b[y + 2] & b[y + 3]);
+            a[y + 2] = b[y + 2] ^ (~b[y + 3] & b[y + 4]);
+            a[y + 3] = b[y + 3] ^ (~b[y + 4] & b[y]);
+            a[y + 4] = b[y + 4] ^ (~b[y] & b[y + 1]);
+        }
+        a[0] ^= ROUND_CONSTANTS[round];
+    }
+}
+
+Keccak256Stream::Keccak256Stream() : position(0) {
+    std::memset(state, 0, sizeof(state));
+}
+
+Keccak256Stream& Keccak256Stream::update(const void* data, size_t length) {
+    const uint8_t* bytes = static_cast<const uint8_t*>(data);
+    
+    // Finish a partially absorbed block byte by byte
+    while (length > 0 && (position != 0 || length < RATE)) {
+        state[position / 8] ^= uint64_t(*bytes++) << (8 * (position % 8));
+        length--;
+        if (++position == RATE) {
+            permute(state);
+            position = 0;
+        }
+    }
+    
+    // Whole blocks are absorbed a lane at a time
+    for (; length >= RATE; length -= RATE, bytes += RATE) {
+        for (size_t i = 0; i < RATE / 8; i++) {
+            state[i] ^= loadLittleEndian(bytes + 8 * i);
+        }
+        permute(state);
+    }
+    
+    for (; length > 0; length--) {
+        state[position / 8] ^= uint64_t(*bytes++) << (8 * (position % 8));
+        position++;
+    }
+    return *this;
+}
+
+Keccak256Stream& Keccak256Stream::update(const std::string& data) {
+    return update(data.data(), data.size());
+}
+
+Keccak256Stream& Keccak256Stream::update(char c) {
+    return update(&c, 1);
+}
+
+Digest Keccak256Stream::finish() {
+    TRIE_METRIC_COUNT(KECCAK256_HASHES, 1);
+    // Keccak multi-rate padding; both bits land in one byte when only a
+    // single byte of the block is left
+    state[position / 8] ^= uint64_t(0x01) << (8 * (position % 8));
+    state[(RATE - 1) / 8] ^= uint64_t(0x80) << (8 * ((RATE - 1) % 8));
+    permute(state);
+    
+    Digest digest;
+    for (size_t i = 0; i < digest.size(); i++) {
+        digest[i] = static_cast<uint8_t>(state[i / 8] >> (8 * (i % 8)));
+    }
+    return digest;
+}
+
+Digest Keccak256Stream::hash(const void* data, size_t length) {
+    return Keccak256Stream().update(data, length).finish();
+}
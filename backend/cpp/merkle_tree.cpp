@@ -0,0 +1,309 @@
+#include "include/merkle_tree.h"
+#include <algorithm>
+#include <string>
+
+template <typename HashPolicy>
+MerkleTree<HashPolicy>::MerkleTree() : leafCount(0), capacity(0) {}
+
+template <typename HashPolicy>
+MerkleTree<HashPolicy>::MerkleTree(const std::vector<Digest>& leaves) : leafCount(0), capacity(0) {
+    append(leaves);
+}
+
+template <typename HashPolicy>
+void MerkleTree<HashPolicy>::reserve(size_t leaves) {
+    if (leaves <= capacity) return;
+    
+    size_t newCapacity = capacity ? capacity : 1;
+    while (newCapacity < leaves) {
+        newCapacity *= 2;
+    }
+    
+    // Move each level's filled prefix to its slot in the wider layout;
+    // doubling keeps the copying amortized O(1) per leaf
+    std::vector<Digest> wider(2 * newCapacity - 1);
+    size_t oldCapacity = capacity;
+    size_t size = leafCount;
+    for (size_t level = 0; size > 0; level++) {
+        size_t from = 2 * oldCapacity - ((2 * oldCapacity) >> level);
+        size_t to = 2 * newCapacity - ((2 * newCapacity) >> level);
+        std::copy(nodes.begin() + from, nodes.begin() + from + size, wider.begin() + to);
+        if (size == 1) break;
+        size = (size + 1) / 2;
+    }
+    
+    nodes.swap(wider);
+    capacity = newCapacity;
+}
+
+template <typename HashPolicy>
+void MerkleTree<HashPolicy>::rehashFrom(size_t first) {
+    size_t size = leafCount;
+    for (size_t level = 0; size > 1; level++) {
+        Digest* current = &nodes[levelOffset(level)];
+        Digest* parent = &nodes[levelOffset(level + 1)];
+        size_t parentFirst = first / 2;
+        
+        combineLevel(current + 2 * parentFirst, size / 2 - parentFirst, parent + parentFirst);
+        
+        // Odd number of elements, carry forward
+        if (size % 2 == 1) {
+            parent[size / 2] = current[size - 1];
+        }
+        
+        first = parentFirst;
+        size = (size + 1) / 2;
+    }
+}
+
+template <typename HashPolicy>
+size_t MerkleTree<HashPolicy>::append(const Digest& leaf) {
+    reserve(leafCount + 1);
+    size_t index = leafCount++;
+    nodes[index] = leaf;
+    leafIndex.emplace(leaf, index);
+    
+    rehashFrom(index);
+    return index;
+}
+
+template <typename HashPolicy>
+void MerkleTree<HashPolicy>::append(const std::vector<Digest>& leaves) {
+    if (leaves.empty()) return;
+    
+    reserve(leafCount + leaves.size());
+    size_t first = leafCount;
+    for (const auto& leaf : leaves) {
+        nodes[leafCount] = leaf;
+        leafIndex.emplace(leaf, leafCount);
+        leafCount++;
+    }
+    
+    rehashFrom(first);
+}
+
+template <typename HashPolicy>
+size_t MerkleTree<HashPolicy>::indexOf(const Digest& leaf) const {
+    auto it = leafIndex.find(leaf);
+    return it == leafIndex.end() ? NOT_FOUND : it->second;
+}
+
+template <typename HashPolicy>
+Digest MerkleTree<HashPolicy>::getRoot() const {
+    if (leafCount == 0) {
+        return Digest();
+    }
+    
+    size_t level = 0;
+    for (size_t size = leafCount; size > 1; size = (size + 1) / 2) {
+        level++;
+    }
+    return nodes[levelOffset(level)];
+}
+
+template <typename HashPolicy>
+std::vector<Digest> MerkleTree<HashPolicy>::getProof(size_t index) const {
+    std::vector<Digest> proof;
+    if (index >= leafCount) {
+        return proof;
+    }
+    
+    size_t size = leafCount;
+    for (size_t level = 0; size > 1; level++) {
+        size_t sibling = index ^ 1;
+        if (sibling < size) {
+            proof.push_back(nodes[levelOffset(level) + sibling]);
+        }
+        index /= 2;
+        size = (size + 1) / 2;
+    }
+    
+    return proof;
+}
+
+// Port of OpenZeppelin's processMultiProof queue, used to tell whether
+// the generated flags reproduce the root on-chain
+template <typename HashPolicy>
+static bool processMultiProofFlags(const MerkleMultiProof& multiProof, const Digest& root) {
+    size_t leavesLength = multiProof.leaves.size();
+    size_t proofLength = multiProof.proof.size();
+    size_t totalHashes = multiProof.proofFlags.size();
+    if (leavesLength + proofLength != totalHashes + 1) {
+        return false;
+    }
+    if (totalHashes == 0) {
+        return (leavesLength > 0 ? multiProof.leaves[0] : multiProof.proof[0]) == root;
+    }
+    
+    std::vector<Digest> hashes(totalHashes);
+    size_t leafPos = 0, hashPos = 0, proofPos = 0;
+    auto next = [&]() -> const Digest& {
+        return leafPos < leavesLength ? multiProof.leaves[leafPos++] : hashes[hashPos++];
+    };
+    
+    for (size_t i = 0; i < totalHashes; i++) {
+        const Digest& a = next();
+        if (!multiProof.proofFlags[i] && proofPos >= proofLength) {
+            return false;
+        }
+        const Digest& b = multiProof.proofFlags[i] ? next() : multiProof.proof[proofPos++];
+        hashes[i] = HashPolicy::combine(a, b);
+    }
+    
+    return proofPos == proofLength && hashes[totalHashes - 1] == root;
+}
+
+template <typename HashPolicy>
+MerkleMultiProof MerkleTree<HashPolicy>::getMultiProof(std::vector<size_t> indices) const {
+    MerkleMultiProof multiProof;
+    multiProof.leafCount = leafCount;
+    multiProof.contractCompatible = false;
+    
+    std::sort(indices.begin(), indices.end());
+    indices.erase(std::unique(indices.begin(), indices.end()), indices.end());
+    indices.erase(std::lower_bound(indices.begin(), indices.end(), leafCount), indices.end());
+    if (indices.empty()) {
+        return multiProof;
+    }
+    
+    multiProof.indices = indices;
+    for (size_t index : indices) {
+        multiProof.leaves.push_back(nodes[index]);
+    }
+    
+    // Walk the known nodes up level by level, in the same order
+    // verifyMultiProof consumes them
+    std::vector<size_t> known = indices;
+    size_t size = leafCount;
+    for (size_t level = 0; size > 1; level++) {
+        const Digest* current = &nodes[levelOffset(level)];
+        std::vector<size_t> parents;
+        
+        for (size_t j = 0; j < known.size(); j++) {
+            size_t index = known[j];
+            size_t sibling = index ^ 1;
+            
+            // A node without a sibling is carried forward without a hash
+            if (sibling < size) {
+                bool siblingKnown = j + 1 < known.size() && known[j + 1] == sibling;
+                multiProof.proofFlags.push_back(siblingKnown);
+                if (siblingKnown) {
+                    j++;
+                } else {
+                    multiProof.proof.push_back(current[sibling]);
+                }
+            }
+            parents.push_back(index / 2);
+        }
+        
+        known.swap(parents);
+        size = (size + 1) / 2;
+    }
+    
+    multiProof.contractCompatible = processMultiProofFlags<HashPolicy>(multiProof, getRoot());
+    return multiProof;
+}
+
+template <typename HashPolicy>
+bool MerkleTree<HashPolicy>::verifyMultiProof(const MerkleMultiProof& multiProof,
+                                              const Digest& root) {
+    const std::vector<size_t>& indices = multiProof.indices;
+    if (indices.empty() || indices.size() != multiProof.leaves.size()) {
+        return false;
+    }
+    for (size_t i = 0; i < indices.size(); i++) {
+        if (indices[i] >= multiProof.leafCount || (i > 0 && indices[i] <= indices[i - 1])) {
+            return false;
+        }
+    }
+    
+    std::vector<std::pair<size_t, Digest>> known(indices.size());
+    for (size_t i = 0; i < indices.size(); i++) {
+        known[i] = std::make_pair(indices[i], multiProof.leaves[i]);
+    }
+    
+    size_t proofPos = 0;
+    size_t size = multiProof.leafCount;
+    while (size > 1) {
+        std::vector<std::pair<size_t, Digest>> parents;
+        parents.reserve(known.size());
+        
+        for (size_t j = 0; j < known.size(); j++) {
+            size_t index = known[j].first;
+            size_t sibling = index ^ 1;
+            
+            if (sibling >= size) {
+                parents.emplace_back(index / 2, known[j].second);
+            } else if (j + 1 < known.size() && known[j + 1].first == sibling) {
+                parents.emplace_back(index / 2, HashPolicy::combine(known[j].second, known[j + 1].second));
+                j++;
+            } else {
+                if (proofPos >= multiProof.proof.size()) {
+                    return false;
+                }
+                parents.emplace_back(index / 2,
+                                     HashPolicy::combine(known[j].second, multiProof.proof[proofPos++]));
+            }
+        }
+        
+        known.swap(parents);
+        size = (size + 1) / 2;
+    }
+    
+    return proofPos == multiProof.proof.size() && known[0].second == root;
+}
+
+template <typename HashPolicy>
+void MerkleTree<HashPolicy>::combineLevel(const Digest* level, size_t pairs, Digest* out) {
+    // Single pairs (spine updates after one append) skip the batch setup
+    if (pairs == 1) {
+        out[0] = HashPolicy::combine(level[0], level[1]);
+        return;
+    }
+    if (pairs == 0) return;
+    
+    // Sorted pairs laid out back to back for HashPolicy::hashMany
+    const size_t encoded = HashPolicy::ENCODED_DIGEST_SIZE;
+    std::string buffer(pairs * 2 * encoded, '\0');
+    std::vector<const uint8_t*> data(pairs);
+    std::vector<size_t> lengths(pairs, 2 * encoded);
+    
+    for (size_t i = 0; i < pairs; i++) {
+        const Digest& left = level[2 * i];
+        const Digest& right = level[2 * i + 1];
+        bool leftFirst = left < right;
+        char* pair = &buffer[i * 2 * encoded];
+        HashPolicy::encodeDigest(leftFirst ? left : right, pair);
+        HashPolicy::encodeDigest(leftFirst ? right : left, pair + encoded);
+        data[i] = reinterpret_cast<const uint8_t*>(pair);
+    }
+    
+    HashPolicy::hashMany(data.data(), lengths.data(), pairs, out);
+}
+
+template <typename HashPolicy>
+Digest MerkleTree<HashPolicy>::computeRoot(const std::vector<Digest>& leaves) {
+    return MerkleTree(leaves).getRoot();
+}
+
+template <typename HashPolicy>
+std::vector<Digest> MerkleTree<HashPolicy>::computeProof(const std::vector<Digest>& leaves,
+                                                         size_t index) {
+    return MerkleTree(leaves).getProof(index);
+}
+
+template <typename HashPolicy>
+bool MerkleTree<HashPolicy>::verifyProof(const Digest& leaf, const std::vector<Digest>& proof,
+                                         const Digest& root) {
+    // Sorted pairs make the proof position-free, as in the contract
+    Digest computed = leaf;
+    for (const auto& sibling : proof) {
+        computed = HashPolicy::combine(computed, sibling);
+    }
+    
+    return computed == root;
+}
+
+template class MerkleTree<Sha256HexPolicy>;
+template class MerkleTree<Keccak256Policy>;
+template class MerkleTree<Blake2bPolicy>;
@@ -1,187 +1,954 @@
 #include "include/merkle_trie.h"
 #include "include/hash_fusion.h"
+#include "include/thread_pool.h"
+#include "include/metrics.h"
 #include <iostream>
 #include <sstream>
 #include <algorithm>
-#include <queue>
+#include <functional>
+#include <stdexcept>
 
-// TrieNode Implementation
-TrieNode::TrieNode() : isEndOfWord(false) {
-    updateHash();
+// TrieView Implementation
+uint32_t TrieView::findChild(uint32_t node, char c) const {
+    // Siblings are sorted by leading edge character (as unsigned char)
+    uint8_t target = static_cast<uint8_t>(c);
+    for (uint32_t child = nodes[node].firstChild; child != TrieNode::NIL;
+         child = nodes[child].nextSibling) {
+        uint8_t lead = static_cast<uint8_t>(labels[nodes[child].labelOffset]);
+        if (lead == target) return child;
+        if (lead > target) break;
+    }
+    return TrieNode::NIL;
 }
 
-void TrieNode::updateHash() {
-    std::string combined = value;
+uint32_t TrieView::locate(const std::string& key) const {
+    uint32_t current = root;
+    size_t pos = 0;
     
-    // Combine all children hashes in sorted order for consistency
-    std::vector<std::string> childHashes;
-    for (const auto& child : children) {
-        childHashes.push_back(child.first + child.second->hash);
+    while (pos < key.size()) {
+        uint32_t child = findChild(current, key[pos]);
+        if (child == TrieNode::NIL) {
+            return TrieNode::NIL;
+        }
+        
+        const TrieNode& node = nodes[child];
+        if (key.size() - pos < node.labelLength ||
+            key.compare(pos, node.labelLength, labels + node.labelOffset, node.labelLength) != 0) {
+            return TrieNode::NIL;
+        }
+        
+        current = child;
+        pos += node.labelLength;
     }
     
-    std::sort(childHashes.begin(), childHashes.end());
-    for (const auto& childHash : childHashes) {
-        combined += childHash;
+    return current;
+}
+
+bool TrieView::search(const std::string& key) const {
+    uint32_t node = locate(key);
+    return node != TrieNode::NIL && nodes[node].isEndOfWord();
+}
+
+std::string TrieView::getValue(const std::string& key) const {
+    uint32_t node = locate(key);
+    if (node == TrieNode::NIL || !nodes[node].isEndOfWord()) {
+        return "";
     }
     
-    if (isEndOfWord) {
-        combined += "END";
+    return std::string(values + nodes[node].valueOffset, nodes[node].valueLength);
+}
+
+std::vector<std::string> TrieView::getMerkleProof(const std::string& key) const {
+    TRIE_METRIC_TIME(TRIE_PROOF);
+    std::vector<std::string> proof;
+    uint32_t current = root;
+    size_t pos = 0;
+    
+    while (pos < key.size()) {
+        char c = key[pos];
+        uint32_t next = findChild(current, c);
+        if (next == TrieNode::NIL) {
+            return proof; // Partial proof if key not found
+        }
+        
+        // Add sibling hashes to proof
+        for (uint32_t child = nodes[current].firstChild; child != TrieNode::NIL;
+             child = nodes[child].nextSibling) {
+            if (child != next) {
+                proof.push_back(HashFusion::toHex(nodes[child].edgeHash));
+            }
+        }
+        
+        // Implicit nodes inside a compressed edge have no siblings
+        const TrieNode& node = nodes[next];
+        if (key.size() - pos < node.labelLength ||
+            key.compare(pos, node.labelLength, labels + node.labelOffset, node.labelLength) != 0) {
+            return proof;
+        }
+        
+        current = next;
+        pos += node.labelLength;
     }
     
-    hash = HashFusion::sha256(combined);
+    return proof;
 }
 
-// MerkleTrie Implementation
-MerkleTrie::MerkleTrie() {
-    root = std::make_shared<TrieNode>();
+void TrieView::fillProofLevel(uint32_t index, const std::string& key,
+                              size_t depth, TrieProofLevel& level) const {
+    const TrieNode& node = nodes[index];
+    level.value.assign(values + node.valueOffset, node.valueLength);
+    level.endOfWord = node.isEndOfWord();
+    
+    for (uint32_t child = node.firstChild; child != TrieNode::NIL;
+         child = nodes[child].nextSibling) {
+        char lead = labels[nodes[child].labelOffset];
+        if (depth < key.size() && lead == key[depth]) {
+            continue;
+        }
+        level.siblings.emplace_back(lead, nodes[child].edgeHash);
+    }
+}
+
+bool TrieView::getTrieProof(const std::string& key, TrieProof& proof) const {
+    TRIE_METRIC_TIME(TRIE_PROOF);
+    if (!search(key)) {
+        return false;
+    }
+    
+    proof.key = key;
+    proof.levels.assign(key.size() + 1, TrieProofLevel{std::string(), false, {}});
+    
+    uint32_t current = root;
+    size_t pos = 0;
+    fillProofLevel(current, key, pos, proof.levels[pos]);
+    
+    // Levels inside a compressed edge stay empty
+    while (pos < key.size()) {
+        current = findChild(current, key[pos]);
+        pos += nodes[current].labelLength;
+        fillProofLevel(current, key, pos, proof.levels[pos]);
+    }
+    
+    return true;
 }
 
-void MerkleTrie::insert(const std::string& key, const std::string& value) {
-    auto current = root;
+size_t TrieView::getSize() const {
+    TRIE_METRIC_TIME(TRIE_SIZE);
+    if (keyCount != UNKNOWN_SIZE) {
+        return keyCount;
+    }
     
-    for (char c : key) {
-        if (current->children.find(c) == current->children.end()) {
-            current->children[c] = std::make_shared<TrieNode>();
+    // The arena may hold nodes of other versions, so only walk what is
+    // reachable from this root
+    size_t count = 0;
+    std::vector<uint32_t> stack(1, root);
+    while (!stack.empty()) {
+        const TrieNode& node = nodes[stack.back()];
+        stack.pop_back();
+        if (node.isEndOfWord()) {
+            count++;
+        }
+        for (uint32_t child = node.firstChild; child != TrieNode::NIL;
+             child = nodes[child].nextSibling) {
+            stack.push_back(child);
         }
-        current = current->children[c];
     }
     
-    current->isEndOfWord = true;
-    current->value = value;
+    return count;
+}
+
+std::vector<std::string> TrieView::getAllKeys() const {
+    std::vector<std::string> keys;
+    std::string currentKey = "";
+    
+    std::function<void(uint32_t)> dfs = [&](uint32_t index) {
+        const TrieNode& node = nodes[index];
+        currentKey.append(labels + node.labelOffset, node.labelLength);
+        
+        if (node.isEndOfWord()) {
+            keys.push_back(currentKey);
+        }
+        
+        for (uint32_t child = node.firstChild; child != TrieNode::NIL;
+             child = nodes[child].nextSibling) {
+            dfs(child);
+        }
+        
+        currentKey.resize(currentKey.size() - node.labelLength);
+    };
     
-    // Update hashes from leaf to root
-    updateHashesRecursive(root);
+    dfs(root);
+    return keys;
 }
 
-bool MerkleTrie::search(const std::string& key) {
-    auto current = root;
+std::vector<std::string> TrieView::listKeys(const std::string& prefix, const std::string& after,
+                                            size_t limit) const {
+    std::vector<std::string> keys;
+    if (limit == 0) {
+        return keys;
+    }
     
-    for (char c : key) {
-        if (current->children.find(c) == current->children.end()) {
-            return false;
+    // Descend to the first node whose path covers the prefix; the prefix
+    // may end inside a compressed edge
+    uint32_t current = root;
+    std::string path;
+    while (path.size() < prefix.size()) {
+        uint32_t child = findChild(current, prefix[path.size()]);
+        if (child == TrieNode::NIL) {
+            return keys;
+        }
+        
+        const TrieNode& node = nodes[child];
+        size_t common = std::min<size_t>(node.labelLength, prefix.size() - path.size());
+        if (prefix.compare(path.size(), common, labels + node.labelOffset, common) != 0) {
+            return keys;
         }
-        current = current->children[c];
+        path.append(labels + node.labelOffset, node.labelLength);
+        current = child;
     }
     
-    return current->isEndOfWord;
+    // Children are in byte order, so a pre-order walk yields sorted keys.
+    // Returns false once the page is full.
+    std::function<bool(uint32_t)> visit = [&](uint32_t index) -> bool {
+        if (!after.empty()) {
+            size_t shared = std::min(path.size(), after.size());
+            int order = path.compare(0, shared, after, 0, shared);
+            // Every key below sorts before the cursor
+            if (order < 0) {
+                return true;
+            }
+            // Still on the cursor's own path: this node's key is not after it
+            if (order == 0 && path.size() <= after.size()) {
+                for (uint32_t child = nodes[index].firstChild; child != TrieNode::NIL;
+                     child = nodes[child].nextSibling) {
+                    path.append(labels + nodes[child].labelOffset, nodes[child].labelLength);
+                    bool more = visit(child);
+                    path.resize(path.size() - nodes[child].labelLength);
+                    if (!more) return false;
+                }
+                return true;
+            }
+        }
+        
+        if (nodes[index].isEndOfWord()) {
+            keys.push_back(path);
+            if (keys.size() == limit) return false;
+        }
+        for (uint32_t child = nodes[index].firstChild; child != TrieNode::NIL;
+             child = nodes[child].nextSibling) {
+            path.append(labels + nodes[child].labelOffset, nodes[child].labelLength);
+            bool more = visit(child);
+            path.resize(path.size() - nodes[child].labelLength);
+            if (!more) return false;
+        }
+        return true;
+    };
+    visit(current);
+    
+    return keys;
+}
+
+// BasicMerkleTrie Implementation
+template <typename HashPolicy>
+BasicMerkleTrie<HashPolicy>::BasicMerkleTrie()
+    : root(0), keyCount(0), nextVersion(1), frozenNodes(0), undo() {
+    newNode(0, 0);
+    rehashDirty(root);
+}
+
+template <typename HashPolicy>
+BasicMerkleTrie<HashPolicy>::BasicMerkleTrie(const std::vector<std::pair<std::string, std::string>>& entries)
+    : root(0), keyCount(0), nextVersion(1), frozenNodes(0), undo() {
+    newNode(0, 0);
+    if (entries.empty()) {
+        rehashDirty(root);
+        return;
+    }
+    insertBatch(entries);
+}
+
+template <typename HashPolicy>
+BasicMerkleTrie<HashPolicy>::BasicMerkleTrie(const TrieView& snapshot)
+    : nodes(snapshot.nodes, snapshot.nodes + snapshot.nodeCount),
+      labels(snapshot.labels, snapshot.labelBytes),
+      values(snapshot.values, snapshot.valueBytes),
+      root(snapshot.root),
+      keyCount(snapshot.getSize()),
+      nextVersion(1),
+      frozenNodes(0), undo() {}
+
+template <typename HashPolicy>
+TrieView BasicMerkleTrie<HashPolicy>::view() const {
+    return TrieView{nodes.data(), nodes.size(), labels.data(), labels.size(),
+                    values.data(), values.size(), root, keyCount};
+}
+
+template <typename HashPolicy>
+uint32_t BasicMerkleTrie<HashPolicy>::newNode(uint64_t labelOffset, uint32_t labelLength) {
+    TrieNode node;
+    node.labelOffset = labelOffset;
+    node.labelLength = labelLength;
+    node.valueOffset = 0;
+    node.valueLength = 0;
+    node.firstChild = TrieNode::NIL;
+    node.nextSibling = TrieNode::NIL;
+    node.flags = TrieNode::DIRTY;
+    nodes.push_back(node);
+    TRIE_METRIC_COUNT(TRIE_NODES_CREATED, 1);
+    TRIE_METRIC_COUNT(TRIE_BYTES_ALLOCATED, sizeof(TrieNode));
+    return static_cast<uint32_t>(nodes.size() - 1);
 }
 
-std::string MerkleTrie::getValue(const std::string& key) {
-    auto current = root;
+template <typename HashPolicy>
+void BasicMerkleTrie<HashPolicy>::linkChild(uint32_t parent, uint32_t child) {
+    uint8_t lead = static_cast<uint8_t>(labels[nodes[child].labelOffset]);
+    uint32_t previous = TrieNode::NIL;
+    uint32_t next = nodes[parent].firstChild;
     
-    for (char c : key) {
-        if (current->children.find(c) == current->children.end()) {
-            return "";
-        }
-        current = current->children[c];
+    while (next != TrieNode::NIL &&
+           static_cast<uint8_t>(labels[nodes[next].labelOffset]) < lead) {
+        previous = thawChild(parent, next);
+        next = nodes[previous].nextSibling;
     }
     
-    return current->isEndOfWord ? current->value : "";
+    nodes[child].nextSibling = next;
+    if (previous == TrieNode::NIL) {
+        nodes[parent].firstChild = child;
+    } else {
+        saveNode(previous);
+        nodes[previous].nextSibling = child;
+    }
 }
 
-std::string MerkleTrie::getRootHash() {
-    return root->hash;
+template <typename HashPolicy>
+uint32_t BasicMerkleTrie<HashPolicy>::thawNode(uint32_t node) {
+    if (node >= frozenNodes) {
+        return node;
+    }
+    
+    // Frozen nodes are clean, so the copy's hashes are still valid
+    TrieNode copy = nodes[node];
+    nodes.push_back(copy);
+    TRIE_METRIC_COUNT(TRIE_NODES_CREATED, 1);
+    TRIE_METRIC_COUNT(TRIE_BYTES_ALLOCATED, sizeof(TrieNode));
+    return static_cast<uint32_t>(nodes.size() - 1);
 }
 
-std::vector<std::string> MerkleTrie::getMerkleProof(const std::string& key) {
-    std::vector<std::string> proof;
-    auto current = root;
+template <typename HashPolicy>
+uint32_t BasicMerkleTrie<HashPolicy>::thawChild(uint32_t parent, uint32_t child) {
+    if (child >= frozenNodes) {
+        return child;
+    }
     
-    for (char c : key) {
-        if (current->children.find(c) == current->children.end()) {
-            return proof; // Empty proof if key not found
+    uint32_t previous = TrieNode::NIL;
+    uint32_t current = nodes[parent].firstChild;
+    while (true) {
+        uint32_t copy = thawNode(current);
+        if (copy != current) {
+            if (previous == TrieNode::NIL) {
+                nodes[parent].firstChild = copy;
+            } else {
+                saveNode(previous);
+                nodes[previous].nextSibling = copy;
+            }
+        }
+        if (current == child) {
+            return copy;
         }
+        previous = copy;
+        current = nodes[copy].nextSibling;
+    }
+}
+
+template <typename HashPolicy>
+void BasicMerkleTrie<HashPolicy>::saveNode(uint32_t node) {
+    if (undo.active && node < undo.nodeCount && !(nodes[node].flags & TrieNode::DIRTY)) {
+        undo.saved.emplace_back(node, nodes[node]);
+    }
+}
+
+template <typename HashPolicy>
+void BasicMerkleTrie<HashPolicy>::insertPath(const std::string& key, const std::string& value) {
+    root = thawNode(root);
+    saveNode(root);
+    uint32_t current = root;
+    size_t pos = 0;
+    nodes[current].flags |= TrieNode::DIRTY;
+    
+    while (pos < key.size()) {
+        uint32_t child = view().findChild(current, key[pos]);
         
-        // Add sibling hashes to proof
-        for (const auto& child : current->children) {
-            if (child.first != c) {
-                proof.push_back(child.second->hash);
+        if (child == TrieNode::NIL) {
+            // New leaf carrying the whole remaining suffix as its label
+            uint64_t offset = labels.size();
+            labels.append(key, pos, std::string::npos);
+            TRIE_METRIC_COUNT(TRIE_BYTES_ALLOCATED, key.size() - pos);
+            child = newNode(offset, static_cast<uint32_t>(key.size() - pos));
+            linkChild(current, child);
+            current = child;
+            break;
+        }
+        
+        child = thawChild(current, child);
+        saveNode(child);
+        uint64_t labelOffset = nodes[child].labelOffset;
+        uint32_t labelLength = nodes[child].labelLength;
+        uint32_t matched = 1;
+        while (matched < labelLength && pos + matched < key.size() &&
+               labels[labelOffset + matched] == key[pos + matched]) {
+            matched++;
+        }
+        
+        if (matched < labelLength) {
+            // Split the edge: a new node takes the matched prefix and
+            // adopts the old child under the remainder of the label
+            uint32_t middle = newNode(labelOffset, matched);
+            
+            uint32_t previous = TrieNode::NIL;
+            uint32_t* link = &nodes[current].firstChild;
+            while (*link != child) {
+                previous = *link;
+                link = &nodes[previous].nextSibling;
+            }
+            if (previous != TrieNode::NIL) {
+                saveNode(previous);
             }
+            *link = middle;
+            nodes[middle].nextSibling = nodes[child].nextSibling;
+            nodes[middle].firstChild = child;
+            
+            nodes[child].nextSibling = TrieNode::NIL;
+            nodes[child].labelOffset += matched;
+            nodes[child].labelLength -= matched;
+            nodes[child].flags |= TrieNode::DIRTY;
+            child = middle;
         }
         
-        current = current->children[c];
+        nodes[child].flags |= TrieNode::DIRTY;
+        current = child;
+        pos += matched;
     }
     
-    return proof;
+    TrieNode& node = nodes[current];
+    if (!node.isEndOfWord()) {
+        keyCount++;
+    }
+    node.flags |= TrieNode::END_OF_WORD | TrieNode::DIRTY;
+    node.valueOffset = values.size();
+    node.valueLength = static_cast<uint32_t>(value.size());
+    values += value;
+    TRIE_METRIC_COUNT(TRIE_BYTES_ALLOCATED, value.size());
 }
 
-bool MerkleTrie::verifyProof(const std::string& key, const std::string& value,
-                            const std::vector<std::string>& proof, const std::string& rootHash) {
-    // Simplified verification - in production, implement full Merkle proof verification
-    std::string computedHash = HashFusion::sha256(key + value);
+template <typename HashPolicy>
+typename BasicMerkleTrie<HashPolicy>::Version BasicMerkleTrie<HashPolicy>::commit() {
+    // Rollback would truncate nodes the new version refers to
+    if (undo.active) {
+        throw std::runtime_error("Cannot commit a trie version inside an open savepoint");
+    }
     
-    for (const auto& proofHash : proof) {
-        computedHash = HashFusion::combineHashes(computedHash, proofHash);
+    // Inserts leave the trie clean, so everything built so far is final
+    Version version = nextVersion++;
+    versionRoots[version] = VersionRoot{root, keyCount};
+    frozenNodes = static_cast<uint32_t>(nodes.size());
+    return version;
+}
+
+template <typename HashPolicy>
+bool BasicMerkleTrie<HashPolicy>::view(Version version, TrieView& out) const {
+    auto it = versionRoots.find(version);
+    if (it == versionRoots.end()) {
+        return false;
     }
     
-    return computedHash == rootHash;
+    out = view();
+    out.root = it->second.root;
+    out.keyCount = it->second.keyCount;
+    return true;
 }
 
-std::string MerkleTrie::generateFusedHash(const std::string& input, const std::string& salt, uint64_t timestamp) {
-    return HashFusion::trieHashFusion(input, salt, timestamp);
+template <typename HashPolicy>
+bool BasicMerkleTrie<HashPolicy>::releaseVersion(Version version) {
+    return versionRoots.erase(version) > 0;
 }
 
-std::string MerkleTrie::generateNullifierHash(const std::string& voterHash, const std::string& salt) {
-    return HashFusion::generateNullifier(voterHash, salt);
+template <typename HashPolicy>
+std::vector<typename BasicMerkleTrie<HashPolicy>::Version> BasicMerkleTrie<HashPolicy>::getVersions() const {
+    std::vector<Version> versions;
+    versions.reserve(versionRoots.size());
+    for (const auto& entry : versionRoots) {
+        versions.push_back(entry.first);
+    }
+    return versions;
 }
 
-void MerkleTrie::updateHashesRecursive(std::shared_ptr<TrieNode> node) {
-    if (!node) return;
+template <typename HashPolicy>
+size_t BasicMerkleTrie<HashPolicy>::collectGarbage() {
+    // Compaction renumbers the nodes the undo journal refers to
+    if (undo.active) {
+        throw std::runtime_error("Cannot collect garbage inside an open savepoint");
+    }
+    
+    // Mark what the retained versions reach, then what only the current
+    // trie reaches; a marked node's whole subtree is already marked
+    static const uint8_t UNREACHED = 0, IN_VERSION = 1, CURRENT_ONLY = 2;
+    std::vector<uint8_t> mark(nodes.size(), UNREACHED);
+    std::vector<uint32_t> stack;
     
-    // Update children first (post-order traversal)
-    for (auto& child : node->children) {
-        updateHashesRecursive(child.second);
+    auto sweep = [&](uint32_t start, uint8_t tag) {
+        if (mark[start] != UNREACHED) return;
+        mark[start] = tag;
+        stack.push_back(start);
+        while (!stack.empty()) {
+            uint32_t index = stack.back();
+            stack.pop_back();
+            for (uint32_t child = nodes[index].firstChild; child != TrieNode::NIL;
+                 child = nodes[child].nextSibling) {
+                if (mark[child] == UNREACHED) {
+                    mark[child] = tag;
+                    stack.push_back(child);
+                }
+            }
+        }
+    };
+    for (const auto& entry : versionRoots) {
+        sweep(entry.second.root, IN_VERSION);
+    }
+    sweep(root, CURRENT_ONLY);
+    
+    // Version nodes are renumbered first, so they stay below frozenNodes
+    std::vector<uint32_t> remap(nodes.size(), TrieNode::NIL);
+    std::vector<TrieNode> compacted;
+    for (uint8_t tag : { IN_VERSION, CURRENT_ONLY }) {
+        for (size_t i = 0; i < nodes.size(); i++) {
+            if (mark[i] == tag) {
+                remap[i] = static_cast<uint32_t>(compacted.size());
+                compacted.push_back(nodes[i]);
+            }
+        }
+        if (tag == IN_VERSION) {
+            frozenNodes = static_cast<uint32_t>(compacted.size());
+        }
     }
     
-    // Update current node hash
-    node->updateHash();
+    for (TrieNode& node : compacted) {
+        if (node.firstChild != TrieNode::NIL) node.firstChild = remap[node.firstChild];
+        if (node.nextSibling != TrieNode::NIL) node.nextSibling = remap[node.nextSibling];
+    }
+    
+    // Keep only the live label and value bytes. Ranges are merged where
+    // they overlap, so node copies and split edges still share bytes
+    auto compactBytes = [&](std::string& bytes, uint64_t TrieNode::*offset, uint32_t TrieNode::*length) {
+        std::vector<uint32_t> order(compacted.size());
+        for (size_t i = 0; i < order.size(); i++) {
+            order[i] = static_cast<uint32_t>(i);
+        }
+        std::sort(order.begin(), order.end(), [&](uint32_t a, uint32_t b) {
+            return compacted[a].*offset < compacted[b].*offset;
+        });
+        
+        std::string live;
+        uint64_t runStart = 0, runEnd = 0, runTarget = 0;
+        bool inRun = false;
+        for (uint32_t index : order) {
+            TrieNode& node = compacted[index];
+            uint64_t begin = node.*offset;
+            uint64_t end = begin + node.*length;
+            if (!inRun || begin > runEnd) {
+                live.append(bytes, runStart, runEnd - runStart);
+                runStart = begin;
+                runEnd = end;
+                runTarget = live.size();
+                inRun = true;
+            } else if (end > runEnd) {
+                runEnd = end;
+            }
+            node.*offset = runTarget + (begin - runStart);
+        }
+        live.append(bytes, runStart, runEnd - runStart);
+        bytes.swap(live);
+    };
+    compactBytes(labels, &TrieNode::labelOffset, &TrieNode::labelLength);
+    compactBytes(values, &TrieNode::valueOffset, &TrieNode::valueLength);
+    
+    size_t freed = nodes.size() - compacted.size();
+    nodes.swap(compacted);
+    root = remap[root];
+    for (auto& entry : versionRoots) {
+        entry.second.root = remap[entry.second.root];
+    }
+    
+    return freed;
+}
+
+template <typename HashPolicy>
+void BasicMerkleTrie<HashPolicy>::rehashNode(uint32_t index) {
+    TrieNode& node = nodes[index];
+    
+    // value + (edge char + encoded child hash)... + "END", streamed
+    typename HashPolicy::Stream stream;
+    stream.update(values.data() + node.valueOffset, node.valueLength);
+    
+    // Children are already in character order
+    for (uint32_t child = node.firstChild; child != TrieNode::NIL;
+         child = nodes[child].nextSibling) {
+        stream.update(labels[nodes[child].labelOffset]);
+        HashPolicy::updateDigest(stream, nodes[child].edgeHash);
+    }
+    
+    if (node.isEndOfWord()) {
+        stream.update("END", 3);
+    }
+    
+    node.hash = stream.finish();
+    
+    // Fold the implicit single-child nodes of a compressed edge bottom-up
+    Digest edge = node.hash;
+    for (uint32_t i = node.labelLength; i-- > 1; ) {
+        typename HashPolicy::Stream link;
+        link.update(labels[node.labelOffset + i]);
+        HashPolicy::updateDigest(link, edge);
+        edge = link.finish();
+    }
+    node.edgeHash = edge;
 }
 
-std::string MerkleTrie::computeNodeHash(const std::shared_ptr<TrieNode>& node) {
-    return node->hash;
+template <typename HashPolicy>
+void BasicMerkleTrie<HashPolicy>::rehashDirty(uint32_t index) {
+    for (uint32_t child = nodes[index].firstChild; child != TrieNode::NIL;
+         child = nodes[child].nextSibling) {
+        if (nodes[child].flags & TrieNode::DIRTY) {
+            rehashDirty(child);
+        }
+    }
+    
+    rehashNode(index);
+    nodes[index].flags &= ~TrieNode::DIRTY;
 }
 
-void MerkleTrie::printTrie() {
-    std::cout << "Merkle Trie Structure:" << std::endl;
-    std::cout << "Root Hash: " << root->hash.substr(0, 16) << "..." << std::endl;
+template <typename HashPolicy>
+void BasicMerkleTrie<HashPolicy>::insert(const std::string& key, const std::string& value) {
+    TRIE_METRIC_TIME(TRIE_INSERT);
+    insertPath(key, value);
+    
+    // Only the touched root-to-leaf path is dirty
+    TRIE_METRIC_TIME(TRIE_REHASH);
+    rehashDirty(root);
 }
 
-size_t MerkleTrie::getSize() {
-    size_t count = 0;
-    std::queue<std::shared_ptr<TrieNode>> queue;
-    queue.push(root);
+template <typename HashPolicy>
+void BasicMerkleTrie<HashPolicy>::insertBatch(const std::vector<std::pair<std::string, std::string>>& entries) {
+    if (entries.empty()) return;
+    TRIE_METRIC_TIME(TRIE_INSERT_BATCH);
     
-    while (!queue.empty()) {
-        auto node = queue.front();
-        queue.pop();
+    // Insert in key order for locality; stable so later duplicates win
+    std::vector<const std::pair<std::string, std::string>*> sorted;
+    sorted.reserve(entries.size());
+    for (const auto& entry : entries) {
+        sorted.push_back(&entry);
+    }
+    std::stable_sort(sorted.begin(), sorted.end(),
+                     [](const std::pair<std::string, std::string>* a,
+                        const std::pair<std::string, std::string>* b) { return a->first < b->first; });
+    
+    for (size_t i = 0; i < sorted.size(); i++) {
+        if (i + 1 < sorted.size() && sorted[i]->first == sorted[i + 1]->first) {
+            continue;
+        }
+        insertPath(sorted[i]->first, sorted[i]->second);
+    }
+    
+    // Small batches are rehashed in place on the calling thread
+    TRIE_METRIC_TIME(TRIE_REHASH);
+    if (sorted.size() < LEVEL_REHASH_THRESHOLD) {
+        rehashDirty(root);
+        return;
+    }
+    
+    rehashDirtyLevels();
+}
+
+template <typename HashPolicy>
+void BasicMerkleTrie<HashPolicy>::savepoint() {
+    // Inserts leave the trie clean, so every dirty node below nodeCount
+    // has been saved
+    undo.active = true;
+    undo.nodeCount = nodes.size();
+    undo.labelBytes = labels.size();
+    undo.valueBytes = values.size();
+    undo.root = root;
+    undo.keyCount = keyCount;
+    undo.saved.clear();
+}
+
+template <typename HashPolicy>
+void BasicMerkleTrie<HashPolicy>::rollback() {
+    if (!undo.active) return;
+    
+    // Newest first, so a node saved twice ends with its oldest contents
+    for (size_t i = undo.saved.size(); i-- > 0; ) {
+        nodes[undo.saved[i].first] = undo.saved[i].second;
+    }
+    nodes.resize(undo.nodeCount);
+    labels.resize(undo.labelBytes);
+    values.resize(undo.valueBytes);
+    root = undo.root;
+    keyCount = undo.keyCount;
+    release();
+}
+
+template <typename HashPolicy>
+void BasicMerkleTrie<HashPolicy>::release() {
+    undo.active = false;
+    undo.saved.clear();
+    undo.saved.shrink_to_fit();
+}
+
+template <typename HashPolicy>
+void BasicMerkleTrie<HashPolicy>::rehashDirtyLevels() {
+    // Group dirty nodes by height above their deepest dirty descendant;
+    // nodes of equal height never depend on each other
+    std::vector<std::vector<uint32_t>> levels;
+    std::function<size_t(uint32_t)> collect = [&](uint32_t index) -> size_t {
+        size_t height = 0;
+        for (uint32_t child = nodes[index].firstChild; child != TrieNode::NIL;
+             child = nodes[child].nextSibling) {
+            if (nodes[child].flags & TrieNode::DIRTY) {
+                height = std::max(height, collect(child) + 1);
+            }
+        }
         
-        if (node->isEndOfWord) {
-            count++;
+        if (levels.size() <= height) {
+            levels.resize(height + 1);
         }
+        levels[height].push_back(index);
+        return height;
+    };
+    collect(root);
+    
+    // The arena is not resized while hashing, so chunks of one level can
+    // be hashed concurrently
+    for (const auto& level : levels) {
+        size_t chunks = (level.size() + LEVEL_CHUNK_SIZE - 1) / LEVEL_CHUNK_SIZE;
+        ThreadPool::shared().parallelFor(chunks, [&](size_t chunk) {
+            size_t begin = chunk * LEVEL_CHUNK_SIZE;
+            size_t count = std::min(LEVEL_CHUNK_SIZE, level.size() - begin);
+            rehashLevel(level.data() + begin, count);
+        });
+    }
+}
+
+template <typename HashPolicy>
+void BasicMerkleTrie<HashPolicy>::rehashLevel(const uint32_t* level, size_t count) {
+    // Same inputs as rehashNode, laid out in one buffer per round so the
+    // independent messages go through HashPolicy::hashMany together
+    std::string buffer;
+    std::vector<size_t> offsets(count + 1);
+    std::vector<const uint8_t*> data(count);
+    std::vector<size_t> lengths(count);
+    std::vector<Digest> digests(count);
+    char encoded[HashPolicy::ENCODED_DIGEST_SIZE];
+    
+    auto hashBuffer = [&](size_t messages) {
+        for (size_t i = 0; i < messages; i++) {
+            data[i] = reinterpret_cast<const uint8_t*>(buffer.data()) + offsets[i];
+            lengths[i] = offsets[i + 1] - offsets[i];
+        }
+        HashPolicy::hashMany(data.data(), lengths.data(), messages, digests.data());
+    };
+    
+    for (size_t i = 0; i < count; i++) {
+        const TrieNode& node = nodes[level[i]];
+        offsets[i] = buffer.size();
+        buffer.append(values, node.valueOffset, node.valueLength);
         
-        for (const auto& child : node->children) {
-            queue.push(child.second);
+        for (uint32_t child = node.firstChild; child != TrieNode::NIL;
+             child = nodes[child].nextSibling) {
+            buffer += labels[nodes[child].labelOffset];
+            HashPolicy::encodeDigest(nodes[child].edgeHash, encoded);
+            buffer.append(encoded, sizeof(encoded));
+        }
+        
+        if (node.isEndOfWord()) {
+            buffer += "END";
         }
     }
+    offsets[count] = buffer.size();
+    hashBuffer(count);
     
-    return count;
+    // Edge chains advance one implicit node per round for every node whose
+    // compressed label still has characters left
+    std::vector<uint32_t> active;
+    std::vector<uint32_t> remaining;
+    for (size_t i = 0; i < count; i++) {
+        TrieNode& node = nodes[level[i]];
+        node.hash = digests[i];
+        node.edgeHash = digests[i];
+        if (node.labelLength > 1) {
+            active.push_back(level[i]);
+            remaining.push_back(node.labelLength - 1);
+        }
+    }
+    
+    while (!active.empty()) {
+        buffer.clear();
+        for (size_t i = 0; i < active.size(); i++) {
+            const TrieNode& node = nodes[active[i]];
+            offsets[i] = buffer.size();
+            buffer += labels[node.labelOffset + remaining[i]];
+            HashPolicy::encodeDigest(node.edgeHash, encoded);
+            buffer.append(encoded, sizeof(encoded));
+        }
+        offsets[active.size()] = buffer.size();
+        hashBuffer(active.size());
+        
+        size_t kept = 0;
+        for (size_t i = 0; i < active.size(); i++) {
+            nodes[active[i]].edgeHash = digests[i];
+            if (--remaining[i] > 0) {
+                active[kept] = active[i];
+                remaining[kept] = remaining[i];
+                kept++;
+            }
+        }
+        active.resize(kept);
+        remaining.resize(kept);
+    }
+    
+    for (size_t i = 0; i < count; i++) {
+        nodes[level[i]].flags &= ~TrieNode::DIRTY;
+    }
 }
 
-std::vector<std::string> MerkleTrie::getAllKeys() {
-    std::vector<std::string> keys;
-    std::string currentKey = "";
+template <typename HashPolicy>
+bool BasicMerkleTrie<HashPolicy>::search(const std::string& key) const {
+    return view().search(key);
+}
+
+template <typename HashPolicy>
+std::string BasicMerkleTrie<HashPolicy>::getValue(const std::string& key) const {
+    return view().getValue(key);
+}
+
+template <typename HashPolicy>
+std::string BasicMerkleTrie<HashPolicy>::getRootHash() const {
+    return HashFusion::toHex(nodes[root].hash);
+}
+
+template <typename HashPolicy>
+std::vector<std::string> BasicMerkleTrie<HashPolicy>::getMerkleProof(const std::string& key) const {
+    return view().getMerkleProof(key);
+}
+
+template <typename HashPolicy>
+bool BasicMerkleTrie<HashPolicy>::getTrieProof(const std::string& key, TrieProof& proof) const {
+    return view().getTrieProof(key, proof);
+}
+
+template <typename HashPolicy>
+bool BasicMerkleTrie<HashPolicy>::verifyTrieProof(const TrieProof& proof, const Digest& root) {
+    const std::string& key = proof.key;
+    if (proof.levels.size() != key.size() + 1 || !proof.levels.back().endOfWord) {
+        return false;
+    }
     
-    std::function<void(std::shared_ptr<TrieNode>, std::string)> dfs = 
-        [&](std::shared_ptr<TrieNode> node, std::string key) {
-            if (node->isEndOfWord) {
-                keys.push_back(key);
+    // Same encoding as rehashNode, from the key's node up to the root;
+    // the path child is merged into the siblings at its char position
+    Digest hash;
+    for (size_t depth = proof.levels.size(); depth-- > 0; ) {
+        const TrieProofLevel& level = proof.levels[depth];
+        bool onPath = depth < key.size();
+        bool pathPending = onPath;
+        int previous = -1;
+        
+        typename HashPolicy::Stream stream;
+        stream.update(level.value);
+        
+        for (const auto& sibling : level.siblings) {
+            int lead = static_cast<uint8_t>(sibling.first);
+            if (pathPending && static_cast<uint8_t>(key[depth]) < lead) {
+                stream.update(key[depth]);
+                HashPolicy::updateDigest(stream, hash);
+                previous = static_cast<uint8_t>(key[depth]);
+                pathPending = false;
             }
             
-            for (const auto& child : node->children) {
-                dfs(child.second, key + child.first);
+            // Children are unique and sorted; the path char is not a sibling
+            if (lead <= previous || (onPath && lead == static_cast<uint8_t>(key[depth]))) {
+                return false;
             }
-        };
+            stream.update(sibling.first);
+            HashPolicy::updateDigest(stream, sibling.second);
+            previous = lead;
+        }
+        
+        if (pathPending) {
+            stream.update(key[depth]);
+            HashPolicy::updateDigest(stream, hash);
+        }
+        if (level.endOfWord) {
+            stream.update("END", 3);
+        }
+        hash = stream.finish();
+    }
     
-    dfs(root, currentKey);
-    return keys;
-}
\ No newline at end of file
+    return hash == root;
+}
+
+template <typename HashPolicy>
+std::vector<uint8_t> BasicMerkleTrie<HashPolicy>::verifyTrieProofs(const std::vector<TrieProof>& proofs,
+                                                                   const Digest& root) {
+    std::vector<uint8_t> results(proofs.size());
+    size_t chunks = (proofs.size() + VERIFY_CHUNK_SIZE - 1) / VERIFY_CHUNK_SIZE;
+    
+    ThreadPool::shared().parallelFor(chunks, [&](size_t chunk) {
+        size_t end = std::min(proofs.size(), (chunk + 1) * VERIFY_CHUNK_SIZE);
+        for (size_t i = chunk * VERIFY_CHUNK_SIZE; i < end; i++) {
+            results[i] = verifyTrieProof(proofs[i], root);
+        }
+    });
+    
+    return results;
+}
+
+template <typename HashPolicy>
+std::string BasicMerkleTrie<HashPolicy>::generateFusedHash(const std::string& input, const std::string& salt, uint64_t timestamp) {
+    return HashFusion::trieHashFusion(input, salt, timestamp);
+}
+
+template <typename HashPolicy>
+std::string BasicMerkleTrie<HashPolicy>::generateNullifierHash(const std::string& voterHash, const std::string& salt) {
+    return HashFusion::generateNullifier(voterHash, salt);
+}
+
+template <typename HashPolicy>
+void BasicMerkleTrie<HashPolicy>::printTrie() {
+    std::cout << "Merkle Trie Structure:" << std::endl;
+    std::cout << "Root Hash: " << getRootHash().substr(0, 16) << "..." << std::endl;
+}
+
+template <typename HashPolicy>
+size_t BasicMerkleTrie<HashPolicy>::getSize() const {
+    return view().getSize();
+}
+
+template <typename HashPolicy>
+size_t BasicMerkleTrie<HashPolicy>::getMemoryBytes() const {
+    return nodes.size() * sizeof(TrieNode) + labels.size() + values.size();
+}
+
+template <typename HashPolicy>
+std::vector<std::string> BasicMerkleTrie<HashPolicy>::getAllKeys() const {
+    return view().getAllKeys();
+}
+
+template <typename HashPolicy>
+std::vector<std::string> BasicMerkleTrie<HashPolicy>::listKeys(const std::string& prefix,
+                                                               const std::string& after,
+                                                               size_t limit) const {
+    return view().listKeys(prefix, after, limit);
+}
+
+template class BasicMerkleTrie<Sha256HexPolicy>;
+template class BasicMerkleTrie<Keccak256Policy>;
+template class BasicMerkleTrie<Blake2bPolicy>;
@@ -0,0 +1,155 @@
+#include "include/metrics.h"
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+
+namespace {
+
+const size_t STRIPES = 16;
+
+struct alignas(64) Stripe {
+    std::atomic<uint64_t> counters[Metrics::COUNTER_COUNT];
+    std::atomic<uint64_t> counts[Metrics::OPERATION_COUNT];
+    std::atomic<uint64_t> sums[Metrics::OPERATION_COUNT];
+    std::atomic<uint64_t> buckets[Metrics::OPERATION_COUNT][Metrics::BUCKETS + 1];
+};
+
+// Zero-initialized as a static
+Stripe stripes[STRIPES];
+
+Stripe& localStripe() {
+    static std::atomic<size_t> nextStripe(0);
+    thread_local size_t stripe = nextStripe.fetch_add(1, std::memory_order_relaxed) % STRIPES;
+    return stripes[stripe];
+}
+
+size_t bucketOf(uint64_t nanoseconds) {
+    if (nanoseconds <= (uint64_t(1) << Metrics::MIN_BUCKET_BITS)) {
+        return 0;
+    }
+    // ceil(log2(nanoseconds))
+    size_t bits = 64 - __builtin_clzll(nanoseconds - 1);
+    return std::min<size_t>(bits - Metrics::MIN_BUCKET_BITS, Metrics::BUCKETS);
+}
+
+const char* const COUNTER_NAMES[Metrics::COUNTER_COUNT] = {
+    "sha256_hashes", "keccak256_hashes", "blake2b_hashes",
+    "trie_nodes_created", "trie_bytes_allocated"
+};
+
+const char* const OPERATION_NAMES[Metrics::OPERATION_COUNT] = {
+    "process_voter", "process_voter_batch", "voter_hash_fusion", "trie_insert", "trie_insert_batch",
+    "trie_rehash", "trie_proof", "trie_size", "snapshot_write", "wal_sync",
+    "tally_ingest"
+};
+
+} // namespace
+
+void Metrics::count(Counter counter, uint64_t amount) {
+    localStripe().counters[counter].fetch_add(amount, std::memory_order_relaxed);
+}
+
+void Metrics::observe(Operation operation, uint64_t nanoseconds) {
+    Stripe& stripe = localStripe();
+    stripe.counts[operation].fetch_add(1, std::memory_order_relaxed);
+    stripe.sums[operation].fetch_add(nanoseconds, std::memory_order_relaxed);
+    stripe.buckets[operation][bucketOf(nanoseconds)].fetch_add(1, std::memory_order_relaxed);
+}
+
+uint64_t Metrics::counterValue(Counter counter) {
+    uint64_t total = 0;
+    for (const Stripe& stripe : stripes) {
+        total += stripe.counters[counter].load(std::memory_order_relaxed);
+    }
+    return total;
+}
+
+Metrics::Histogram Metrics::histogram(Operation operation) {
+    Histogram result = {};
+    for (const Stripe& stripe : stripes) {
+        result.count += stripe.counts[operation].load(std::memory_order_relaxed);
+        result.sumNanoseconds += stripe.sums[operation].load(std::memory_order_relaxed);
+        for (size_t i = 0; i <= BUCKETS; i++) {
+            result.buckets[i] += stripe.buckets[operation][i].load(std::memory_order_relaxed);
+        }
+    }
+    return result;
+}
+
+const char* Metrics::counterName(Counter counter) {
+    return COUNTER_NAMES[counter];
+}
+
+const char* Metrics::operationName(Operation operation) {
+    return OPERATION_NAMES[operation];
+}
+
+double Metrics::bucketBound(size_t bucket) {
+    return static_cast<double>(uint64_t(1) << (MIN_BUCKET_BITS + bucket)) * 1e-9;
+}
+
+std::string Metrics::prometheusText() {
+    std::string text;
+    char line[192];
+    
+    text += "# HELP trie_hashes_total Hash function invocations.\n";
+    text += "# TYPE trie_hashes_total counter\n";
+    const Counter hashes[] = { SHA256_HASHES, KECCAK256_HASHES, BLAKE2B_HASHES };
+    const char* functions[] = { "sha256", "keccak256", "blake2b" };
+    for (size_t i = 0; i < 3; i++) {
+        std::snprintf(line, sizeof(line), "trie_hashes_total{function=\"%s\"} %llu\n",
+                      functions[i], static_cast<unsigned long long>(counterValue(hashes[i])));
+        text += line;
+    }
+    
+    text += "# HELP trie_nodes_created_total Trie arena nodes created, including copies.\n";
+    text += "# TYPE trie_nodes_created_total counter\n";
+    std::snprintf(line, sizeof(line), "trie_nodes_created_total %llu\n",
+                  static_cast<unsigned long long>(counterValue(TRIE_NODES_CREATED)));
+    text += line;
+    
+    text += "# HELP trie_bytes_allocated_total Bytes appended to trie arenas.\n";
+    text += "# TYPE trie_bytes_allocated_total counter\n";
+    std::snprintf(line, sizeof(line), "trie_bytes_allocated_total %llu\n",
+                  static_cast<unsigned long long>(counterValue(TRIE_BYTES_ALLOCATED)));
+    text += line;
+    
+    text += "# HELP trie_operation_duration_seconds Latency of native operations.\n";
+    text += "# TYPE trie_operation_duration_seconds histogram\n";
+    for (size_t op = 0; op < OPERATION_COUNT; op++) {
+        Histogram h = histogram(static_cast<Operation>(op));
+        const char* name = OPERATION_NAMES[op];
+        
+        uint64_t cumulative = 0;
+        for (size_t i = 0; i < BUCKETS; i++) {
+            cumulative += h.buckets[i];
+            std::snprintf(line, sizeof(line),
+                          "trie_operation_duration_seconds_bucket{operation=\"%s\",le=\"%g\"} %llu\n",
+                          name, bucketBound(i), static_cast<unsigned long long>(cumulative));
+            text += line;
+        }
+        std::snprintf(line, sizeof(line),
+                      "trie_operation_duration_seconds_bucket{operation=\"%s\",le=\"+Inf\"} %llu\n",
+                      name, static_cast<unsigned long long>(h.count));
+        text += line;
+        std::snprintf(line, sizeof(line), "trie_operation_duration_seconds_sum{operation=\"%s\"} %.9f\n",
+                      name, h.sumNanoseconds * 1e-9);
+        text += line;
+        std::snprintf(line, sizeof(line), "trie_operation_duration_seconds_count{operation=\"%s\"} %llu\n",
+                      name, static_cast<unsigned long long>(h.count));
+        text += line;
+    }
+    
+    return text;
+}
+
+void Metrics::reset() {
+    for (Stripe& stripe : stripes) {
+        for (auto& counter : stripe.counters) counter.store(0, std::memory_order_relaxed);
+        for (auto& count : stripe.counts) count.store(0, std::memory_order_relaxed);
+        for (auto& sum : stripe.sums) sum.store(0, std::memory_order_relaxed);
+        for (auto& row : stripe.buckets) {
+            for (auto& bucket : row) bucket.store(0, std::memory_order_relaxed);
+        }
+    }
+}
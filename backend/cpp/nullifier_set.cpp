@@ -0,0 +1,210 @@
+#include "include/nullifier_set.h"
+#include <algorithm>
+#include <cstring>
+#include <mutex>
+#include <random>
+
+static const Digest ZERO_DIGEST = {};
+
+NullifierSet::NullifierSet(size_t expectedEntries) : count(0), hasZero(false) {
+    size_t slotCount = MIN_SLOTS;
+    while (slotCount * MAX_LOAD_PERCENT / 100 < expectedEntries) {
+        slotCount *= 2;
+    }
+    resize(slotCount);
+}
+
+NullifierSet::Key NullifierSet::keyOf(const Digest& nullifier) {
+    Key key;
+    DigestHash::keyed(nullifier, key.words);
+    return key;
+}
+
+size_t NullifierSet::findSlot(const Digest& nullifier, const Key& key) const {
+    // Returns the slot holding nullifier or the empty slot ending its probe
+    size_t mask = slots.size() - 1;
+    size_t slot = key.words[0] & mask;
+    while (slots[slot] != nullifier && slots[slot] != ZERO_DIGEST) {
+        slot = (slot + 1) & mask;
+    }
+    return slot;
+}
+
+bool NullifierSet::bloomMayContain(const Key& key) const {
+    size_t blocks = bloom.size() / BLOOM_BLOCK_WORDS;
+    const uint64_t* block = bloom.data() + ((key.words[0] >> 32) & (blocks - 1)) * BLOOM_BLOCK_WORDS;
+    uint64_t bits = key.words[1];
+    uint64_t moreBits = key.words[0] >> 55;
+    
+    // Eight 9-bit positions in the 512-bit block
+    for (size_t i = 0; i < BLOOM_HASHES; i++) {
+        uint32_t position = static_cast<uint32_t>((i < 7 ? bits >> (9 * i) : moreBits) & 511);
+        if (!(block[position >> 6] & (uint64_t(1) << (position & 63)))) {
+            return false;
+        }
+    }
+    return true;
+}
+
+void NullifierSet::bloomAdd(const Key& key) {
+    size_t blocks = bloom.size() / BLOOM_BLOCK_WORDS;
+    uint64_t* block = bloom.data() + ((key.words[0] >> 32) & (blocks - 1)) * BLOOM_BLOCK_WORDS;
+    uint64_t bits = key.words[1];
+    uint64_t moreBits = key.words[0] >> 55;
+    
+    for (size_t i = 0; i < BLOOM_HASHES; i++) {
+        uint32_t position = static_cast<uint32_t>((i < 7 ? bits >> (9 * i) : moreBits) & 511);
+        block[position >> 6] |= uint64_t(1) << (position & 63);
+    }
+}
+
+bool NullifierSet::contains(const Digest& nullifier) const {
+    if (nullifier == ZERO_DIGEST) {
+        return hasZero;
+    }
+    Key key = keyOf(nullifier);
+    if (!bloomMayContain(key)) {
+        return false;
+    }
+    return slots[findSlot(nullifier, key)] == nullifier;
+}
+
+bool NullifierSet::insert(const Digest& nullifier) {
+    if (nullifier == ZERO_DIGEST) {
+        if (hasZero) return false;
+        hasZero = true;
+        count++;
+        return true;
+    }
+    
+    Key key = keyOf(nullifier);
+    size_t slot = findSlot(nullifier, key);
+    if (slots[slot] == nullifier) {
+        return false;
+    }
+    
+    if ((count + 1) * 100 > slots.size() * MAX_LOAD_PERCENT) {
+        resize(slots.size() * 2);
+        slot = findSlot(nullifier, key);
+    }
+    slots[slot] = nullifier;
+    bloomAdd(key);
+    count++;
+    return true;
+}
+
+size_t NullifierSet::memoryBytes() const {
+    return slots.size() * sizeof(Digest) + bloom.size() * sizeof(uint64_t);
+}
+
+void NullifierSet::clear() {
+    std::fill(slots.begin(), slots.end(), ZERO_DIGEST);
+    std::fill(bloom.begin(), bloom.end(), 0);
+    count = 0;
+    hasZero = false;
+}
+
+void NullifierSet::resize(size_t slotCount) {
+    std::vector<Digest> old(slotCount, ZERO_DIGEST);
+    old.swap(slots);
+    
+    // The filter is sized with the table, so it is rebuilt on every growth
+    size_t words = std::max(BLOOM_BLOCK_WORDS, slotCount * BLOOM_BITS_PER_SLOT / 64);
+    bloom.assign(words, 0);
+    
+    size_t mask = slotCount - 1;
+    for (const Digest& nullifier : old) {
+        if (nullifier == ZERO_DIGEST) continue;
+        Key key = keyOf(nullifier);
+        size_t slot = key.words[0] & mask;
+        while (slots[slot] != ZERO_DIGEST) {
+            slot = (slot + 1) & mask;
+        }
+        slots[slot] = nullifier;
+        bloomAdd(key);
+    }
+}
+
+ShardedNullifierSet::ShardedNullifierSet() {
+    shards.reserve(SHARDS);
+    for (size_t i = 0; i < SHARDS; i++) {
+        shards.push_back(std::make_unique<Shard>());
+    }
+}
+
+size_t ShardedNullifierSet::shardOf(const Digest& nullifier) {
+    // Multiply-xorshift over all four words from a random per-process
+    // start, so clients cannot aim nullifiers at one shard's lock
+    static const uint64_t seed = (uint64_t(std::random_device()()) << 32) ^ std::random_device()();
+    uint64_t h = seed;
+    for (size_t offset = 0; offset < sizeof(Digest); offset += 8) {
+        uint64_t word;
+        std::memcpy(&word, nullifier.data() + offset, sizeof(word));
+        h = (h ^ word) * 0x9e3779b97f4a7c15ULL;
+        h ^= h >> 29;
+    }
+    h *= 0xbf58476d1ce4e5b9ULL;
+    return static_cast<size_t>(h >> 32) % SHARDS;
+}
+
+bool ShardedNullifierSet::contains(const Digest& nullifier) const {
+    const Shard& shard = *shards[shardOf(nullifier)];
+    std::shared_lock<std::shared_mutex> lock(shard.mutex);
+    return shard.set.contains(nullifier);
+}
+
+bool ShardedNullifierSet::insert(const Digest& nullifier) {
+    Shard& shard = *shards[shardOf(nullifier)];
+    std::unique_lock<std::shared_mutex> lock(shard.mutex);
+    return shard.set.insert(nullifier);
+}
+
+void ShardedNullifierSet::insertMany(const Digest* nullifiers, size_t count, uint8_t* fresh) {
+    // Grouped in input order, so the first of a repeated nullifier wins
+    std::vector<std::vector<uint32_t>> parts(SHARDS);
+    for (size_t i = 0; i < count; i++) {
+        parts[shardOf(nullifiers[i])].push_back(static_cast<uint32_t>(i));
+    }
+    
+    for (size_t i = 0; i < SHARDS; i++) {
+        if (parts[i].empty()) continue;
+        std::unique_lock<std::shared_mutex> lock(shards[i]->mutex);
+        for (uint32_t index : parts[i]) {
+            fresh[index] = shards[i]->set.insert(nullifiers[index]);
+        }
+    }
+}
+
+size_t ShardedNullifierSet::size() const {
+    size_t total = 0;
+    for (const auto& shard : shards) {
+        std::shared_lock<std::shared_mutex> lock(shard->mutex);
+        total += shard->set.size();
+    }
+    return total;
+}
+
+size_t ShardedNullifierSet::capacity() const {
+    size_t total = 0;
+    for (const auto& shard : shards) {
+        std::shared_lock<std::shared_mutex> lock(shard->mutex);
+        total += shard->set.capacity();
+    }
+    return total;
+}
+
+size_t ShardedNullifierSet::memoryBytes() const {
+    size_t total = 0;
+    for (const auto& shard : shards) {
+        std::shared_lock<std::shared_mutex> lock(shard->mutex);
+        total += shard->set.memoryBytes();
+    }
+    return total;
+}
+
+void ShardedNullifierSet::clear() {
+    for (const auto& shard : shards) {
+        std::unique_lock<std::shared_mutex> lock(shard->mutex);
+        shard->set.clear();
+    }
+}
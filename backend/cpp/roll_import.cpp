@@ -0,0 +1,398 @@
+#include "include/roll_import.h"
+#include "include/thread_pool.h"
+#include <algorithm>
+#include <cerrno>
+#include <condition_variable>
+#include <cstring>
+#include <deque>
+#include <exception>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// Longer fields are not voter IDs; the row is counted as skipped
+static const size_t MAX_ID_BYTES = 1024;
+static const size_t HASH_CHUNK_SIZE = 256;
+
+static std::runtime_error ioError(const std::string& what, const std::string& path) {
+    return std::runtime_error(what + " " + path + ": " + std::strerror(errno));
+}
+
+namespace {
+
+// Blocking FIFO of at most `capacity` items between two pipeline stages.
+// finish() lets the consumer drain what is queued; abort() wakes both
+// sides and makes every later push and pop fail.
+template <typename T>
+class BoundedQueue {
+public:
+    explicit BoundedQueue(size_t capacity) : capacity(std::max<size_t>(capacity, 1)),
+                                             finished(false), aborted(false) {}
+
+    bool push(T&& item) {
+        std::unique_lock<std::mutex> lock(mutex);
+        notFull.wait(lock, [&] { return items.size() < capacity || aborted; });
+        if (aborted) {
+            return false;
+        }
+        items.push_back(std::move(item));
+        notEmpty.notify_one();
+        return true;
+    }
+
+    bool pop(T& item) {
+        std::unique_lock<std::mutex> lock(mutex);
+        notEmpty.wait(lock, [&] { return !items.empty() || finished || aborted; });
+        if (aborted || items.empty()) {
+            return false;
+        }
+        item = std::move(items.front());
+        items.pop_front();
+        notFull.notify_one();
+        return true;
+    }
+
+    void finish() {
+        std::lock_guard<std::mutex> lock(mutex);
+        finished = true;
+        notEmpty.notify_all();
+    }
+
+    void abort() {
+        std::lock_guard<std::mutex> lock(mutex);
+        aborted = true;
+        notEmpty.notify_all();
+        notFull.notify_all();
+    }
+
+private:
+    size_t capacity;
+    std::deque<T> items;
+    std::mutex mutex;
+    std::condition_variable notEmpty;
+    std::condition_variable notFull;
+    bool finished;
+    bool aborted;
+};
+
+struct CsvField {
+    const char* data;
+    size_t length;
+    bool escaped;
+};
+
+// Scan the CSV record starting at p; stores field `column` in field when
+// the record has one and returns the start of the next record
+const char* scanCsvRecord(const char* p, const char* end, char delimiter, size_t column,
+                          CsvField& field, bool& found) {
+    found = false;
+    for (size_t index = 0; ; index++) {
+        const char* start;
+        size_t length;
+        bool escaped = false;
+
+        if (p < end && *p == '"') {
+            // Quoted: runs to the next lone quote, newlines included
+            const char* quote = p + 1;
+            for (;;) {
+                quote = static_cast<const char*>(std::memchr(quote, '"', end - quote));
+                if (!quote) {
+                    quote = end;
+                    break;
+                }
+                if (quote + 1 < end && quote[1] == '"') {
+                    escaped = true;
+                    quote += 2;
+                    continue;
+                }
+                break;
+            }
+            start = p + 1;
+            length = quote - start;
+            p = quote < end ? quote + 1 : end;
+            // Stray bytes between the closing quote and the delimiter are dropped
+            while (p < end && *p != delimiter && *p != '\n') {
+                p++;
+            }
+        } else {
+            start = p;
+            while (p < end && *p != delimiter && *p != '\n') {
+                p++;
+            }
+            length = p - start;
+            if (length > 0 && start[length - 1] == '\r' && (p == end || *p == '\n')) {
+                length--;
+            }
+        }
+
+        if (index == column) {
+            field = {start, length, escaped};
+            found = true;
+
+            // The rest of the line has no quotes in the common case, so
+            // jump straight to its end
+            const char* newline = static_cast<const char*>(std::memchr(p, '\n', end - p));
+            const char* lineEnd = newline ? newline : end;
+            if (!std::memchr(p, '"', lineEnd - p)) {
+                return newline ? newline + 1 : end;
+            }
+        }
+
+        if (p >= end) {
+            return end;
+        }
+        if (*p == '\n') {
+            return p + 1;
+        }
+        p++;
+    }
+}
+
+} // namespace
+
+RollFormat RollFormat::csv(size_t column, char delimiter, bool hasHeader) {
+    RollFormat format = {};
+    format.kind = CSV;
+    format.column = column;
+    format.delimiter = delimiter;
+    format.hasHeader = hasHeader;
+    return format;
+}
+
+RollFormat RollFormat::fixedWidth(size_t recordBytes, size_t fieldOffset, size_t fieldBytes) {
+    RollFormat format = {};
+    format.kind = FIXED_WIDTH;
+    format.recordBytes = recordBytes;
+    format.fieldOffset = fieldOffset;
+    format.fieldBytes = fieldBytes;
+    return format;
+}
+
+RollFile::RollFile(const std::string& path) : mapping(nullptr), mappedBytes(0) {
+    int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        throw ioError("Cannot open roll", path);
+    }
+
+    struct stat info;
+    if (::fstat(fd, &info) != 0) {
+        ::close(fd);
+        throw ioError("Cannot stat roll", path);
+    }
+
+    mappedBytes = static_cast<size_t>(info.st_size);
+    if (mappedBytes == 0) {
+        // mmap rejects empty mappings; an empty roll imports nothing
+        ::close(fd);
+        return;
+    }
+    mapping = ::mmap(nullptr, mappedBytes, PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);
+    if (mapping == MAP_FAILED) {
+        mapping = nullptr;
+        throw ioError("Cannot map roll", path);
+    }
+    // One forward pass: read ahead aggressively, let pages behind go early
+    ::madvise(mapping, mappedBytes, MADV_SEQUENTIAL);
+}
+
+RollFile::~RollFile() {
+    if (mapping) {
+        ::munmap(mapping, mappedBytes);
+    }
+}
+
+RollImporter::RollImporter(const RollFile& file, const RollFormat& format,
+                           size_t batchRecords, size_t queueDepth)
+    : file(file), format(format), batchRecords(std::max<size_t>(batchRecords, 1)),
+      queueDepth(queueDepth) {
+    if (format.kind == RollFormat::FIXED_WIDTH &&
+        (format.recordBytes == 0 || format.fieldBytes == 0 ||
+         format.fieldOffset + format.fieldBytes > format.recordBytes)) {
+        throw std::runtime_error("Fixed-width voter ID field must lie inside a non-empty record");
+    }
+    if (format.kind == RollFormat::CSV && (format.delimiter == '"' || format.delimiter == '\n')) {
+        throw std::runtime_error("CSV delimiter cannot be a quote or newline");
+    }
+}
+
+size_t RollImporter::parseCsv(size_t offset, ParsedBatch& batch) const {
+    const char* base = file.data();
+    const char* p = base + offset;
+    const char* end = base + file.size();
+
+    while (p < end && batch.tokens.size() < batchRecords) {
+        CsvField field;
+        bool found;
+        const char* next = scanCsvRecord(p, end, format.delimiter, format.column, field, found);
+
+        // Blank lines are not rows
+        const char* contentEnd = next;
+        if (contentEnd > p && contentEnd[-1] == '\n') contentEnd--;
+        if (contentEnd > p && contentEnd[-1] == '\r') contentEnd--;
+        if (contentEnd > p) {
+            if (found && field.length > 0 && field.length <= MAX_ID_BYTES) {
+                batch.tokens.push_back({field.data, static_cast<uint32_t>(field.length), field.escaped});
+            } else {
+                batch.skipped++;
+            }
+        }
+        p = next;
+    }
+    return p - base;
+}
+
+size_t RollImporter::parseFixedWidth(size_t offset, ParsedBatch& batch) const {
+    const char* base = file.data();
+    size_t size = file.size();
+
+    while (offset + format.recordBytes <= size && batch.tokens.size() < batchRecords) {
+        const char* start = base + offset + format.fieldOffset;
+        const char* end = start + format.fieldBytes;
+        while (start < end && (*start == ' ' || *start == '\0')) {
+            start++;
+        }
+        while (end > start && (end[-1] == ' ' || end[-1] == '\0')) {
+            end--;
+        }
+        if (end > start && static_cast<size_t>(end - start) <= MAX_ID_BYTES) {
+            batch.tokens.push_back({start, static_cast<uint32_t>(end - start), false});
+        } else {
+            batch.skipped++;
+        }
+        offset += format.recordBytes;
+    }
+
+    // A truncated final record
+    if (offset < size && offset + format.recordBytes > size) {
+        batch.skipped++;
+        offset = size;
+    }
+    return offset;
+}
+
+std::string RollImporter::materialize(const Token& token) {
+    if (!token.escaped) {
+        return std::string(token.data, token.length);
+    }
+    std::string id;
+    id.reserve(token.length);
+    for (uint32_t i = 0; i < token.length; i++) {
+        id.push_back(token.data[i]);
+        if (token.data[i] == '"' && i + 1 < token.length && token.data[i + 1] == '"') {
+            i++;
+        }
+    }
+    return id;
+}
+
+void RollImporter::run(const FusionContext& fusion, const Sink& sink, RollProgress& progress) {
+    size_t size = file.size();
+    progress.bytesRead.store(0, std::memory_order_relaxed);
+    progress.totalBytes.store(size, std::memory_order_relaxed);
+    progress.imported.store(0, std::memory_order_relaxed);
+    progress.skipped.store(0, std::memory_order_relaxed);
+
+    size_t start = 0;
+    if (format.kind == RollFormat::CSV) {
+        if (size >= 3 && std::memcmp(file.data(), "\xEF\xBB\xBF", 3) == 0) {
+            start = 3;
+        }
+        if (format.hasHeader && start < size) {
+            CsvField field;
+            bool found;
+            start = scanCsvRecord(file.data() + start, file.data() + size, format.delimiter, 0,
+                                  field, found) - file.data();
+        }
+    }
+
+    BoundedQueue<ParsedBatch> parsed(queueDepth);
+    BoundedQueue<Batch> hashed(queueDepth);
+    std::exception_ptr failure;
+    std::mutex failureMutex;
+    auto fail = [&](std::exception_ptr error) {
+        {
+            std::lock_guard<std::mutex> lock(failureMutex);
+            if (!failure) {
+                failure = error;
+            }
+        }
+        parsed.abort();
+        hashed.abort();
+    };
+
+    std::thread parser([&] {
+        try {
+            size_t offset = start;
+            while (offset < size) {
+                ParsedBatch batch;
+                batch.skipped = 0;
+                batch.tokens.reserve(std::min<size_t>(batchRecords, 1 << 20));
+                offset = format.kind == RollFormat::CSV ? parseCsv(offset, batch)
+                                                        : parseFixedWidth(offset, batch);
+                batch.endOffset = offset;
+                if (!parsed.push(std::move(batch))) {
+                    return;
+                }
+            }
+            parsed.finish();
+        } catch (...) {
+            fail(std::current_exception());
+        }
+    });
+
+    std::thread hasher([&] {
+        try {
+            ParsedBatch input;
+            while (parsed.pop(input)) {
+                Batch batch;
+                size_t count = input.tokens.size();
+                batch.entries.resize(count);
+                batch.leaves.resize(count);
+                batch.endOffset = input.endOffset;
+                batch.skipped = input.skipped;
+
+                size_t chunks = (count + HASH_CHUNK_SIZE - 1) / HASH_CHUNK_SIZE;
+                ThreadPool::shared().parallelFor(chunks, [&](size_t chunk) {
+                    size_t end = std::min(count, (chunk + 1) * HASH_CHUNK_SIZE);
+                    for (size_t i = chunk * HASH_CHUNK_SIZE; i < end; i++) {
+                        std::string id = materialize(input.tokens[i]);
+                        batch.leaves[i] = fusion.voterHashFusion(id);
+                        batch.entries[i] = {HashFusion::toHex(batch.leaves[i]), std::move(id)};
+                    }
+                });
+                if (!hashed.push(std::move(batch))) {
+                    return;
+                }
+            }
+            hashed.finish();
+        } catch (...) {
+            fail(std::current_exception());
+        }
+    });
+
+    try {
+        Batch batch;
+        while (hashed.pop(batch)) {
+            if (!batch.entries.empty()) {
+                sink(batch);
+            }
+            progress.imported.fetch_add(batch.entries.size(), std::memory_order_relaxed);
+            progress.skipped.fetch_add(batch.skipped, std::memory_order_relaxed);
+            progress.bytesRead.store(batch.endOffset, std::memory_order_relaxed);
+        }
+    } catch (...) {
+        fail(std::current_exception());
+    }
+
+    parser.join();
+    hasher.join();
+    if (failure) {
+        std::rethrow_exception(failure);
+    }
+    progress.bytesRead.store(size, std::memory_order_relaxed);
+}
@@ -0,0 +1,652 @@
+#include "include/sha256.h"
+#include "include/metrics.h"
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <numeric>
+#include <random>
+#include <vector>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define SHA256_X86_KERNELS 1
+#include <immintrin.h>
+#endif
+
+const uint32_t Sha256::INITIAL_STATE[8] = {
+    0x6a09e667, 0xbb67ae85, 0x3c6ef372, 0xa54ff53a,
+    0x510e527f, 0x9b05688c, 0x1f83d9ab, 0x5be0cd19
+};
+
+static const uint32_t ROUND_CONSTANTS[64] = {
+    0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b, 0x59f111f1, 0x923f82a4, 0xab1c5ed5,
+    0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3, 0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174,
+    0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc, 0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+    0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7, 0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967,
+    0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13, 0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85,
+    0xa2bfe8a1, 0xa81a664b, 0xc24b8b70, 0xc76c51a3, 0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+    0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f, 0x682e6ff3,
+    0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208, 0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2
+};
+
+static inline uint32_t loadBigEndian(const uint8_t* p) {
+    return (uint32_t(p[0]) << 24) | (uint32_t(p[1]) << 16) | (uint32_t(p[2]) << 8) | uint32_t(p[3]);
+}
+
+static inline void storeBigEndian(uint8_t* p, uint32_t v) {
+    p[0] = uint8_t(v >> 24);
+    p[1] = uint8_t(v >> 16);
+    p[2] = uint8_t(v >> 8);
+    p[3] = uint8_t(v);
+}
+
+static inline uint32_t rotr(uint32_t x, int n) {
+    return (x >> n) | (x << (32 - n));
+}
+
+// Portable single-stream kernel
+static void compressScalar(uint32_t state[8], const uint8_t* blocks, size_t count) {
+    uint32_t w[64];
+    
+    for (; count > 0; count--, blocks += 64) {
+        for (int t = 0; t < 16; t++) {
+            w[t] = loadBigEndian(blocks + 4 * t);
+        }
+        for (int t = 16; t < 64; t++) {
+            uint32_t s0 = rotr(w[t - 15], 7) ^ rotr(w[t - 15], 18) ^ (w[t - 15] >> 3);
+            uint32_t s1 = rotr(w[t - 2], 17) ^ rotr(w[t - 2], 19) ^ (w[t - 2] >> 10);
+            w[t] = w[t - 16] + s0 + w[t - 7] + s1;
+        }
+        
+        uint32_t a = state[0], b = state[1], c = state[2], d = state[3];
+        uint32_t e = state[4], f = state[5], g = state[6], h = state[7];
+        
+        for (int t = 0; t < 64; t++) {
+            uint32_t s1 = rotr(e, 6) ^ rotr(e, 11) ^ rotr(e, 25);
+            uint32_t ch = (e & f) ^ (~e & g);
+            uint32_t t1 = h + s1 + ch + ROUND_CONSTANTS[t] + w[t];
+            uint32_t s0 = rotr(a, 2) ^ rotr(a, 13) ^ rotr(a, 22);
+            uint32_t maj = (a & b) ^ (a & c) ^ (b & c);
+            uint32_t t2 = s0 + maj;
+            
+            h = g; g = f; f = e; e = d + t1;
+            d = c; c = b; b = a; a = t1 + t2;
+        }
+        
+        state[0] += a; state[1] += b; state[2] += c; state[3] += d;
+        state[4] += e; state[5] += f; state[6] += g; state[7] += h;
+    }
+}
+
+// Portable multi-buffer kernel: state is [8][lanes], words [16][lanes]
+// (word-major), so the SIMD kernels can load one word of every lane at once
+static void compressLanesScalar(uint32_t* state, const uint32_t* words, size_t lanes) {
+    for (size_t lane = 0; lane < lanes; lane++) {
+        uint8_t block[64];
+        uint32_t laneState[8];
+        for (int t = 0; t < 16; t++) {
+            storeBigEndian(block + 4 * t, words[t * lanes + lane]);
+        }
+        for (int i = 0; i < 8; i++) {
+            laneState[i] = state[i * lanes + lane];
+        }
+        compressScalar(laneState, block, 1);
+        for (int i = 0; i < 8; i++) {
+            state[i * lanes + lane] = laneState[i];
+        }
+    }
+}
+
+#ifdef SHA256_X86_KERNELS
+
+// Single-stream kernel on the SHA extensions
+__attribute__((target("sha,sse4.1")))
+static void compressShaNi(uint32_t state[8], const uint8_t* blocks, size_t count) {
+    const __m128i byteSwap = _mm_set_epi64x(0x0c0d0e0f08090a0bULL, 0x0405060700010203ULL);
+    
+    __m128i tmp = _mm_loadu_si128(reinterpret_cast<const __m128i*>(&state[0]));
+    __m128i state1 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(&state[4]));
+    tmp = _mm_shuffle_epi32(tmp, 0xB1);                 // CDAB
+    state1 = _mm_shuffle_epi32(state1, 0x1B);           // EFGH
+    __m128i state0 = _mm_alignr_epi8(tmp, state1, 8);   // ABEF
+    state1 = _mm_blend_epi16(state1, tmp, 0xF0);        // CDGH
+    
+    for (; count > 0; count--, blocks += 64) {
+        __m128i abefSave = state0;
+        __m128i cdghSave = state1;
+        __m128i msg[4];
+        
+        for (int i = 0; i < 4; i++) {
+            msg[i] = _mm_shuffle_epi8(
+                _mm_loadu_si128(reinterpret_cast<const __m128i*>(blocks + 16 * i)), byteSwap);
+        }
+        
+        // Sixteen groups of four rounds; msg[i % 4] holds W[4i..4i+3]
+        for (int i = 0; i < 16; i++) {
+            __m128i& cur = msg[i & 3];
+            __m128i& next = msg[(i + 1) & 3];
+            __m128i& prev = msg[(i + 3) & 3];
+            
+            __m128i rounds = _mm_add_epi32(cur,
+                _mm_loadu_si128(reinterpret_cast<const __m128i*>(&ROUND_CONSTANTS[4 * i])));
+            state1 = _mm_sha256rnds2_epu32(state1, state0, rounds);
+            
+            if (i >= 3 && i <= 14) {
+                next = _mm_add_epi32(next, _mm_alignr_epi8(cur, prev, 4));
+                next = _mm_sha256msg2_epu32(next, cur);
+            }
+            
+            rounds = _mm_shuffle_epi32(rounds, 0x0E);
+            state0 = _mm_sha256rnds2_epu32(state0, state1, rounds);
+            
+            if (i >= 1 && i <= 12) {
+                prev = _mm_sha256msg1_epu32(prev, cur);
+            }
+        }
+        
+        state0 = _mm_add_epi32(state0, abefSave);
+        state1 = _mm_add_epi32(state1, cdghSave);
+    }
+    
+    tmp = _mm_shuffle_epi32(state0, 0x1B);              // FEBA
+    state1 = _mm_shuffle_epi32(state1, 0xB1);           // DCHG
+    state0 = _mm_blend_epi16(tmp, state1, 0xF0);        // DCBA
+    state1 = _mm_alignr_epi8(state1, tmp, 8);           // HGFE
+    
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(&state[0]), state0);
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(&state[4]), state1);
+}
+
+#define AVX2_ROTR(x, n) _mm256_or_si256(_mm256_srli_epi32((x), (n)), _mm256_slli_epi32((x), 32 - (n)))
+
+// Eight independent streams, one per 32-bit lane
+__attribute__((target("avx2")))
+static void compressLanesAvx2(uint32_t* state, const uint32_t* words, size_t) {
+    __m256i w[16];
+    __m256i s[8];
+    
+    for (int t = 0; t < 16; t++) {
+        w[t] = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(words + 8 * t));
+    }
+    for (int i = 0; i < 8; i++) {
+        s[i] = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(state + 8 * i));
+    }
+    
+    __m256i a = s[0], b = s[1], c = s[2], d = s[3];
+    __m256i e = s[4], f = s[5], g = s[6], h = s[7];
+    
+    for (int t = 0; t < 64; t++) {
+        __m256i wt;
+        if (t < 16) {
+            wt = w[t];
+        } else {
+            __m256i w15 = w[(t - 15) & 15];
+            __m256i w2 = w[(t - 2) & 15];
+            __m256i s0 = _mm256_xor_si256(_mm256_xor_si256(AVX2_ROTR(w15, 7), AVX2_ROTR(w15, 18)),
+                                          _mm256_srli_epi32(w15, 3));
+            __m256i s1 = _mm256_xor_si256(_mm256_xor_si256(AVX2_ROTR(w2, 17), AVX2_ROTR(w2, 19)),
+                                          _mm256_srli_epi32(w2, 10));
+            wt = _mm256_add_epi32(_mm256_add_epi32(w[t & 15], s0),
+                                  _mm256_add_epi32(w[(t - 7) & 15], s1));
+            w[t & 15] = wt;
+        }
+        
+        __m256i s1 = _mm256_xor_si256(_mm256_xor_si256(AVX2_ROTR(e, 6), AVX2_ROTR(e, 11)),
+                                      AVX2_ROTR(e, 25));
+        __m256i ch = _mm256_xor_si256(_mm256_and_si256(e, f), _mm256_andnot_si256(e, g));
+        __m256i t1 = _mm256_add_epi32(_mm256_add_epi32(h, s1),
+                                      _mm256_add_epi32(ch, _mm256_add_epi32(
+                                          _mm256_set1_epi32(static_cast<int>(ROUND_CONSTANTS[t])), wt)));
+        __m256i s0 = _mm256_xor_si256(_mm256_xor_si256(AVX2_ROTR(a, 2), AVX2_ROTR(a, 13)),
+                                      AVX2_ROTR(a, 22));
+        __m256i maj = _mm256_xor_si256(_mm256_and_si256(a, b),
+                                       _mm256_and_si256(c, _mm256_xor_si256(a, b)));
+        __m256i t2 = _mm256_add_epi32(s0, maj);
+        
+        h = g; g = f; f = e; e = _mm256_add_epi32(d, t1);
+        d = c; c = b; b = a; a = _mm256_add_epi32(t1, t2);
+    }
+    
+    s[0] = _mm256_add_epi32(s[0], a); s[1] = _mm256_add_epi32(s[1], b);
+    s[2] = _mm256_add_epi32(s[2], c); s[3] = _mm256_add_epi32(s[3], d);
+    s[4] = _mm256_add_epi32(s[4], e); s[5] = _mm256_add_epi32(s[5], f);
+    s[6] = _mm256_add_epi32(s[6], g); s[7] = _mm256_add_epi32(s[7], h);
+    
+    for (int i = 0; i < 8; i++) {
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(state + 8 * i), s[i]);
+    }
+}
+
+#undef AVX2_ROTR
+
+// GCC 12's AVX-512 headers trip -Wuninitialized on _mm512_undefined_epi32
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wuninitialized"
+#pragma GCC diagnostic ignored "-Wmaybe-uninitialized"
+
+// Sixteen independent streams; native rotates and ternary logic
+__attribute__((target("avx512f")))
+static void compressLanesAvx512(uint32_t* state, const uint32_t* words, size_t) {
+    __m512i w[16];
+    __m512i s[8];
+    
+    for (int t = 0; t < 16; t++) {
+        w[t] = _mm512_loadu_si512(words + 16 * t);
+    }
+    for (int i = 0; i < 8; i++) {
+        s[i] = _mm512_loadu_si512(state + 16 * i);
+    }
+    
+    __m512i a = s[0], b = s[1], c = s[2], d = s[3];
+    __m512i e = s[4], f = s[5], g = s[6], h = s[7];
+    
+    for (int t = 0; t < 64; t++) {
+        __m512i wt;
+        if (t < 16) {
+            wt = w[t];
+        } else {
+            __m512i w15 = w[(t - 15) & 15];
+            __m512i w2 = w[(t - 2) & 15];
+            __m512i s0 = _mm512_ternarylogic_epi32(_mm512_ror_epi32(w15, 7), _mm512_ror_epi32(w15, 18),
+                                                   _mm512_srli_epi32(w15, 3), 0x96);
+            __m512i s1 = _mm512_ternarylogic_epi32(_mm512_ror_epi32(w2, 17), _mm512_ror_epi32(w2, 19),
+                                                   _mm512_srli_epi32(w2, 10), 0x96);
+            wt = _mm512_add_epi32(_mm512_add_epi32(w[t & 15], s0),
+                                  _mm512_add_epi32(w[(t - 7) & 15], s1));
+            w[t & 15] = wt;
+        }
+        
+        __m512i s1 = _mm512_ternarylogic_epi32(_mm512_ror_epi32(e, 6), _mm512_ror_epi32(e, 11),
+                                               _mm512_ror_epi32(e, 25), 0x96);
+        __m512i ch = _mm512_ternarylogic_epi32(e, f, g, 0xCA);
+        __m512i t1 = _mm512_add_epi32(_mm512_add_epi32(h, s1),
+                                      _mm512_add_epi32(ch, _mm512_add_epi32(
+                                          _mm512_set1_epi32(static_cast<int>(ROUND_CONSTANTS[t])), wt)));
+        __m512i s0 = _mm512_ternarylogic_epi32(_mm512_ror_epi32(a, 2), _mm512_ror_epi32(a, 13),
+                                               _mm512_ror_epi32(a, 22), 0x96);
+        __m512i maj = _mm512_ternarylogic_epi32(a, b, c, 0xE8);
+        __m512i t2 = _mm512_add_epi32(s0, maj);
+        
+        h = g; g = f; f = e; e = _mm512_add_epi32(d, t1);
+        d = c; c = b; b = a; a = _mm512_add_epi32(t1, t2);
+    }
+    
+    s[0] = _mm512_add_epi32(s[0], a); s[1] = _mm512_add_epi32(s[1], b);
+    s[2] = _mm512_add_epi32(s[2], c); s[3] = _mm512_add_epi32(s[3], d);
+    s[4] = _mm512_add_epi32(s[4], e); s[5] = _mm512_add_epi32(s[5], f);
+    s[6] = _mm512_add_epi32(s[6], g); s[7] = _mm512_add_epi32(s[7], h);
+    
+    for (int i = 0; i < 8; i++) {
+        _mm512_storeu_si512(state + 16 * i, s[i]);
+    }
+}
+
+#pragma GCC diagnostic pop
+
+#endif // SHA256_X86_KERNELS
+
+// Runtime dispatch
+typedef void (*CompressFn)(uint32_t*, const uint8_t*, size_t);
+typedef void (*CompressLanesFn)(uint32_t*, const uint32_t*, size_t);
+
+static bool kernelSupported(Sha256::Kernel kernel) {
+    switch (kernel) {
+        case Sha256::SCALAR:
+            return true;
+#ifdef SHA256_X86_KERNELS
+        case Sha256::SHA_NI:
+            return __builtin_cpu_supports("sha") && __builtin_cpu_supports("sse4.1");
+        case Sha256::AVX2:
+            return __builtin_cpu_supports("avx2");
+        case Sha256::AVX512:
+            return __builtin_cpu_supports("avx512f");
+#endif
+        default:
+            return false;
+    }
+}
+
+static size_t laneCount(Sha256::Kernel kernel) {
+    switch (kernel) {
+        case Sha256::AVX512: return 16;
+        case Sha256::AVX2: return 8;
+        default: return 1;
+    }
+}
+
+struct Dispatch {
+    std::atomic<int> single;
+    std::atomic<int> batch;
+    
+    Dispatch() {
+        single = kernelSupported(Sha256::SHA_NI) ? Sha256::SHA_NI : Sha256::SCALAR;
+        // Eight AVX2 lanes only match one SHA-NI stream, so AVX2 is used
+        // for batches only when the SHA extensions are missing
+        batch = kernelSupported(Sha256::AVX512) ? Sha256::AVX512 :
+                single == Sha256::SHA_NI ? Sha256::SHA_NI :
+                kernelSupported(Sha256::AVX2) ? Sha256::AVX2 : Sha256::SCALAR;
+    }
+};
+
+static Dispatch& dispatch() {
+    static Dispatch instance;
+    return instance;
+}
+
+static CompressFn compressFn(Sha256::Kernel kernel) {
+#ifdef SHA256_X86_KERNELS
+    if (kernel == Sha256::SHA_NI) return compressShaNi;
+#else
+    (void)kernel;
+#endif
+    return compressScalar;
+}
+
+static CompressLanesFn compressLanesFn(Sha256::Kernel kernel) {
+#ifdef SHA256_X86_KERNELS
+    if (kernel == Sha256::AVX512) return compressLanesAvx512;
+    if (kernel == Sha256::AVX2) return compressLanesAvx2;
+#else
+    (void)kernel;
+#endif
+    return compressLanesScalar;
+}
+
+void Sha256::compress(uint32_t state[8], const uint8_t* blocks, size_t count) {
+    compressFn(singleKernel())(state, blocks, count);
+}
+
+Sha256::Kernel Sha256::singleKernel() {
+    return static_cast<Kernel>(dispatch().single.load(std::memory_order_relaxed));
+}
+
+Sha256::Kernel Sha256::batchKernel() {
+    return static_cast<Kernel>(dispatch().batch.load(std::memory_order_relaxed));
+}
+
+const char* Sha256::kernelName(Kernel kernel) {
+    switch (kernel) {
+        case SHA_NI: return "sha-ni";
+        case AVX2: return "avx2";
+        case AVX512: return "avx512";
+        default: return "scalar";
+    }
+}
+
+bool Sha256::setKernels(Kernel single, Kernel batch) {
+    if (laneCount(single) != 1 || !kernelSupported(single) || !kernelSupported(batch)) {
+        return false;
+    }
+    dispatch().single = single;
+    dispatch().batch = batch;
+    return true;
+}
+
+// Padded tail of one message: the last partial block plus padding
+struct MessageTail {
+    uint8_t bytes[128];
+    size_t fullBlocks;
+    size_t totalBlocks;
+    
+    void init(const uint8_t* data, size_t length) {
+        fullBlocks = length / 64;
+        size_t rest = length % 64;
+        size_t tailBlocks = rest < 56 ? 1 : 2;
+        totalBlocks = fullBlocks + tailBlocks;
+        
+        std::memset(bytes, 0, tailBlocks * 64);
+        if (rest > 0) {
+            std::memcpy(bytes, data + fullBlocks * 64, rest);
+        }
+        bytes[rest] = 0x80;
+        
+        uint64_t bits = static_cast<uint64_t>(length) * 8;
+        uint8_t* end = bytes + tailBlocks * 64;
+        for (int i = 1; i <= 8; i++) {
+            end[-i] = static_cast<uint8_t>(bits >> (8 * (i - 1)));
+        }
+    }
+    
+    const uint8_t* block(const uint8_t* data, size_t index) const {
+        return index < fullBlocks ? data + index * 64 : bytes + (index - fullBlocks) * 64;
+    }
+};
+
+void Sha256::hashMany(const uint8_t* const* data, const size_t* lengths,
+                      size_t count, Digest* out) {
+    TRIE_METRIC_COUNT(SHA256_HASHES, count);
+    Kernel kernel = batchKernel();
+    size_t lanes = laneCount(kernel);
+    
+    if (lanes == 1) {
+        for (size_t i = 0; i < count; i++) {
+            uint32_t state[8];
+            std::memcpy(state, INITIAL_STATE, sizeof(state));
+            MessageTail tail;
+            tail.init(data[i], lengths[i]);
+            compress(state, data[i], tail.fullBlocks);
+            compress(state, tail.bytes, tail.totalBlocks - tail.fullBlocks);
+            for (int w = 0; w < 8; w++) {
+                storeBigEndian(out[i].data() + 4 * w, state[w]);
+            }
+        }
+        return;
+    }
+    
+    CompressLanesFn compressLanes = compressLanesFn(kernel);
+    
+    // Group messages of equal block count so lanes finish together
+    std::vector<size_t> order(count);
+    std::iota(order.begin(), order.end(), 0);
+    std::stable_sort(order.begin(), order.end(), [&](size_t a, size_t b) {
+        return (lengths[a] + 8) / 64 < (lengths[b] + 8) / 64;
+    });
+    
+    std::vector<MessageTail> tails(lanes);
+    std::vector<uint32_t> state(8 * lanes);
+    std::vector<uint32_t> words(16 * lanes);
+    
+    for (size_t start = 0; start < count; start += lanes) {
+        size_t active = std::min(lanes, count - start);
+        size_t maxBlocks = 0;
+        
+        for (size_t lane = 0; lane < active; lane++) {
+            size_t message = order[start + lane];
+            tails[lane].init(data[message], lengths[message]);
+            maxBlocks = std::max(maxBlocks, tails[lane].totalBlocks);
+        }
+        for (size_t i = 0; i < 8; i++) {
+            std::fill(state.begin() + i * lanes, state.begin() + (i + 1) * lanes, INITIAL_STATE[i]);
+        }
+        
+        for (size_t blockIndex = 0; blockIndex < maxBlocks; blockIndex++) {
+            // Transpose into word-major order; idle lanes hash zeros
+            for (size_t lane = 0; lane < lanes; lane++) {
+                if (lane < active && blockIndex < tails[lane].totalBlocks) {
+                    const uint8_t* block = tails[lane].block(data[order[start + lane]], blockIndex);
+                    for (size_t t = 0; t < 16; t++) {
+                        words[t * lanes + lane] = loadBigEndian(block + 4 * t);
+                    }
+                } else {
+                    for (size_t t = 0; t < 16; t++) {
+                        words[t * lanes + lane] = 0;
+                    }
+                }
+            }
+            
+            compressLanes(state.data(), words.data(), lanes);
+            
+            for (size_t lane = 0; lane < active; lane++) {
+                if (tails[lane].totalBlocks == blockIndex + 1) {
+                    Digest& digest = out[order[start + lane]];
+                    for (size_t w = 0; w < 8; w++) {
+                        storeBigEndian(digest.data() + 4 * w, state[w * lanes + lane]);
+                    }
+                }
+            }
+        }
+    }
+}
+
+// Sha256Stream implementation
+Sha256Stream::Sha256Stream() : bufferLength(0), totalLength(0) {
+    std::memcpy(state, Sha256::INITIAL_STATE, sizeof(state));
+}
+
+Sha256Stream& Sha256Stream::update(const void* data, size_t length) {
+    const uint8_t* bytes = static_cast<const uint8_t*>(data);
+    totalLength += length;
+    
+    if (bufferLength > 0) {
+        size_t take = std::min(length, sizeof(buffer) - bufferLength);
+        std::memcpy(buffer + bufferLength, bytes, take);
+        bufferLength += take;
+        bytes += take;
+        length -= take;
+        
+        if (bufferLength < sizeof(buffer)) {
+            return *this;
+        }
+        Sha256::compress(state, buffer, 1);
+        bufferLength = 0;
+    }
+    
+    if (length >= 64) {
+        Sha256::compress(state, bytes, length / 64);
+        bytes += length & ~size_t(63);
+        length &= 63;
+    }
+    
+    std::memcpy(buffer, bytes, length);
+    bufferLength = length;
+    return *this;
+}
+
+Sha256Stream& Sha256Stream::update(const std::string& data) {
+    return update(data.data(), data.size());
+}
+
+Sha256Stream& Sha256Stream::update(char c) {
+    return update(&c, 1);
+}
+
+Sha256Stream& Sha256Stream::updateHex(const Digest& digest) {
+    static const char digits[] = "0123456789abcdef";
+    char hex[64];
+    for (size_t i = 0; i < digest.size(); i++) {
+        hex[2 * i] = digits[digest[i] >> 4];
+        hex[2 * i + 1] = digits[digest[i] & 0x0f];
+    }
+    return update(hex, sizeof(hex));
+}
+
+Digest Sha256Stream::finish() {
+    TRIE_METRIC_COUNT(SHA256_HASHES, 1);
+    uint64_t bits = totalLength * 8;
+    
+    buffer[bufferLength++] = 0x80;
+    if (bufferLength > 56) {
+        std::memset(buffer + bufferLength, 0, sizeof(buffer) - bufferLength);
+        Sha256::compress(state, buffer, 1);
+        bufferLength = 0;
+    }
+    std::memset(buffer + bufferLength, 0, 56 - bufferLength);
+    for (int i = 0; i < 8; i++) {
+        buffer[63 - i] = static_cast<uint8_t>(bits >> (8 * i));
+    }
+    Sha256::compress(state, buffer, 1);
+    
+    Digest digest;
+    for (int i = 0; i < 8; i++) {
+        storeBigEndian(digest.data() + 4 * i, state[i]);
+    }
+    return digest;
+}
+
+// Sha256Tail implementation
+Sha256Tail::Sha256Tail(size_t prefixBlocks, const std::string& suffix)
+    : prefixBlocks(prefixBlocks), tailBlocks(0) {
+    if (suffix.size() > MAX_INLINE_SUFFIX) {
+        longSuffix = suffix;
+        return;
+    }
+    
+    // suffix | 0x80 | zeros | 64-bit big-endian message length in bits
+    tailBlocks = (suffix.size() + 9 + 63) / 64;
+    size_t tailBytes = tailBlocks * 64;
+    uint64_t bits = (prefixBlocks * 64 + suffix.size()) * 8;
+    std::memset(blocks, 0, sizeof(blocks));
+    std::memcpy(blocks, suffix.data(), suffix.size());
+    blocks[suffix.size()] = 0x80;
+    for (int i = 0; i < 8; i++) {
+        blocks[tailBytes - 1 - i] = static_cast<uint8_t>(bits >> (8 * i));
+    }
+}
+
+Digest Sha256Tail::hash(const uint8_t* prefix) const {
+    if (tailBlocks == 0) {
+        return Sha256Stream().update(prefix, prefixBlocks * 64).update(longSuffix).finish();
+    }
+    
+    TRIE_METRIC_COUNT(SHA256_HASHES, 1);
+    uint32_t state[8];
+    std::memcpy(state, Sha256::INITIAL_STATE, sizeof(state));
+    Sha256::compress(state, prefix, prefixBlocks);
+    Sha256::compress(state, blocks, tailBlocks);
+    
+    Digest digest;
+    for (int i = 0; i < 8; i++) {
+        storeBigEndian(digest.data() + 4 * i, state[i]);
+    }
+    return digest;
+}
+
+static inline uint64_t rotl(uint64_t x, int n) {
+    return (x << n) | (x >> (64 - n));
+}
+
+static inline void sipRound(uint64_t& v0, uint64_t& v1, uint64_t& v2, uint64_t& v3) {
+    v0 += v1; v1 = rotl(v1, 13); v1 ^= v0; v0 = rotl(v0, 32);
+    v2 += v3; v3 = rotl(v3, 16); v3 ^= v2;
+    v0 += v3; v3 = rotl(v3, 21); v3 ^= v0;
+    v2 += v1; v1 = rotl(v1, 17); v1 ^= v2; v2 = rotl(v2, 32);
+}
+
+struct SipKey {
+    uint64_t k0, k1;
+    
+    SipKey() {
+        std::random_device device;
+        k0 = (uint64_t(device()) << 32) ^ device();
+        k1 = (uint64_t(device()) << 32) ^ device();
+    }
+};
+
+void DigestHash::keyed(const Digest& digest, uint64_t out[2]) {
+    static const SipKey key;
+    uint64_t v0 = key.k0 ^ 0x736f6d6570736575ULL;
+    uint64_t v1 = key.k1 ^ 0x646f72616e646f6dULL ^ 0xee;
+    uint64_t v2 = key.k0 ^ 0x6c7967656e657261ULL;
+    uint64_t v3 = key.k1 ^ 0x7465646279746573ULL;
+    
+    // Four message words, then the length-only final block
+    for (size_t offset = 0; offset <= sizeof(Digest); offset += 8) {
+        uint64_t word = uint64_t(sizeof(Digest)) << 56;
+        if (offset < sizeof(Digest)) {
+            std::memcpy(&word, digest.data() + offset, sizeof(word));
+        }
+        v3 ^= word;
+        sipRound(v0, v1, v2, v3);
+        v0 ^= word;
+    }
+    
+    v2 ^= 0xee;
+    sipRound(v0, v1, v2, v3);
+    sipRound(v0, v1, v2, v3);
+    sipRound(v0, v1, v2, v3);
+    out[0] = v0 ^ v1 ^ v2 ^ v3;
+    v1 ^= 0xdd;
+    sipRound(v0, v1, v2, v3);
+    sipRound(v0, v1, v2, v3);
+    sipRound(v0, v1, v2, v3);
+    out[1] = v0 ^ v1 ^ v2 ^ v3;
+}
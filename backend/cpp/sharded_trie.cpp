@@ -0,0 +1,193 @@
+#include "include/sharded_trie.h"
+#include "include/hash_fusion.h"
+#include "include/thread_pool.h"
+#include <algorithm>
+#include <mutex>
+
+template <typename HashPolicy>
+ShardedMerkleTrie<HashPolicy>::ShardedMerkleTrie(unsigned shardNibbles)
+    : shardNibbles(std::min(std::max(shardNibbles, 1u), MAX_SHARD_NIBBLES)) {
+    size_t count = size_t(1) << (4 * this->shardNibbles);
+    shards.reserve(count);
+    for (size_t i = 0; i < count; i++) {
+        shards.push_back(std::make_unique<Shard>());
+    }
+}
+
+template <typename HashPolicy>
+size_t ShardedMerkleTrie<HashPolicy>::shardOf(const std::string& key) const {
+    size_t shard = 0;
+    for (unsigned i = 0; i < shardNibbles; i++) {
+        unsigned char c = i < key.size() ? static_cast<unsigned char>(key[i]) : 0;
+        unsigned nibble;
+        if (c >= '0' && c <= '9') {
+            nibble = c - '0';
+        } else if (c >= 'a' && c <= 'f') {
+            nibble = c - 'a' + 10;
+        } else if (c >= 'A' && c <= 'F') {
+            nibble = c - 'A' + 10;
+        } else {
+            nibble = c & 15;
+        }
+        shard = (shard << 4) | nibble;
+    }
+    return shard;
+}
+
+template <typename HashPolicy>
+void ShardedMerkleTrie<HashPolicy>::insert(const std::string& key, const std::string& value) {
+    Shard& shard = *shards[shardOf(key)];
+    std::unique_lock<std::shared_mutex> lock(shard.mutex);
+    shard.trie.insert(key, value);
+}
+
+template <typename HashPolicy>
+void ShardedMerkleTrie<HashPolicy>::insertBatch(const std::vector<std::pair<std::string, std::string>>& entries) {
+    // Partition in input order, so later duplicates still win per shard
+    std::vector<std::vector<std::pair<std::string, std::string>>> parts(shards.size());
+    for (const auto& entry : entries) {
+        parts[shardOf(entry.first)].push_back(entry);
+    }
+    
+    ThreadPool::shared().parallelFor(shards.size(), [&](size_t i) {
+        if (parts[i].empty()) return;
+        std::unique_lock<std::shared_mutex> lock(shards[i]->mutex);
+        shards[i]->trie.insertBatch(parts[i]);
+    });
+}
+
+template <typename HashPolicy>
+bool ShardedMerkleTrie<HashPolicy>::search(const std::string& key) const {
+    const Shard& shard = *shards[shardOf(key)];
+    std::shared_lock<std::shared_mutex> lock(shard.mutex);
+    return shard.trie.search(key);
+}
+
+template <typename HashPolicy>
+std::string ShardedMerkleTrie<HashPolicy>::getValue(const std::string& key) const {
+    const Shard& shard = *shards[shardOf(key)];
+    std::shared_lock<std::shared_mutex> lock(shard.mutex);
+    return shard.trie.getValue(key);
+}
+
+template <typename HashPolicy>
+std::vector<Digest> ShardedMerkleTrie<HashPolicy>::shardRoots() const {
+    std::vector<Digest> roots;
+    roots.reserve(shards.size());
+    for (const auto& shard : shards) {
+        roots.push_back(shard->trie.view().getRootDigest());
+    }
+    return roots;
+}
+
+template <typename HashPolicy>
+Digest ShardedMerkleTrie<HashPolicy>::getRootDigest() const {
+    // Locks are always taken in shard order, so readers cannot deadlock
+    std::vector<std::shared_lock<std::shared_mutex>> locks;
+    locks.reserve(shards.size());
+    for (const auto& shard : shards) {
+        locks.emplace_back(shard->mutex);
+    }
+    return rootOf(shardRoots());
+}
+
+template <typename HashPolicy>
+std::string ShardedMerkleTrie<HashPolicy>::getRootHash() const {
+    return HashFusion::toHex(getRootDigest());
+}
+
+template <typename HashPolicy>
+size_t ShardedMerkleTrie<HashPolicy>::getSize() const {
+    size_t size = 0;
+    for (const auto& shard : shards) {
+        std::shared_lock<std::shared_mutex> lock(shard->mutex);
+        size += shard->trie.getSize();
+    }
+    return size;
+}
+
+template <typename HashPolicy>
+void ShardedMerkleTrie<HashPolicy>::clear() {
+    for (const auto& shard : shards) {
+        std::unique_lock<std::shared_mutex> lock(shard->mutex);
+        shard->trie = BasicMerkleTrie<HashPolicy>();
+    }
+}
+
+template <typename HashPolicy>
+bool ShardedMerkleTrie<HashPolicy>::getProof(const std::string& key, ShardedTrieProof& proof,
+                                             Digest& root) const {
+    std::vector<std::shared_lock<std::shared_mutex>> locks;
+    locks.reserve(shards.size());
+    for (const auto& shard : shards) {
+        locks.emplace_back(shard->mutex);
+    }
+    
+    size_t index = shardOf(key);
+    if (!shards[index]->trie.getTrieProof(key, proof.shardProof)) {
+        return false;
+    }
+    
+    std::vector<Digest> roots = shardRoots();
+    proof.shard = static_cast<uint32_t>(index);
+    proof.shardRoot = roots[index];
+    proof.shardPath = pathOf(roots, index);
+    root = rootOf(std::move(roots));
+    return true;
+}
+
+template <typename HashPolicy>
+bool ShardedMerkleTrie<HashPolicy>::verifyProof(const ShardedTrieProof& proof, const Digest& root) const {
+    if (proof.shard != shardOf(proof.shardProof.key) || proof.shardPath.size() != 4 * shardNibbles) {
+        return false;
+    }
+    if (!BasicMerkleTrie<HashPolicy>::verifyTrieProof(proof.shardProof, proof.shardRoot)) {
+        return false;
+    }
+    
+    // Bit k of the shard number says which side the node is on at level k
+    Digest node = proof.shardRoot;
+    for (size_t level = 0; level < proof.shardPath.size(); level++) {
+        const Digest& sibling = proof.shardPath[level];
+        node = (proof.shard >> level) & 1 ? combineOrdered(sibling, node) : combineOrdered(node, sibling);
+    }
+    return node == root;
+}
+
+template <typename HashPolicy>
+Digest ShardedMerkleTrie<HashPolicy>::combineOrdered(const Digest& left, const Digest& right) {
+    typename HashPolicy::Stream stream;
+    HashPolicy::updateDigest(stream, left);
+    HashPolicy::updateDigest(stream, right);
+    return stream.finish();
+}
+
+template <typename HashPolicy>
+Digest ShardedMerkleTrie<HashPolicy>::rootOf(std::vector<Digest> level) {
+    // The shard count is a power of two, so every level pairs up exactly
+    while (level.size() > 1) {
+        for (size_t i = 0; i < level.size() / 2; i++) {
+            level[i] = combineOrdered(level[2 * i], level[2 * i + 1]);
+        }
+        level.resize(level.size() / 2);
+    }
+    return level[0];
+}
+
+template <typename HashPolicy>
+std::vector<Digest> ShardedMerkleTrie<HashPolicy>::pathOf(std::vector<Digest> level, size_t index) {
+    std::vector<Digest> path;
+    while (level.size() > 1) {
+        path.push_back(level[index ^ 1]);
+        for (size_t i = 0; i < level.size() / 2; i++) {
+            level[i] = combineOrdered(level[2 * i], level[2 * i + 1]);
+        }
+        level.resize(level.size() / 2);
+        index >>= 1;
+    }
+    return path;
+}
+
+template class ShardedMerkleTrie<Sha256HexPolicy>;
+template class ShardedMerkleTrie<Keccak256Policy>;
+template class ShardedMerkleTrie<Blake2bPolicy>;
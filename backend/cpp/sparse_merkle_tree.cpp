@@ -0,0 +1,371 @@
+#include "include/sparse_merkle_tree.h"
+#include "include/thread_pool.h"
+#include <algorithm>
+#include <array>
+
+static const Digest ZERO_DIGEST = {};
+
+// Bit i of a key, most significant bit of byte 0 first; it picks the
+// child at depth i + 1
+static inline unsigned keyBit(const Digest& key, size_t i) {
+    return (key[i >> 3] >> (7 - (i & 7))) & 1;
+}
+
+// Number of leading bits two keys share
+static size_t commonPrefix(const Digest& a, const Digest& b) {
+    for (size_t i = 0; i < a.size(); i++) {
+        uint8_t diff = a[i] ^ b[i];
+        if (diff) {
+            return 8 * i + (__builtin_clz(diff) - 24);
+        }
+    }
+    return 8 * a.size();
+}
+
+template <typename HashPolicy>
+Digest SparseMerkleTree<HashPolicy>::hashPair(const Digest& left, const Digest& right) {
+    typename HashPolicy::Stream stream;
+    HashPolicy::updateDigest(stream, left);
+    HashPolicy::updateDigest(stream, right);
+    return stream.finish();
+}
+
+template <typename HashPolicy>
+Digest SparseMerkleTree<HashPolicy>::leafHash(const Digest& key) {
+    return HashPolicy::hash(key.data(), key.size());
+}
+
+template <typename HashPolicy>
+const Digest& SparseMerkleTree<HashPolicy>::defaultNode(size_t height) {
+    static const std::array<Digest, DEPTH + 1> defaults = [] {
+        std::array<Digest, DEPTH + 1> levels;
+        levels[0] = ZERO_DIGEST;
+        for (size_t h = 0; h < DEPTH; h++) {
+            levels[h + 1] = hashPair(levels[h], levels[h]);
+        }
+        return levels;
+    }();
+    return defaults[height];
+}
+
+template <typename HashPolicy>
+Digest SparseMerkleTree<HashPolicy>::hashChain(Digest digest, size_t fromHeight, size_t toHeight,
+                                               const Digest& key) {
+    // The node at height h sits at depth DEPTH - h, on the side given by
+    // key bit DEPTH - h - 1; its sibling is empty
+    for (size_t h = fromHeight; h < toHeight; h++) {
+        digest = keyBit(key, DEPTH - 1 - h) ? hashPair(defaultNode(h), digest)
+                                            : hashPair(digest, defaultNode(h));
+    }
+    return digest;
+}
+
+template <typename HashPolicy>
+SparseMerkleTree<HashPolicy>::SparseMerkleTree() {
+    clear();
+}
+
+template <typename HashPolicy>
+void SparseMerkleTree<HashPolicy>::clear() {
+    nodes.clear();
+    keys.clear();
+    keyCount = 0;
+    newNode(DEPTH, 0);
+    nodes[ROOT].hash = defaultNode(DEPTH);
+    nodes[ROOT].flags = 0;
+}
+
+template <typename HashPolicy>
+uint32_t SparseMerkleTree<HashPolicy>::newNode(uint16_t height, uint32_t keyIndex) {
+    Node node;
+    node.children[0] = NIL;
+    node.children[1] = NIL;
+    node.keyIndex = keyIndex;
+    node.height = height;
+    node.flags = DIRTY;
+    nodes.push_back(node);
+    return static_cast<uint32_t>(nodes.size() - 1);
+}
+
+template <typename HashPolicy>
+size_t SparseMerkleTree<HashPolicy>::memoryBytes() const {
+    return nodes.capacity() * sizeof(Node) + keys.capacity() * sizeof(Digest);
+}
+
+template <typename HashPolicy>
+bool SparseMerkleTree<HashPolicy>::contains(const Digest& key) const {
+    uint32_t node = ROOT;
+    while (true) {
+        uint32_t child = nodes[node].children[keyBit(key, DEPTH - nodes[node].height)];
+        if (child == NIL) {
+            return false;
+        }
+        if (nodes[child].height == 0) {
+            return keyOf(child) == key;
+        }
+        if (commonPrefix(key, keyOf(child)) < DEPTH - nodes[child].height) {
+            return false;
+        }
+        node = child;
+    }
+}
+
+template <typename HashPolicy>
+void SparseMerkleTree<HashPolicy>::insertPath(const Digest& key) {
+    uint32_t keyIndex = static_cast<uint32_t>(keys.size());
+    keys.push_back(key);
+    keyCount++;
+
+    uint32_t node = ROOT;
+    while (true) {
+        nodes[node].flags |= DIRTY;
+        size_t depth = DEPTH - nodes[node].height;
+        unsigned bit = keyBit(key, depth);
+        uint32_t child = nodes[node].children[bit];
+
+        if (child == NIL) {
+            uint32_t leaf = newNode(0, keyIndex);
+            nodes[node].children[bit] = leaf;
+            return;
+        }
+
+        size_t common = commonPrefix(key, keyOf(child));
+        if (common >= DEPTH - nodes[child].height) {
+            node = child;
+            continue;
+        }
+
+        // The key leaves the child's edge at depth common: split the edge
+        // with a branch point there. The child's own hash is unchanged,
+        // but its edge now ends lower, so it is rehashed too.
+        uint32_t leaf = newNode(0, keyIndex);
+        uint32_t branch = newNode(static_cast<uint16_t>(DEPTH - common), keyIndex);
+        unsigned leafSide = keyBit(key, common);
+        nodes[branch].children[leafSide] = leaf;
+        nodes[branch].children[1 - leafSide] = child;
+        nodes[child].flags |= DIRTY;
+        nodes[node].children[bit] = branch;
+        return;
+    }
+}
+
+template <typename HashPolicy>
+bool SparseMerkleTree<HashPolicy>::insert(const Digest& key) {
+    if (contains(key)) {
+        return false;
+    }
+    insertPath(key);
+    rehashDirty();
+    return true;
+}
+
+template <typename HashPolicy>
+size_t SparseMerkleTree<HashPolicy>::insertBatch(const std::vector<Digest>& batch) {
+    std::vector<Digest> sorted(batch);
+    std::sort(sorted.begin(), sorted.end());
+    sorted.erase(std::unique(sorted.begin(), sorted.end()), sorted.end());
+
+    size_t added = 0;
+    for (const auto& key : sorted) {
+        if (!contains(key)) {
+            insertPath(key);
+            added++;
+        }
+    }
+    if (added > 0) {
+        rehashDirty();
+    }
+    return added;
+}
+
+template <typename HashPolicy>
+void SparseMerkleTree<HashPolicy>::collectDirtyLeaves(uint32_t node,
+                                                      std::vector<std::pair<uint32_t, uint16_t>>& leaves) {
+    for (uint32_t child : nodes[node].children) {
+        if (child == NIL || !(nodes[child].flags & DIRTY)) {
+            continue;
+        }
+        if (nodes[child].height == 0) {
+            leaves.emplace_back(child, nodes[node].height);
+        } else {
+            collectDirtyLeaves(child, leaves);
+        }
+    }
+}
+
+template <typename HashPolicy>
+void SparseMerkleTree<HashPolicy>::rehashBranches(uint32_t node, uint16_t parentHeight) {
+    Node& current = nodes[node];
+    if (!(current.flags & DIRTY)) {
+        return;
+    }
+
+    if (current.height > 0) {
+        Digest sides[2];
+        for (unsigned side = 0; side < 2; side++) {
+            uint32_t child = current.children[side];
+            if (child == NIL) {
+                sides[side] = defaultNode(current.height - 1);
+            } else {
+                rehashBranches(child, current.height);
+                sides[side] = nodes[child].edgeHash;
+            }
+        }
+        current.hash = hashPair(sides[0], sides[1]);
+        if (node != ROOT) {
+            current.edgeHash = hashChain(current.hash, current.height, parentHeight - 1,
+                                         keyOf(node));
+        }
+    }
+    current.flags &= ~DIRTY;
+}
+
+template <typename HashPolicy>
+void SparseMerkleTree<HashPolicy>::hashLeafChains(const std::pair<uint32_t, uint16_t>* leaves,
+                                                  size_t count) {
+    // The chains advance one height at a time in lockstep, so each step
+    // is one batch on the policy's multi-buffer hash
+    const size_t encoded = HashPolicy::ENCODED_DIGEST_SIZE;
+    std::vector<Digest> digests(count);
+    std::vector<char> inputs(count * 2 * encoded);
+    std::vector<const uint8_t*> data(count);
+    std::vector<size_t> lengths(count, 2 * encoded);
+    std::vector<size_t> active(count);
+    std::vector<Digest> out(count);
+    
+    size_t top = 0;
+    for (size_t i = 0; i < count; i++) {
+        digests[i] = leafHash(keys[nodes[leaves[i].first].keyIndex]);
+        nodes[leaves[i].first].hash = digests[i];
+        top = std::max<size_t>(top, leaves[i].second - 1);
+    }
+    
+    for (size_t h = 0; h < top; h++) {
+        size_t lanes = 0;
+        for (size_t i = 0; i < count; i++) {
+            if (h + 1 >= leaves[i].second) {
+                continue;
+            }
+            const Digest& key = keys[nodes[leaves[i].first].keyIndex];
+            char* input = inputs.data() + lanes * 2 * encoded;
+            bool right = keyBit(key, DEPTH - 1 - h);
+            HashPolicy::encodeDigest(right ? defaultNode(h) : digests[i], input);
+            HashPolicy::encodeDigest(right ? digests[i] : defaultNode(h), input + encoded);
+            data[lanes] = reinterpret_cast<const uint8_t*>(input);
+            active[lanes++] = i;
+        }
+        
+        HashPolicy::hashMany(data.data(), lengths.data(), lanes, out.data());
+        for (size_t lane = 0; lane < lanes; lane++) {
+            digests[active[lane]] = out[lane];
+        }
+    }
+    
+    for (size_t i = 0; i < count; i++) {
+        Node& leaf = nodes[leaves[i].first];
+        leaf.edgeHash = digests[i];
+        leaf.flags &= ~DIRTY;
+    }
+}
+
+template <typename HashPolicy>
+void SparseMerkleTree<HashPolicy>::rehashDirty() {
+    // A new leaf's chain is nearly the whole height of the tree, so the
+    // chains are the bulk of the work and independent of each other
+    std::vector<std::pair<uint32_t, uint16_t>> leaves;
+    collectDirtyLeaves(ROOT, leaves);
+
+    size_t chunks = (leaves.size() + LEAF_CHUNK_SIZE - 1) / LEAF_CHUNK_SIZE;
+    ThreadPool::shared().parallelFor(chunks, [&](size_t chunk) {
+        size_t begin = chunk * LEAF_CHUNK_SIZE;
+        size_t count = std::min(LEAF_CHUNK_SIZE, leaves.size() - begin);
+        hashLeafChains(leaves.data() + begin, count);
+    });
+    
+    rehashBranches(ROOT, 0);
+}
+
+template <typename HashPolicy>
+bool SparseMerkleTree<HashPolicy>::getProof(const Digest& key, SparseMerkleProof& proof) const {
+    proof.key = key;
+    proof.included = false;
+    proof.bitmap = ZERO_DIGEST;
+    proof.siblings.clear();
+
+    auto addSibling = [&](size_t depth, const Digest& sibling) {
+        proof.bitmap[depth >> 3] |= static_cast<uint8_t>(0x80 >> (depth & 7));
+        proof.siblings.push_back(sibling);
+    };
+
+    uint32_t node = ROOT;
+    while (true) {
+        size_t depth = DEPTH - nodes[node].height;
+        unsigned bit = keyBit(key, depth);
+        uint32_t other = nodes[node].children[1 - bit];
+        if (other != NIL) {
+            addSibling(depth, nodes[other].edgeHash);
+        }
+
+        uint32_t child = nodes[node].children[bit];
+        if (child == NIL) {
+            return false;
+        }
+
+        size_t common = commonPrefix(key, keyOf(child));
+        size_t childDepth = DEPTH - nodes[child].height;
+        if (common >= childDepth) {
+            if (nodes[child].height == 0) {
+                proof.included = true;
+                return true;
+            }
+            node = child;
+            continue;
+        }
+
+        // key turns off the child's edge at depth common; the chain up to
+        // just below that point is the only non-empty sibling left
+        addSibling(common, hashChain(nodes[child].hash, nodes[child].height,
+                                     DEPTH - common - 1, keyOf(child)));
+        return false;
+    }
+}
+
+template <typename HashPolicy>
+std::vector<SparseMerkleProof> SparseMerkleTree<HashPolicy>::getProofs(
+        const std::vector<Digest>& batch) const {
+    std::vector<SparseMerkleProof> proofs(batch.size());
+    size_t chunks = (batch.size() + PROOF_CHUNK_SIZE - 1) / PROOF_CHUNK_SIZE;
+
+    ThreadPool::shared().parallelFor(chunks, [&](size_t chunk) {
+        size_t end = std::min(batch.size(), (chunk + 1) * PROOF_CHUNK_SIZE);
+        for (size_t i = chunk * PROOF_CHUNK_SIZE; i < end; i++) {
+            getProof(batch[i], proofs[i]);
+        }
+    });
+
+    return proofs;
+}
+
+template <typename HashPolicy>
+bool SparseMerkleTree<HashPolicy>::verifyProof(const SparseMerkleProof& proof, const Digest& root) {
+    Digest computed = proof.included ? leafHash(proof.key) : ZERO_DIGEST;
+    size_t next = proof.siblings.size();
+
+    for (size_t i = DEPTH; i-- > 0;) {
+        size_t height = DEPTH - 1 - i;
+        const Digest* sibling = &defaultNode(height);
+        if (keyBit(proof.bitmap, i)) {
+            if (next == 0) {
+                return false;
+            }
+            sibling = &proof.siblings[--next];
+        }
+        computed = keyBit(proof.key, i) ? hashPair(*sibling, computed) : hashPair(computed, *sibling);
+    }
+
+    return next == 0 && computed == root;
+}
+
+template class SparseMerkleTree<Sha256HexPolicy>;
+template class SparseMerkleTree<Keccak256Policy>;
+template class SparseMerkleTree<Blake2bPolicy>;
@@ -0,0 +1,156 @@
+// Known-answer vectors for the hash engines. Expected digests come from
+// Python's hashlib (SHA-256, BLAKE2b) and a reference Keccak matching
+// Ethereum's keccak256 on "" and "abc"; the lengths straddle each
+// engine's block size.
+
+#include <gtest/gtest.h>
+#include "blake2b.h"
+#include "hash_fusion.h"
+#include "keccak.h"
+#include "sha256.h"
+#include <algorithm>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Bytes i % 251 for i in [0, length)
+static std::vector<uint8_t> pattern(size_t length) {
+    std::vector<uint8_t> bytes(length);
+    for (size_t i = 0; i < length; i++) {
+        bytes[i] = static_cast<uint8_t>(i % 251);
+    }
+    return bytes;
+}
+
+struct Vector {
+    size_t length;      // pattern length, or SIZE_MAX for "abc"
+    const char* digest;
+};
+
+static std::vector<uint8_t> input(const Vector& vector) {
+    if (vector.length == SIZE_MAX) {
+        return std::vector<uint8_t>{'a', 'b', 'c'};
+    }
+    return pattern(vector.length);
+}
+
+TEST(HashVectors, Keccak256) {
+    const Vector vectors[] = {
+        {0, "c5d2460186f7233c927e7db2dcc703c0e500b653ca82273b7bfad8045d85a470"},
+        {SIZE_MAX, "4e03657aea45a94fc7d47ba826c8d667c0d1e6e33a64a036ec44f58fa12d6c45"},
+        {128, "ed4c9adc183fb8cb025b1500ec3eeae1b45517314441a187605de1bb8a64726e"},
+        {135, "cbdfd9dee5faad3818d6b06f95a219fd290b0e1706f6a82e5a595b9ce9faca62"},
+        {136, "7ce759f1ab7f9ce437719970c26b0a66ff11fe3e38e17df89cf5d29c7d7f807e"},
+        {300, "4699841dafd5e26cca72b05a41d38c96b4b468e5a6cbf694cbebe77dacdf6528"},
+    };
+    for (const Vector& vector : vectors) {
+        std::vector<uint8_t> data = input(vector);
+        EXPECT_EQ(HashFusion::toHex(Keccak256Stream::hash(data.data(), data.size())), vector.digest)
+            << "length " << data.size();
+    }
+}
+
+TEST(HashVectors, Blake2b256) {
+    const Vector vectors[] = {
+        {0, "0e5751c026e543b2e8ab2eb06099daa1d1e5df47778f7787faab45cdf12fe3a8"},
+        {SIZE_MAX, "bddd813c634239723171ef3fee98579b94964e3bb1cb3e427262c8c068d52319"},
+        {128, "c3582f71ebb2be66fa5dd750f80baae97554f3b015663c8be377cfcb2488c1d1"},
+        {135, "f7c4efacc0a4cb5836f170ea0bf5dc5ce36fe2d88e76a9f259eaab71aef0ff13"},
+        {136, "6a35d3dadc62dfe7819519f92181b2f8d38f5e0ed3d51a22cf8a133ab628d6f4"},
+        {300, "940563f11807c8ba3192299e05cf544b82463742c8a5e80c2a5d81751cd8b0ca"},
+    };
+    for (const Vector& vector : vectors) {
+        std::vector<uint8_t> data = input(vector);
+        EXPECT_EQ(HashFusion::toHex(Blake2bStream::hash(data.data(), data.size())), vector.digest)
+            << "length " << data.size();
+    }
+}
+
+TEST(HashVectors, Blake2b512) {
+    std::vector<uint8_t> data = pattern(300);
+    uint8_t out[Blake2bStream::MAX_OUTPUT];
+    Blake2bStream stream(Blake2bStream::MAX_OUTPUT);
+    stream.update(data.data(), data.size());
+    stream.finish(out);
+    EXPECT_EQ(HashFusion::hexEncode(std::vector<uint8_t>(out, out + sizeof(out))),
+              "3a482b7748b0bdc43c3d00c080890c10e57a9aa5618f78b86067eb7eaae4942a"
+              "cd96d827accbc16958364ae5b0df6105bbd3b15445092eba1137b5f69c1070f1");
+}
+
+TEST(HashVectors, Sha256) {
+    const Vector vectors[] = {
+        {SIZE_MAX, "ba7816bf8f01cfea414140de5dae2223b00361a396177a9cb410ff61f20015ad"},
+        {300, "43f9b5d59eb108817176c6f65c2c6203a22f2ae8bc28b7a1dde45947678c5042"},
+    };
+    for (const Vector& vector : vectors) {
+        std::vector<uint8_t> data = input(vector);
+        EXPECT_EQ(HashFusion::toHex(HashFusion::sha256Digest(data.data(), data.size())), vector.digest)
+            << "length " << data.size();
+    }
+}
+
+// Every kernel the host accepts must agree with the scalar one, on
+// batches whose lanes mix lengths either side of the padding boundaries
+TEST(HashVectors, Sha256KernelsMatchScalar) {
+    const size_t lengths[] = {0, 55, 56, 63, 64, 119, 120, 300};
+    std::vector<std::vector<uint8_t>> messages;
+    for (size_t i = 0; i < 37; i++) {
+        std::vector<uint8_t> message = pattern(lengths[(i * 5) % 8] + i / 8 * 64);
+        if (!message.empty()) {
+            message[0] ^= static_cast<uint8_t>(i);
+        }
+        messages.push_back(message);
+    }
+    std::vector<const uint8_t*> data;
+    std::vector<size_t> sizes;
+    for (const auto& message : messages) {
+        data.push_back(message.data());
+        sizes.push_back(message.size());
+    }
+
+    Sha256::Kernel single = Sha256::singleKernel();
+    Sha256::Kernel batch = Sha256::batchKernel();
+    ASSERT_TRUE(Sha256::setKernels(Sha256::SCALAR, Sha256::SCALAR));
+    std::vector<Digest> expected(messages.size());
+    HashFusion::sha256Batch(data.data(), sizes.data(), messages.size(), expected.data());
+
+    const Sha256::Kernel kernels[] = {Sha256::SCALAR, Sha256::SHA_NI, Sha256::AVX2, Sha256::AVX512};
+    for (Sha256::Kernel one : kernels) {
+        for (Sha256::Kernel many : kernels) {
+            if (!Sha256::setKernels(one, many)) {
+                continue;
+            }
+            SCOPED_TRACE(std::string(Sha256::kernelName(one)) + " / " + Sha256::kernelName(many));
+            
+            // Every batch size up to the whole set, so lanes run partly empty
+            for (size_t count = 1; count <= messages.size(); count++) {
+                std::vector<Digest> out(count);
+                HashFusion::sha256Batch(data.data(), sizes.data(), count, out.data());
+                for (size_t i = 0; i < count; i++) {
+                    ASSERT_EQ(out[i], expected[i]) << "message " << i << " of " << count;
+                }
+            }
+            for (size_t i = 0; i < messages.size(); i++) {
+                EXPECT_EQ(HashFusion::sha256Digest(data[i], sizes[i]), expected[i]) << "message " << i;
+            }
+        }
+    }
+    Sha256::setKernels(single, batch);
+}
+
+// Feeding the same bytes in uneven pieces must not change the digest
+TEST(HashVectors, StreamsMatchOneShot) {
+    std::vector<uint8_t> data = pattern(300);
+    const size_t pieces[] = {1, 7, 64, 128, 135, 136, 137};
+    for (size_t piece : pieces) {
+        Keccak256Stream keccak;
+        Blake2bStream blake2b;
+        for (size_t offset = 0; offset < data.size(); offset += piece) {
+            size_t length = std::min(piece, data.size() - offset);
+            keccak.update(data.data() + offset, length);
+            blake2b.update(data.data() + offset, length);
+        }
+        EXPECT_EQ(keccak.finish(), Keccak256Stream::hash(data.data(), data.size())) << "piece " << piece;
+        EXPECT_EQ(blake2b.finish(), Blake2bStream::hash(data.data(), data.size())) << "piece " << piece;
+    }
+}
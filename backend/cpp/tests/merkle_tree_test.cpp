@@ -0,0 +1,233 @@
+// The stateful Merkle tree against a level-by-level build over the whole
+// leaf list: sorted-pair hashing, an odd node carried up unchanged, the
+// layout the contract and merkletreejs (sortPairs) expect.
+
+#include <gtest/gtest.h>
+#include "hash_fusion.h"
+#include "merkle_tree.h"
+#include <algorithm>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace {
+
+template <typename HashPolicy>
+std::vector<std::vector<Digest>> referenceLevels(const std::vector<Digest>& leaves) {
+    std::vector<std::vector<Digest>> levels = {leaves};
+    while (levels.back().size() > 1) {
+        const std::vector<Digest>& level = levels.back();
+        std::vector<Digest> parents;
+        for (size_t i = 0; i < level.size(); i += 2) {
+            parents.push_back(i + 1 < level.size() ? HashPolicy::combine(level[i], level[i + 1]) : level[i]);
+        }
+        levels.push_back(parents);
+    }
+    return levels;
+}
+
+template <typename HashPolicy>
+Digest referenceRoot(const std::vector<Digest>& leaves) {
+    return leaves.empty() ? Digest() : referenceLevels<HashPolicy>(leaves).back()[0];
+}
+
+template <typename HashPolicy>
+std::vector<Digest> referenceProof(const std::vector<Digest>& leaves, size_t index) {
+    std::vector<Digest> proof;
+    for (const auto& level : referenceLevels<HashPolicy>(leaves)) {
+        if ((index ^ 1) < level.size()) {
+            proof.push_back(level[index ^ 1]);
+        }
+        index /= 2;
+    }
+    return proof;
+}
+
+std::vector<Digest> randomLeaves(size_t count, uint32_t seed) {
+    std::mt19937 random(seed);
+    std::vector<Digest> leaves(count);
+    for (Digest& leaf : leaves) {
+        for (uint8_t& byte : leaf) {
+            byte = static_cast<uint8_t>(random());
+        }
+    }
+    return leaves;
+}
+
+template <typename HashPolicy>
+void expectMatchesReference() {
+    std::vector<Digest> leaves = randomLeaves(70, 11);
+
+    // One at a time, through every size including the capacity doublings
+    MerkleTree<HashPolicy> single;
+    EXPECT_EQ(single.getRoot(), Digest());
+    for (size_t i = 0; i < leaves.size(); i++) {
+        EXPECT_EQ(single.append(leaves[i]), i);
+        std::vector<Digest> present(leaves.begin(), leaves.begin() + i + 1);
+        ASSERT_EQ(single.getRoot(), referenceRoot<HashPolicy>(present)) << present.size() << " leaves";
+    }
+
+    // Uneven batches and the one-shot constructor land on the same tree
+    MerkleTree<HashPolicy> batched;
+    for (size_t first = 0, step = 1; first < leaves.size(); first += step, step += 3) {
+        size_t last = std::min(leaves.size(), first + step);
+        batched.append(std::vector<Digest>(leaves.begin() + first, leaves.begin() + last));
+        ASSERT_EQ(batched.getRoot(), referenceRoot<HashPolicy>(
+            std::vector<Digest>(leaves.begin(), leaves.begin() + last)));
+    }
+    EXPECT_EQ(MerkleTree<HashPolicy>(leaves).getRoot(), single.getRoot());
+    EXPECT_EQ(MerkleTree<HashPolicy>::computeRoot(leaves), single.getRoot());
+
+    for (size_t i = 0; i < leaves.size(); i++) {
+        std::vector<Digest> proof = single.getProof(i);
+        EXPECT_EQ(proof, referenceProof<HashPolicy>(leaves, i)) << "leaf " << i;
+        EXPECT_EQ(MerkleTree<HashPolicy>::computeProof(leaves, i), proof);
+        EXPECT_TRUE(MerkleTree<HashPolicy>::verifyProof(leaves[i], proof, single.getRoot()));
+        EXPECT_FALSE(MerkleTree<HashPolicy>::verifyProof(leaves[(i + 1) % leaves.size()], proof,
+                                                         single.getRoot()));
+    }
+    EXPECT_TRUE(single.getProof(leaves.size()).empty());
+}
+
+// OpenZeppelin's MerkleProof.processMultiProof, written out from the
+// contract source
+Digest processMultiProof(const MerkleMultiProof& multiProof) {
+    const std::vector<Digest>& leaves = multiProof.leaves;
+    const std::vector<Digest>& proof = multiProof.proof;
+    size_t totalHashes = multiProof.proofFlags.size();
+    if (leaves.size() + proof.size() != totalHashes + 1) {
+        return Digest();
+    }
+
+    std::vector<Digest> hashes(totalHashes);
+    size_t leafPos = 0, hashPos = 0, proofPos = 0;
+    for (size_t i = 0; i < totalHashes; i++) {
+        Digest a = leafPos < leaves.size() ? leaves[leafPos++] : hashes[hashPos++];
+        Digest b;
+        if (multiProof.proofFlags[i]) {
+            b = leafPos < leaves.size() ? leaves[leafPos++] : hashes[hashPos++];
+        } else if (proofPos < proof.size()) {
+            b = proof[proofPos++];
+        } else {
+            return Digest();
+        }
+        hashes[i] = Keccak256Policy::combine(a, b);
+    }
+    if (totalHashes > 0) {
+        return proofPos == proof.size() ? hashes[totalHashes - 1] : Digest();
+    }
+    return leaves.empty() ? proof[0] : leaves[0];
+}
+
+} // namespace
+
+TEST(MerkleTree, Sha256MatchesReference) {
+    expectMatchesReference<Sha256HexPolicy>();
+}
+
+TEST(MerkleTree, KeccakMatchesReference) {
+    expectMatchesReference<Keccak256Policy>();
+}
+
+TEST(MerkleTree, KeccakPairsAreEncodePacked) {
+    // keccak256(abi.encodePacked(a, b)) with the smaller digest first
+    std::vector<Digest> leaves = randomLeaves(2, 12);
+    Digest low = std::min(leaves[0], leaves[1]), high = std::max(leaves[0], leaves[1]);
+    uint8_t packed[64];
+    std::copy(low.begin(), low.end(), packed);
+    std::copy(high.begin(), high.end(), packed + 32);
+    EXPECT_EQ(MerkleTree<Keccak256Policy>(leaves).getRoot(), Keccak256Stream::hash(packed, sizeof(packed)));
+}
+
+TEST(MerkleTree, IndexOfAndLegacyProof) {
+    std::vector<Digest> leaves = randomLeaves(21, 13);
+    MerkleTree<Sha256HexPolicy> tree(leaves);
+    std::vector<std::string> hexLeaves;
+    for (const Digest& leaf : leaves) {
+        hexLeaves.push_back(HashFusion::toHex(leaf));
+    }
+
+    for (size_t i = 0; i < leaves.size(); i++) {
+        EXPECT_EQ(tree.indexOf(leaves[i]), i);
+        std::vector<std::string> legacy = HashFusion::generateMerkleProof(hexLeaves, hexLeaves[i]);
+        std::vector<Digest> proof = tree.getProof(i);
+        ASSERT_EQ(legacy.size(), proof.size());
+        for (size_t j = 0; j < proof.size(); j++) {
+            EXPECT_EQ(legacy[j], HashFusion::toHex(proof[j]));
+        }
+    }
+    EXPECT_EQ(tree.indexOf(randomLeaves(1, 14)[0]), MerkleTree<Sha256HexPolicy>::NOT_FOUND);
+}
+
+TEST(MerkleTree, MultiProofsVerify) {
+    std::mt19937 random(15);
+    for (size_t count = 1; count <= 40; count++) {
+        std::vector<Digest> leaves = randomLeaves(count, 16 + count);
+        MerkleTree<Keccak256Policy> tree(leaves);
+        Digest root = tree.getRoot();
+
+        for (size_t trial = 0; trial < 8; trial++) {
+            std::vector<size_t> indices;
+            size_t singleProofs = 0;
+            for (size_t i = 0; i < count; i++) {
+                if (random() % 3 == 0) {
+                    indices.push_back(i);
+                    singleProofs += tree.getProof(i).size();
+                }
+            }
+            if (indices.empty()) {
+                continue;
+            }
+            SCOPED_TRACE(std::to_string(indices.size()) + " of " + std::to_string(count));
+
+            MerkleMultiProof multi = tree.getMultiProof(indices);
+            EXPECT_EQ(multi.indices, indices);
+            EXPECT_LE(multi.proof.size(), singleProofs);
+            EXPECT_TRUE(MerkleTree<Keccak256Policy>::verifyMultiProof(multi, root));
+            EXPECT_FALSE(MerkleTree<Keccak256Policy>::verifyMultiProof(multi, randomLeaves(1, 1)[0]));
+
+            // Power-of-two trees always take OpenZeppelin's flags, and
+            // flags marked compatible reproduce the root there
+            if ((count & (count - 1)) == 0) {
+                EXPECT_TRUE(multi.contractCompatible);
+            }
+            if (multi.contractCompatible) {
+                EXPECT_EQ(processMultiProof(multi), root);
+            }
+
+            MerkleMultiProof tampered = multi;
+            tampered.leaves[0][0] ^= 1;
+            EXPECT_FALSE(MerkleTree<Keccak256Policy>::verifyMultiProof(tampered, root));
+            if (!multi.proof.empty()) {
+                tampered = multi;
+                tampered.proof.pop_back();
+                EXPECT_FALSE(MerkleTree<Keccak256Policy>::verifyMultiProof(tampered, root));
+            }
+            tampered = multi;
+            tampered.proof.push_back(root);
+            EXPECT_FALSE(MerkleTree<Keccak256Policy>::verifyMultiProof(tampered, root));
+        }
+    }
+}
+
+TEST(MerkleTree, MultiProofNormalisesIndices) {
+    std::vector<Digest> leaves = randomLeaves(13, 17);
+    MerkleTree<Sha256HexPolicy> tree(leaves);
+
+    // Unsorted, repeated and out-of-range indices
+    MerkleMultiProof multi = tree.getMultiProof({9, 2, 9, 40, 2, 5});
+    EXPECT_EQ(multi.indices, (std::vector<size_t>{2, 5, 9}));
+    EXPECT_EQ(multi.leafCount, leaves.size());
+    EXPECT_TRUE(MerkleTree<Sha256HexPolicy>::verifyMultiProof(multi, tree.getRoot()));
+
+    // Every leaf needs no siblings at all
+    std::vector<size_t> all(leaves.size());
+    for (size_t i = 0; i < all.size(); i++) {
+        all[i] = i;
+    }
+    multi = tree.getMultiProof(all);
+    EXPECT_TRUE(multi.proof.empty());
+    EXPECT_TRUE(MerkleTree<Sha256HexPolicy>::verifyMultiProof(multi, tree.getRoot()));
+
+    EXPECT_TRUE(tree.getMultiProof({13, 14}).indices.empty());
+}
@@ -0,0 +1,350 @@
+// The arena trie against a straightforward one-node-per-character trie
+// hashed the way the original shared_ptr implementation did: a node is
+// sha256(value + (char + hex child hash)... + "END"), children in byte
+// order, and the flat proof lists the siblings' hashes level by level.
+
+#include <gtest/gtest.h>
+#include "hash_fusion.h"
+#include "merkle_trie.h"
+#include <map>
+#include <memory>
+#include <random>
+#include <set>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace {
+
+class LegacyTrie {
+public:
+    void insert(const std::string& key, const std::string& value) {
+        Node* node = &root;
+        node->stale = true;
+        for (char c : key) {
+            std::unique_ptr<Node>& child = node->children[static_cast<unsigned char>(c)];
+            if (!child) {
+                child.reset(new Node());
+            }
+            node = child.get();
+            node->stale = true;
+        }
+        node->endOfWord = true;
+        node->value = value;
+    }
+
+    std::string rootHash() const { return hash(root); }
+
+    std::vector<std::string> proof(const std::string& key) const {
+        std::vector<std::string> siblings;
+        const Node* node = &root;
+        for (char c : key) {
+            auto next = node->children.find(static_cast<unsigned char>(c));
+            if (next == node->children.end()) {
+                return siblings;
+            }
+            for (const auto& child : node->children) {
+                if (child.first != next->first) {
+                    siblings.push_back(hash(*child.second));
+                }
+            }
+            node = next->second.get();
+        }
+        return siblings;
+    }
+
+private:
+    struct Node {
+        std::map<unsigned char, std::unique_ptr<Node>> children;
+        std::string value;
+        bool endOfWord = false;
+        // Cached hash, recomputed after an insert below the node
+        mutable std::string hash;
+        mutable bool stale = true;
+    };
+
+    Node root;
+
+    static const std::string& hash(const Node& node) {
+        if (!node.stale) {
+            return node.hash;
+        }
+        std::string combined = node.value;
+        for (const auto& child : node.children) {
+            combined += static_cast<char>(child.first);
+            combined += hash(*child.second);
+        }
+        if (node.endOfWord) {
+            combined += "END";
+        }
+        node.hash = HashFusion::sha256(combined);
+        node.stale = false;
+        return node.hash;
+    }
+};
+
+typedef std::vector<std::pair<std::string, std::string>> Entries;
+
+// Hex voter hashes plus short keys over a few bytes, so keys share
+// prefixes, end inside other keys' edges and use bytes above 0x7f
+Entries randomEntries(size_t count, uint32_t seed) {
+    std::mt19937 random(seed);
+    const char alphabet[] = {'a', 'b', 'c', '\x7f', '\x80', '\xff'};
+    Entries entries;
+    for (size_t i = 0; i < count; i++) {
+        std::string key;
+        if (i % 3 == 0) {
+            uint32_t n = random();
+            key = HashFusion::toHex(HashFusion::sha256Digest(&n, sizeof(n)));
+        } else {
+            size_t length = random() % 7;
+            for (size_t j = 0; j < length; j++) {
+                key.push_back(alphabet[random() % sizeof(alphabet)]);
+            }
+        }
+        entries.emplace_back(key, "value-" + std::to_string(random() % 1000));
+    }
+    return entries;
+}
+
+} // namespace
+
+TEST(MerkleTrie, EmptyRootMatchesLegacy) {
+    EXPECT_EQ(MerkleTrie().getRootHash(), LegacyTrie().rootHash());
+}
+
+TEST(MerkleTrie, InsertMatchesLegacyRoot) {
+    MerkleTrie trie;
+    LegacyTrie legacy;
+    for (const auto& entry : randomEntries(300, 1)) {
+        trie.insert(entry.first, entry.second);
+        legacy.insert(entry.first, entry.second);
+        ASSERT_EQ(trie.getRootHash(), legacy.rootHash()) << "after " << entry.first;
+    }
+}
+
+TEST(MerkleTrie, BatchAndBulkLoadMatchLegacyRoot) {
+    // Large enough for the level-by-level rehash
+    Entries entries = randomEntries(2000, 2);
+    LegacyTrie legacy;
+    for (const auto& entry : entries) {
+        legacy.insert(entry.first, entry.second);
+    }
+
+    MerkleTrie batched;
+    batched.insertBatch(Entries(entries.begin(), entries.begin() + 1000));
+    batched.insertBatch(Entries(entries.begin() + 1000, entries.end()));
+    EXPECT_EQ(batched.getRootHash(), legacy.rootHash());
+    EXPECT_EQ(MerkleTrie(entries).getRootHash(), legacy.rootHash());
+}
+
+TEST(MerkleTrie, FlatProofsMatchLegacy) {
+    MerkleTrie trie;
+    LegacyTrie legacy;
+    Entries entries = randomEntries(500, 3);
+    for (const auto& entry : entries) {
+        trie.insert(entry.first, entry.second);
+        legacy.insert(entry.first, entry.second);
+    }
+    for (const auto& entry : entries) {
+        EXPECT_EQ(trie.getMerkleProof(entry.first), legacy.proof(entry.first)) << entry.first;
+    }
+    EXPECT_EQ(trie.getMerkleProof("abz"), legacy.proof("abz"));
+}
+
+TEST(MerkleTrie, TrieProofsVerify) {
+    MerkleTrie trie(randomEntries(500, 4));
+    Digest root = trie.view().getRootDigest();
+
+    for (const auto& entry : randomEntries(500, 4)) {
+        TrieProof proof;
+        ASSERT_TRUE(trie.getTrieProof(entry.first, proof));
+        EXPECT_TRUE(MerkleTrie::verifyTrieProof(proof, root));
+
+        proof.levels.back().value += "x";
+        EXPECT_FALSE(MerkleTrie::verifyTrieProof(proof, root));
+    }
+}
+
+TEST(MerkleTrie, VersionsKeepTheirRoots) {
+    Entries entries = randomEntries(600, 5);
+    MerkleTrie trie;
+    LegacyTrie legacy;
+    std::vector<std::pair<MerkleTrie::Version, std::string>> versions;
+    for (size_t i = 0; i < entries.size(); i++) {
+        trie.insert(entries[i].first, entries[i].second);
+        legacy.insert(entries[i].first, entries[i].second);
+        if (i % 100 == 99) {
+            versions.emplace_back(trie.commit(), legacy.rootHash());
+        }
+    }
+
+    trie.releaseVersion(versions[1].first);
+    trie.collectGarbage();
+    for (size_t i = 0; i < versions.size(); i++) {
+        TrieView view;
+        if (i == 1) {
+            EXPECT_FALSE(trie.view(versions[i].first, view));
+            continue;
+        }
+        ASSERT_TRUE(trie.view(versions[i].first, view));
+        EXPECT_EQ(HashFusion::toHex(view.getRootDigest()), versions[i].second);
+    }
+    EXPECT_EQ(trie.getRootHash(), legacy.rootHash());
+}
+
+TEST(MerkleTrie, RollbackRestoresTrie) {
+    Entries entries = randomEntries(400, 6);
+    for (bool committed : {false, true}) {
+        MerkleTrie trie(Entries(entries.begin(), entries.begin() + 200));
+        if (committed) {
+            trie.commit();
+        }
+        std::string root = trie.getRootHash();
+        size_t size = trie.getSize();
+
+        trie.savepoint();
+        trie.insertBatch(Entries(entries.begin() + 200, entries.begin() + 300));
+        trie.insert(entries[300].first, entries[300].second);
+        trie.rollback();
+        EXPECT_EQ(trie.getRootHash(), root);
+        EXPECT_EQ(trie.getSize(), size);
+        for (size_t i = 0; i < 200; i++) {
+            ASSERT_TRUE(trie.search(entries[i].first)) << entries[i].first;
+        }
+
+        // The restored trie keeps taking inserts like one never touched
+        MerkleTrie fresh(Entries(entries.begin(), entries.begin() + 200));
+        trie.insertBatch(Entries(entries.begin() + 300, entries.end()));
+        fresh.insertBatch(Entries(entries.begin() + 300, entries.end()));
+        EXPECT_EQ(trie.getRootHash(), fresh.getRootHash());
+    }
+}
+
+TEST(MerkleTrie, RollbackUnderFrozenSubtree) {
+    // "a999" is a writable sibling ahead of the frozen "b123"; thawing
+    // "b123" for "b456" relinks it, and rollback has to undo that
+    MerkleTrie small;
+    small.insert("b123", "1");
+    small.commit();
+    small.insert("a999", "2");
+    std::string root = small.getRootHash();
+    small.savepoint();
+    small.insert("b456", "3");
+    small.rollback();
+    EXPECT_EQ(small.getRootHash(), root);
+    EXPECT_TRUE(small.search("b123"));
+    EXPECT_TRUE(small.search("a999"));
+    EXPECT_FALSE(small.search("b456"));
+
+    // Same, with writable and frozen siblings mixed throughout
+    Entries entries = randomEntries(400, 7);
+    MerkleTrie trie(Entries(entries.begin(), entries.begin() + 150));
+    trie.commit();
+    trie.insertBatch(Entries(entries.begin() + 150, entries.begin() + 250));
+    root = trie.getRootHash();
+
+    trie.savepoint();
+    EXPECT_THROW(trie.commit(), std::runtime_error);
+    EXPECT_THROW(trie.collectGarbage(), std::runtime_error);
+    for (size_t i = 250; i < 300; i++) {
+        trie.insert(entries[i].first, entries[i].second);
+    }
+    trie.insertBatch(Entries(entries.begin() + 300, entries.end()));
+    trie.rollback();
+
+    EXPECT_EQ(trie.getRootHash(), root);
+    LegacyTrie legacy;
+    for (size_t i = 0; i < 250; i++) {
+        legacy.insert(entries[i].first, entries[i].second);
+    }
+    for (size_t i = 0; i < 250; i++) {
+        ASSERT_TRUE(trie.search(entries[i].first)) << entries[i].first;
+        TrieProof proof;
+        ASSERT_TRUE(trie.getTrieProof(entries[i].first, proof));
+        EXPECT_TRUE(MerkleTrie::verifyTrieProof(proof, trie.view().getRootDigest()));
+    }
+    trie.commit();
+    EXPECT_EQ(trie.getRootHash(), legacy.rootHash());
+}
+
+TEST(MerkleTrie, SizeIsMaintained) {
+    // Repeated keys overwrite without counting twice
+    Entries entries = randomEntries(800, 8);
+    std::set<std::string> keys;
+    MerkleTrie trie;
+    for (size_t i = 0; i < 400; i++) {
+        trie.insert(entries[i].first, entries[i].second);
+        keys.insert(entries[i].first);
+        ASSERT_EQ(trie.getSize(), keys.size()) << "after " << i;
+    }
+    MerkleTrie::Version version = trie.commit();
+    size_t committed = keys.size();
+    for (size_t i = 400; i < entries.size(); i += 100) {
+        Entries batch(entries.begin() + i, entries.begin() + i + 100);
+        trie.insertBatch(batch);
+        for (const auto& entry : batch) {
+            keys.insert(entry.first);
+        }
+        ASSERT_EQ(trie.getSize(), keys.size()) << "after " << i + 100;
+    }
+
+    std::vector<std::string> all = trie.getAllKeys();
+    EXPECT_EQ(all.size(), keys.size());
+    EXPECT_EQ(std::set<std::string>(all.begin(), all.end()), keys);
+    TrieView view;
+    ASSERT_TRUE(trie.view(version, view));
+    EXPECT_EQ(view.getSize(), committed);
+    EXPECT_EQ(MerkleTrie(entries).getSize(), keys.size());
+}
+
+TEST(MerkleTrie, ListKeysPagesInByteOrder) {
+    // Short keys end inside other keys' edges; the empty key is left out
+    // because an empty cursor means "from the first key"
+    std::set<std::string> keys;
+    MerkleTrie trie;
+    for (const auto& entry : randomEntries(1500, 9)) {
+        if (!entry.first.empty()) {
+            trie.insert(entry.first, entry.second);
+            keys.insert(entry.first);
+        }
+    }
+
+    const std::string prefixes[] = {"", "a", "ab", "\x80", "\xff\xff", "3", "3f", "abcabcabc"};
+    for (const std::string& prefix : prefixes) {
+        std::vector<std::string> expected;
+        for (const std::string& key : keys) {
+            if (key.compare(0, prefix.size(), prefix) == 0) {
+                expected.push_back(key);
+            }
+        }
+
+        for (size_t limit : {1, 7, 50, 5000}) {
+            std::vector<std::string> listed;
+            std::string cursor;
+            while (true) {
+                std::vector<std::string> page = trie.listKeys(prefix, cursor, limit);
+                ASSERT_LE(page.size(), limit);
+                listed.insert(listed.end(), page.begin(), page.end());
+                if (page.size() < limit) {
+                    break;
+                }
+                cursor = page.back();
+            }
+            EXPECT_EQ(listed, expected) << "prefix of " << prefix.size() << ", limit " << limit;
+        }
+
+        // A cursor that is no key resumes at the next key after it
+        for (const std::string& cursor : {std::string("b"), std::string("a\x80"), prefix + "\x7f"}) {
+            std::vector<std::string> after;
+            for (const std::string& key : expected) {
+                if (key > cursor) {
+                    after.push_back(key);
+                }
+            }
+            EXPECT_EQ(trie.listKeys(prefix, cursor, keys.size()), after);
+        }
+    }
+    EXPECT_TRUE(trie.listKeys("", "", 0).empty());
+}
@@ -0,0 +1,143 @@
+// Spent-nullifier sets: exact membership through table growth and Bloom
+// rebuilds, including ground nullifiers that share all but their last
+// bytes, and one winner per nullifier when shards are hit concurrently.
+
+#include <gtest/gtest.h>
+#include "nullifier_set.h"
+#include <atomic>
+#include <random>
+#include <thread>
+#include <vector>
+
+namespace {
+
+std::vector<Digest> randomNullifiers(size_t count, uint32_t seed) {
+    std::mt19937 random(seed);
+    std::vector<Digest> nullifiers(count);
+    for (Digest& nullifier : nullifiers) {
+        for (uint8_t& byte : nullifier) {
+            byte = static_cast<uint8_t>(random());
+        }
+    }
+    return nullifiers;
+}
+
+// Equal in the first 24 bytes, counting up in the last eight
+std::vector<Digest> groundNullifiers(size_t count) {
+    std::vector<Digest> nullifiers(count);
+    for (size_t i = 0; i < count; i++) {
+        nullifiers[i].fill(0xab);
+        for (size_t byte = 0; byte < 8; byte++) {
+            nullifiers[i][31 - byte] = static_cast<uint8_t>(i >> (8 * byte));
+        }
+    }
+    return nullifiers;
+}
+
+} // namespace
+
+TEST(NullifierSet, GrowsWithoutLosingEntries) {
+    NullifierSet set;
+    size_t initial = set.capacity();
+    std::vector<Digest> spent = randomNullifiers(20000, 1);
+    std::vector<Digest> fresh = randomNullifiers(20000, 2);
+
+    for (size_t i = 0; i < spent.size(); i++) {
+        ASSERT_TRUE(set.insert(spent[i])) << i;
+        // Right after each growth the rebuilt filter must still hold all
+        if (set.capacity() != initial) {
+            initial = set.capacity();
+            for (size_t j = 0; j <= i; j++) {
+                ASSERT_TRUE(set.contains(spent[j])) << j << " after growing to " << initial;
+            }
+        }
+    }
+    EXPECT_EQ(set.size(), spent.size());
+    EXPECT_LE(set.size() * 100, set.capacity() * 70);
+
+    for (const Digest& nullifier : spent) {
+        EXPECT_FALSE(set.insert(nullifier));
+    }
+    for (const Digest& nullifier : fresh) {
+        EXPECT_FALSE(set.contains(nullifier));
+    }
+    EXPECT_EQ(set.size(), spent.size());
+}
+
+TEST(NullifierSet, GroundAndZeroNullifiers) {
+    NullifierSet set(16);
+    std::vector<Digest> ground = groundNullifiers(5000);
+    for (const Digest& nullifier : ground) {
+        ASSERT_TRUE(set.insert(nullifier));
+    }
+    for (const Digest& nullifier : ground) {
+        EXPECT_TRUE(set.contains(nullifier));
+    }
+
+    // The all-zero digest is the empty-slot marker and kept aside
+    Digest zero = Digest();
+    EXPECT_FALSE(set.contains(zero));
+    EXPECT_TRUE(set.insert(zero));
+    EXPECT_FALSE(set.insert(zero));
+    EXPECT_TRUE(set.contains(zero));
+    EXPECT_EQ(set.size(), ground.size() + 1);
+
+    set.clear();
+    EXPECT_EQ(set.size(), 0u);
+    EXPECT_FALSE(set.contains(zero));
+    EXPECT_FALSE(set.contains(ground[0]));
+    EXPECT_TRUE(set.insert(ground[0]));
+}
+
+TEST(ShardedNullifierSet, InsertManyFlagsRepeats) {
+    ShardedNullifierSet set;
+    std::vector<Digest> nullifiers = randomNullifiers(3000, 3);
+    for (size_t i = 0; i < 1000; i++) {
+        ASSERT_TRUE(set.insert(nullifiers[i]));
+    }
+
+    // Earlier spends, fresh ones, and repeats within the batch
+    std::vector<Digest> batch(nullifiers.begin() + 500, nullifiers.end());
+    batch.insert(batch.end(), nullifiers.begin() + 2000, nullifiers.begin() + 2100);
+    std::vector<uint8_t> fresh(batch.size());
+    set.insertMany(batch.data(), batch.size(), fresh.data());
+    for (size_t i = 0; i < batch.size(); i++) {
+        EXPECT_EQ(fresh[i], i >= 500 && i < 2500 ? 1 : 0) << i;
+    }
+    EXPECT_EQ(set.size(), nullifiers.size());
+    for (const Digest& nullifier : nullifiers) {
+        EXPECT_TRUE(set.contains(nullifier));
+    }
+
+    set.clear();
+    EXPECT_EQ(set.size(), 0u);
+    EXPECT_FALSE(set.contains(nullifiers[0]));
+}
+
+TEST(ShardedNullifierSet, ConcurrentSpendsHaveOneWinner) {
+    ShardedNullifierSet set;
+    std::vector<Digest> nullifiers = randomNullifiers(4000, 4);
+    std::atomic<size_t> accepted(0);
+
+    // Every thread offers every nullifier, half singly and half in batches
+    std::vector<std::thread> threads;
+    for (size_t t = 0; t < 4; t++) {
+        threads.emplace_back([&, t]() {
+            size_t won = 0;
+            std::vector<uint8_t> fresh(nullifiers.size() / 2);
+            set.insertMany(nullifiers.data() + (t % 2) * fresh.size(), fresh.size(), fresh.data());
+            for (uint8_t added : fresh) {
+                won += added;
+            }
+            for (size_t i = 0; i < fresh.size(); i++) {
+                won += set.insert(nullifiers[(1 - t % 2) * fresh.size() + i]);
+            }
+            accepted += won;
+        });
+    }
+    for (std::thread& thread : threads) {
+        thread.join();
+    }
+    EXPECT_EQ(accepted, nullifiers.size());
+    EXPECT_EQ(set.size(), nullifiers.size());
+}
@@ -0,0 +1,151 @@
+// Roll import edge cases: RFC 4180 quoting, CRLF and blank lines,
+// headers and BOMs, fixed-width trimming and truncation, with the same
+// IDs in file order whatever the batch size.
+
+#include <gtest/gtest.h>
+#include "roll_import.h"
+#include <cstdio>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include <unistd.h>
+
+namespace {
+
+class RollImportTest : public testing::Test {
+protected:
+    std::string path;
+    FusionContext fusion = FusionContext("salt", 1700000000);
+
+    void SetUp() override {
+        path = testing::TempDir() + "roll_test_" + std::to_string(::getpid()) + "_" +
+               testing::UnitTest::GetInstance()->current_test_info()->name();
+    }
+
+    void TearDown() override {
+        std::remove(path.c_str());
+    }
+
+    void write(const std::string& contents) {
+        FILE* file = std::fopen(path.c_str(), "wb");
+        ASSERT_NE(file, nullptr);
+        std::fwrite(contents.data(), 1, contents.size(), file);
+        std::fclose(file);
+    }
+
+    // Imported IDs in sink order, checked against their hashes, at every
+    // batch size given; skipped gets the skipped row count
+    std::vector<std::string> import(const RollFormat& format, size_t& skipped,
+                                    std::vector<size_t> batchSizes = {1, 2, 1000}) {
+        RollFile file(path);
+        std::vector<std::string> first;
+        for (size_t batchRecords : batchSizes) {
+            std::vector<std::string> ids;
+            RollProgress progress;
+            RollImporter importer(file, format, batchRecords, 2);
+            importer.run(fusion, [&](RollImporter::Batch& batch) {
+                EXPECT_LE(batch.entries.size(), batchRecords);
+                for (size_t i = 0; i < batch.entries.size(); i++) {
+                    EXPECT_EQ(batch.leaves[i], HashFusion::voterHashFusionDigest(batch.entries[i].second,
+                                                                                 "salt", 1700000000));
+                    EXPECT_EQ(batch.entries[i].first, HashFusion::toHex(batch.leaves[i]));
+                    ids.push_back(batch.entries[i].second);
+                }
+            }, progress);
+
+            EXPECT_EQ(progress.bytesRead, file.size());
+            EXPECT_EQ(progress.totalBytes, file.size());
+            EXPECT_EQ(progress.imported, ids.size());
+            if (batchRecords == batchSizes.front()) {
+                first = ids;
+                skipped = progress.skipped;
+            } else {
+                EXPECT_EQ(ids, first) << "batches of " << batchRecords;
+                EXPECT_EQ(progress.skipped, skipped) << "batches of " << batchRecords;
+            }
+        }
+        return first;
+    }
+};
+
+typedef std::vector<std::string> Ids;
+
+} // namespace
+
+TEST_F(RollImportTest, CsvQuotingAndLineEndings) {
+    write("\xEF\xBB\xBF" "name,voter_id,ward\r\n"
+          "Ann,V001,3\r\n"
+          "\r\n"
+          "\"Smith, Bob\",V002,4\n"
+          "Cy,\"V0\"\"03\",5\r\n"
+          "Di,\"V004\nsecond line\",6\n"
+          "\n"
+          "Ed,,7\n"
+          "Flo\n"
+          "Gus,\"V007\"  ,8\n"
+          "Hal,V008\r");
+    size_t skipped;
+    EXPECT_EQ(import(RollFormat::csv(1, ',', true), skipped),
+              (Ids{"V001", "V002", "V0\"03", "V004\nsecond line", "V007", "V008"}));
+    // The empty field and the row without the column
+    EXPECT_EQ(skipped, 2u);
+}
+
+TEST_F(RollImportTest, CsvHeaderWithQuotedNewline) {
+    write("\"voter\nid\";ward\nV1;1\nV2;2");
+    size_t skipped;
+    EXPECT_EQ(import(RollFormat::csv(0, ';', true), skipped), (Ids{"V1", "V2"}));
+    EXPECT_EQ(import(RollFormat::csv(0, ';', false), skipped), (Ids{"voter\nid", "V1", "V2"}));
+    EXPECT_EQ(skipped, 0u);
+}
+
+TEST_F(RollImportTest, CsvTabDelimitedLastColumn) {
+    write("a\tV1\nb\tV2\r\nc\t\"V3\"\r\n\td\n");
+    size_t skipped;
+    EXPECT_EQ(import(RollFormat::csv(1, '\t'), skipped), (Ids{"V1", "V2", "V3", "d"}));
+    EXPECT_EQ(skipped, 0u);
+}
+
+TEST_F(RollImportTest, FixedWidthTrimsAndSkips) {
+    // 12-byte records, the ID in bytes 2..10; the last record is cut short
+    std::string roll;
+    roll += std::string("xx  V001  yy", 12);
+    roll += std::string("xxV0002\0\0\0yy", 12);
+    roll += std::string("xx        yy", 12);
+    roll += std::string("xx\0\0\0\0\0\0\0\0yy", 12);
+    roll += std::string("xxV003 V004yy", 12);
+    roll += std::string("xxV005", 6);
+    write(roll);
+    size_t skipped;
+    EXPECT_EQ(import(RollFormat::fixedWidth(12, 2, 8), skipped), (Ids{"V001", "V0002", "V003 V00"}));
+    EXPECT_EQ(skipped, 3u);
+}
+
+TEST_F(RollImportTest, EmptyRollImportsNothing) {
+    write("");
+    size_t skipped;
+    EXPECT_TRUE(import(RollFormat::csv(0, ',', true), skipped).empty());
+    EXPECT_EQ(skipped, 0u);
+    EXPECT_TRUE(import(RollFormat::fixedWidth(4, 0, 4), skipped).empty());
+}
+
+TEST_F(RollImportTest, RejectsBadLayoutsAndSinkFailures) {
+    write("V1\nV2\nV3\n");
+    RollFile file(path);
+    EXPECT_THROW(RollImporter(file, RollFormat::fixedWidth(8, 4, 5)), std::runtime_error);
+    EXPECT_THROW(RollImporter(file, RollFormat::fixedWidth(0, 0, 0)), std::runtime_error);
+    EXPECT_THROW(RollImporter(file, RollFormat::csv(0, '"')), std::runtime_error);
+    EXPECT_THROW(RollFile(path + ".missing"), std::runtime_error);
+
+    // A throwing sink stops the pipeline; batches sunk before it stay sunk
+    RollImporter importer(file, RollFormat::csv(), 1, 1);
+    RollProgress progress;
+    size_t sunk = 0;
+    EXPECT_THROW(importer.run(fusion, [&](RollImporter::Batch&) {
+        if (++sunk == 2) {
+            throw std::runtime_error("sink failed");
+        }
+    }, progress), std::runtime_error);
+    EXPECT_EQ(sunk, 2u);
+    EXPECT_EQ(progress.imported, 1u);
+}
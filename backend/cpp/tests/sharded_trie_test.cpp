@@ -0,0 +1,129 @@
+// The sharded registry against separate tries per leading hex prefix,
+// combined in a complete binary tree that hashes left then right, and
+// proofs that only verify at the position their shard number names.
+
+#include <gtest/gtest.h>
+#include "hash_fusion.h"
+#include "sharded_trie.h"
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace {
+
+typedef std::vector<std::pair<std::string, std::string>> Entries;
+
+Entries voterEntries(size_t count, uint32_t seed) {
+    Entries entries;
+    for (uint32_t i = 0; i < count; i++) {
+        uint32_t n = seed * 100000 + i;
+        entries.emplace_back(HashFusion::toHex(HashFusion::sha256Digest(&n, sizeof(n))),
+                             "voter-" + std::to_string(i));
+    }
+    return entries;
+}
+
+size_t prefixShard(const std::string& key, unsigned nibbles) {
+    return std::stoul(key.substr(0, nibbles), nullptr, 16);
+}
+
+// sha256 over the hex of both children, left first, up to one root
+Digest referenceRoot(const Entries& entries, unsigned nibbles) {
+    std::vector<MerkleTrie> tries(size_t(1) << (4 * nibbles));
+    for (const auto& entry : entries) {
+        tries[prefixShard(entry.first, nibbles)].insert(entry.first, entry.second);
+    }
+    std::vector<Digest> level;
+    for (const MerkleTrie& trie : tries) {
+        level.push_back(trie.view().getRootDigest());
+    }
+    while (level.size() > 1) {
+        std::vector<Digest> parents;
+        for (size_t i = 0; i < level.size(); i += 2) {
+            std::string both = HashFusion::toHex(level[i]) + HashFusion::toHex(level[i + 1]);
+            parents.push_back(HashFusion::sha256Digest(both.data(), both.size()));
+        }
+        level.swap(parents);
+    }
+    return level[0];
+}
+
+} // namespace
+
+TEST(ShardedMerkleTrie, RootMatchesPerShardTries) {
+    // Few enough keys at two nibbles that many shards stay empty
+    Entries entries = voterEntries(300, 1);
+    for (unsigned nibbles : {1u, 2u}) {
+        ShardedMerkleTrie<Sha256HexPolicy> single(nibbles);
+        ShardedMerkleTrie<Sha256HexPolicy> batched(nibbles);
+        EXPECT_EQ(single.shardCount(), size_t(1) << (4 * nibbles));
+        for (const auto& entry : entries) {
+            single.insert(entry.first, entry.second);
+        }
+        batched.insertBatch(entries);
+
+        Digest root = referenceRoot(entries, nibbles);
+        EXPECT_EQ(single.getRootDigest(), root) << nibbles << " nibbles";
+        EXPECT_EQ(batched.getRootDigest(), root) << nibbles << " nibbles";
+        EXPECT_EQ(batched.getSize(), entries.size());
+        for (const auto& entry : entries) {
+            EXPECT_EQ(batched.shardOf(entry.first), prefixShard(entry.first, nibbles));
+            EXPECT_EQ(batched.getValue(entry.first), entry.second);
+        }
+
+        batched.clear();
+        EXPECT_EQ(batched.getSize(), 0u);
+        EXPECT_FALSE(batched.search(entries[0].first));
+    }
+}
+
+TEST(ShardedMerkleTrie, ProofsBindTheShardPosition) {
+    Entries entries = voterEntries(400, 2);
+    ShardedMerkleTrie<Sha256HexPolicy> registry(2);
+    ShardedMerkleTrie<Sha256HexPolicy> coarser(1);
+    registry.insertBatch(entries);
+    coarser.insertBatch(entries);
+    Digest root = registry.getRootDigest();
+
+    ShardedTrieProof proof;
+    Digest proofRoot;
+    EXPECT_FALSE(registry.getProof("not-registered", proof, proofRoot));
+
+    for (size_t i = 0; i < entries.size(); i += 3) {
+        ASSERT_TRUE(registry.getProof(entries[i].first, proof, proofRoot));
+        EXPECT_EQ(proofRoot, root);
+        EXPECT_EQ(proof.shard, registry.shardOf(entries[i].first));
+        EXPECT_EQ(proof.shardPath.size(), 8u);
+        EXPECT_TRUE(registry.verifyProof(proof, root));
+
+        // Another position, a reordered or shortened path, another layout
+        ShardedTrieProof moved = proof;
+        moved.shard ^= 1;
+        EXPECT_FALSE(registry.verifyProof(moved, root));
+        moved = proof;
+        std::swap(moved.shardPath[0], moved.shardPath[1]);
+        EXPECT_FALSE(registry.verifyProof(moved, root));
+        moved = proof;
+        moved.shardPath.pop_back();
+        EXPECT_FALSE(registry.verifyProof(moved, root));
+        EXPECT_FALSE(coarser.verifyProof(proof, coarser.getRootDigest()));
+
+        moved = proof;
+        moved.shardProof.levels.back().value += "x";
+        EXPECT_FALSE(registry.verifyProof(moved, root));
+    }
+}
+
+TEST(ShardedMerkleTrie, NonHexKeysUseTheLowNibble) {
+    ShardedMerkleTrie<Sha256HexPolicy> registry(1);
+    EXPECT_EQ(registry.shardOf("A1"), 10u);
+    EXPECT_EQ(registry.shardOf("a1"), 10u);
+    EXPECT_EQ(registry.shardOf("z"), static_cast<size_t>('z' & 15));
+    EXPECT_EQ(registry.shardOf(""), 0u);
+
+    registry.insert("zebra", "1");
+    ShardedTrieProof proof;
+    Digest root;
+    ASSERT_TRUE(registry.getProof("zebra", proof, root));
+    EXPECT_TRUE(registry.verifyProof(proof, root));
+}
@@ -0,0 +1,129 @@
+// The radix-compressed sparse Merkle tree against a full 256-level tree
+// computed level by level, with the empty subtrees built up separately.
+
+#include <gtest/gtest.h>
+#include "hash_fusion.h"
+#include "keccak.h"
+#include "sparse_merkle_tree.h"
+#include <array>
+#include <functional>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace {
+
+typedef std::function<Digest(const Digest&, const Digest&)> PairFn;
+typedef std::function<Digest(const Digest&)> LeafFn;
+
+struct Reference {
+    PairFn pair;
+    LeafFn leaf;
+    std::array<Digest, 257> empty;
+
+    Reference(PairFn pair, LeafFn leaf) : pair(pair), leaf(leaf) {
+        empty[0] = Digest();
+        for (size_t h = 0; h < 256; h++) {
+            empty[h + 1] = pair(empty[h], empty[h]);
+        }
+    }
+
+    // Subtree at depth over keys, which all share its first depth bits
+    Digest root(const std::vector<Digest>& keys, size_t depth = 0) const {
+        if (keys.empty()) {
+            return empty[256 - depth];
+        }
+        if (depth == 256) {
+            return leaf(keys[0]);
+        }
+        std::vector<Digest> sides[2];
+        for (const Digest& key : keys) {
+            sides[(key[depth / 8] >> (7 - depth % 8)) & 1].push_back(key);
+        }
+        return pair(root(sides[0], depth + 1), root(sides[1], depth + 1));
+    }
+};
+
+Reference sha256Reference() {
+    return Reference(
+        [](const Digest& left, const Digest& right) {
+            return HashFusion::sha256Digest((HashFusion::toHex(left) + HashFusion::toHex(right)).data(), 128);
+        },
+        [](const Digest& key) { return HashFusion::sha256Digest(key.data(), key.size()); });
+}
+
+Reference keccakReference() {
+    return Reference(
+        [](const Digest& left, const Digest& right) {
+            uint8_t both[64];
+            std::copy(left.begin(), left.end(), both);
+            std::copy(right.begin(), right.end(), both + 32);
+            return Keccak256Stream::hash(both, sizeof(both));
+        },
+        [](const Digest& key) { return Keccak256Stream::hash(key.data(), key.size()); });
+}
+
+std::vector<Digest> randomKeys(size_t count, uint32_t seed) {
+    std::mt19937 random(seed);
+    std::vector<Digest> keys(count);
+    for (Digest& key : keys) {
+        for (uint8_t& byte : key) {
+            byte = static_cast<uint8_t>(random());
+        }
+    }
+    // Neighbours differing only in the last bit, and the extremes
+    keys.push_back(keys[0]);
+    keys.back()[31] ^= 1;
+    keys.push_back(Digest());
+    keys.push_back(Digest());
+    keys.back().fill(0xff);
+    return keys;
+}
+
+template <typename Tree>
+void expectMatches(const Reference& reference) {
+    std::vector<Digest> keys = randomKeys(40, 7);
+
+    Tree single;
+    EXPECT_EQ(single.getRoot(), reference.root({}));
+    std::vector<Digest> present;
+    for (const Digest& key : keys) {
+        single.insert(key);
+        present.push_back(key);
+        if (present.size() <= 8 || present.size() == keys.size()) {
+            ASSERT_EQ(single.getRoot(), reference.root(present)) << present.size() << " keys";
+        }
+    }
+
+    Tree batched;
+    batched.insertBatch(keys);
+    EXPECT_EQ(batched.getRoot(), reference.root(keys));
+    EXPECT_EQ(batched.getRoot(), single.getRoot());
+}
+
+} // namespace
+
+TEST(SparseMerkleTree, Sha256RootMatchesFullTree) {
+    expectMatches<NullifierTree>(sha256Reference());
+}
+
+TEST(SparseMerkleTree, KeccakRootMatchesFullTree) {
+    expectMatches<SparseMerkleTree<Keccak256Policy>>(keccakReference());
+}
+
+TEST(SparseMerkleTree, ProofsVerify) {
+    std::vector<Digest> keys = randomKeys(200, 8);
+    NullifierTree tree;
+    tree.insertBatch(std::vector<Digest>(keys.begin(), keys.begin() + 100));
+
+    for (size_t i = 0; i < keys.size(); i++) {
+        SparseMerkleProof proof;
+        bool included = tree.getProof(keys[i], proof);
+        EXPECT_EQ(included, i < 100);
+        EXPECT_TRUE(NullifierTree::verifyProof(proof, tree.getRoot()));
+
+        // A proof cannot be flipped between membership and non-membership
+        proof.included = !proof.included;
+        EXPECT_FALSE(NullifierTree::verifyProof(proof, tree.getRoot()));
+    }
+}
@@ -0,0 +1,83 @@
+// Snapshot round trip: the mapped file answers lookups and proofs like
+// the trie it was written from, and copies back into a writable trie.
+
+#include <gtest/gtest.h>
+#include "hash_fusion.h"
+#include "trie_snapshot.h"
+#include <cstdio>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include <unistd.h>
+
+namespace {
+
+class TrieSnapshotTest : public testing::Test {
+protected:
+    std::string path;
+    std::vector<std::pair<std::string, std::string>> entries;
+
+    void SetUp() override {
+        path = testing::TempDir() + "snapshot_test_" + std::to_string(::getpid()) + "_" +
+               testing::UnitTest::GetInstance()->current_test_info()->name();
+        for (uint32_t i = 0; i < 600; i++) {
+            entries.emplace_back(HashFusion::toHex(HashFusion::sha256Digest(&i, sizeof(i))),
+                                 "voter-" + std::to_string(i));
+        }
+    }
+
+    void TearDown() override {
+        std::remove(path.c_str());
+    }
+};
+
+} // namespace
+
+TEST_F(TrieSnapshotTest, RoundTrip) {
+    MerkleTrie trie(std::vector<std::pair<std::string, std::string>>(entries.begin(), entries.begin() + 500));
+    std::vector<Digest> leaves = {HashFusion::sha256Digest("a", 1), HashFusion::sha256Digest("b", 1)};
+    TrieSnapshot::write(path, trie.view(), Sha256HexPolicy::name(), leaves);
+
+    TrieSnapshot snapshot(path);
+    const TrieView& view = snapshot.view();
+    EXPECT_EQ(snapshot.hashPolicy(), Sha256HexPolicy::name());
+    EXPECT_EQ(view.getRootDigest(), trie.view().getRootDigest());
+    EXPECT_EQ(view.getSize(), 500u);
+    ASSERT_EQ(snapshot.leafCount(), leaves.size());
+    EXPECT_EQ(std::vector<Digest>(snapshot.leaves(), snapshot.leaves() + snapshot.leafCount()), leaves);
+
+    for (size_t i = 0; i < 500; i += 7) {
+        EXPECT_EQ(view.getValue(entries[i].first), entries[i].second);
+        TrieProof proof;
+        ASSERT_TRUE(view.getTrieProof(entries[i].first, proof));
+        EXPECT_TRUE(MerkleTrie::verifyTrieProof(proof, trie.view().getRootDigest()));
+    }
+    EXPECT_FALSE(view.search(entries[550].first));
+
+    // Restored tries keep inserting to the same roots as the original
+    MerkleTrie restored(view);
+    std::vector<std::pair<std::string, std::string>> rest(entries.begin() + 500, entries.end());
+    restored.insertBatch(rest);
+    trie.insertBatch(rest);
+    EXPECT_EQ(restored.getRootHash(), trie.getRootHash());
+    EXPECT_EQ(restored.getSize(), entries.size());
+}
+
+TEST_F(TrieSnapshotTest, KeepsCommittedVersionsOut) {
+    MerkleTrie trie(std::vector<std::pair<std::string, std::string>>(entries.begin(), entries.begin() + 300));
+    trie.commit();
+    trie.insertBatch(std::vector<std::pair<std::string, std::string>>(entries.begin() + 300, entries.end()));
+    TrieSnapshot::write(path, trie.view(), Sha256HexPolicy::name());
+
+    TrieSnapshot snapshot(path);
+    EXPECT_EQ(snapshot.view().getRootDigest(), trie.view().getRootDigest());
+    EXPECT_EQ(snapshot.view().getSize(), entries.size());
+    EXPECT_EQ(snapshot.leafCount(), 0u);
+}
+
+TEST_F(TrieSnapshotTest, RejectsTruncatedFile) {
+    MerkleTrie trie(entries);
+    TrieSnapshot::write(path, trie.view(), Sha256HexPolicy::name());
+    ASSERT_EQ(::truncate(path.c_str(), 200), 0);
+    EXPECT_THROW(TrieSnapshot snapshot(path), std::runtime_error);
+}
@@ -0,0 +1,211 @@
+// Live tally: per-record outcomes, totals against a plain count, and a
+// reader that applies deltas keeping exactly up with snapshots, with and
+// without ingests running alongside it.
+
+#include <gtest/gtest.h>
+#include "vote_tally.h"
+#include <atomic>
+#include <map>
+#include <random>
+#include <thread>
+#include <vector>
+
+namespace {
+
+struct Vote {
+    uint32_t nullifier;
+    uint32_t candidate;
+};
+
+// Nullifier n is n's bytes followed by a fixed pattern, never all zero
+std::vector<uint8_t> pack(const std::vector<Vote>& votes) {
+    std::vector<uint8_t> records(votes.size() * VoteTally::RECORD_BYTES);
+    for (size_t i = 0; i < votes.size(); i++) {
+        uint8_t* record = records.data() + i * VoteTally::RECORD_BYTES;
+        for (size_t byte = 0; byte < 32; byte++) {
+            record[byte] = byte < 4 ? static_cast<uint8_t>(votes[i].nullifier >> (8 * byte)) : 0x5a;
+        }
+        for (size_t byte = 0; byte < 4; byte++) {
+            record[32 + byte] = static_cast<uint8_t>(votes[i].candidate >> (8 * byte));
+        }
+    }
+    return records;
+}
+
+std::map<uint32_t, uint64_t> countsOf(const VoteTally::Totals& totals) {
+    std::map<uint32_t, uint64_t> counts;
+    for (size_t i = 0; i < totals.candidates.size(); i++) {
+        counts[totals.candidates[i]] = totals.counts[i];
+    }
+    return counts;
+}
+
+// A client's view: the last sequence seen and totals patched by deltas
+struct Reader {
+    uint64_t seen = 0;
+    std::map<uint32_t, uint64_t> counts;
+
+    void poll(const VoteTally& tally) {
+        VoteTally::Totals delta = tally.delta(seen);
+        ASSERT_GE(delta.sequence, seen);
+        for (size_t i = 0; i < delta.candidates.size(); i++) {
+            counts[delta.candidates[i]] = delta.counts[i];
+        }
+        seen = delta.sequence;
+    }
+};
+
+} // namespace
+
+TEST(VoteTally, IngestReportsEachRecord) {
+    VoteTally tally(4);
+    NullifierSet spent;
+    std::vector<Vote> votes = {{1, 0}, {2, 3}, {1, 2}, {3, 4}, {4, 1}, {2, 1}, {5, 70000}};
+    std::vector<uint8_t> records = pack(votes);
+    std::vector<uint8_t> status(votes.size());
+
+    VoteTally::IngestResult result = tally.ingest(records.data(), votes.size(), spent, status.data());
+    EXPECT_EQ(result.accepted, 3u);
+    EXPECT_EQ(result.duplicates, 2u);
+    EXPECT_EQ(result.invalid, 2u);
+    EXPECT_EQ(status, (std::vector<uint8_t>{VoteTally::ACCEPTED, VoteTally::ACCEPTED, VoteTally::DUPLICATE,
+                                            VoteTally::UNKNOWN_CANDIDATE, VoteTally::ACCEPTED,
+                                            VoteTally::DUPLICATE, VoteTally::UNKNOWN_CANDIDATE}));
+    EXPECT_EQ(result.sequence, tally.sequence());
+
+    // A record for an unknown candidate leaves its nullifier unspent
+    records = pack({{3, 2}, {4, 2}});
+    result = tally.ingest(records.data(), 2, spent, nullptr);
+    EXPECT_EQ(result.accepted, 1u);
+    EXPECT_EQ(result.duplicates, 1u);
+
+    VoteTally::Totals totals = tally.snapshot();
+    EXPECT_EQ(totals.totalVotes, 4u);
+    EXPECT_EQ(totals.candidates, (std::vector<uint32_t>{0, 1, 2, 3}));
+    EXPECT_EQ(totals.counts, (std::vector<uint64_t>{1, 1, 1, 1}));
+}
+
+TEST(VoteTally, DeltasFollowSequences) {
+    VoteTally tally(50);
+    ShardedNullifierSet spent;
+    Reader reader;
+    reader.poll(tally);
+    EXPECT_EQ(reader.counts.size(), 50u);
+
+    std::mt19937 random(1);
+    std::map<uint32_t, uint64_t> expected;
+    for (uint32_t c = 0; c < 50; c++) {
+        expected[c] = 0;
+    }
+    uint32_t nextNullifier = 1;
+    for (size_t round = 0; round < 30; round++) {
+        // Each round votes for a few candidates only
+        std::vector<Vote> votes;
+        uint32_t first = random() % 45;
+        for (size_t i = 0; i < 20; i++) {
+            votes.push_back({nextNullifier++, first + static_cast<uint32_t>(random() % 5)});
+            expected[votes.back().candidate]++;
+        }
+        std::vector<uint8_t> records = pack(votes);
+        uint64_t before = tally.sequence();
+        VoteTally::IngestResult result = tally.ingest(records.data(), votes.size(), spent, nullptr);
+        EXPECT_EQ(result.sequence, before + 1);
+
+        VoteTally::Totals delta = tally.delta(before);
+        for (uint32_t candidate : delta.candidates) {
+            EXPECT_GE(candidate, first);
+            EXPECT_LT(candidate, first + 5);
+        }
+        reader.poll(tally);
+        ASSERT_EQ(reader.counts, expected) << "round " << round;
+
+        // Replayed records change nothing and take no sequence
+        result = tally.ingest(records.data(), votes.size(), spent, nullptr);
+        EXPECT_EQ(result.duplicates, votes.size());
+        EXPECT_EQ(result.sequence, before + 1);
+        EXPECT_TRUE(tally.delta(tally.sequence()).candidates.empty());
+    }
+    EXPECT_EQ(countsOf(tally.snapshot()), expected);
+
+    // Reset moves the sequence on and resends every candidate as zero
+    uint64_t before = tally.sequence();
+    tally.reset(3);
+    EXPECT_GT(tally.sequence(), before);
+    VoteTally::Totals delta = tally.delta(before);
+    EXPECT_EQ(delta.candidates, (std::vector<uint32_t>{0, 1, 2}));
+    EXPECT_EQ(delta.counts, (std::vector<uint64_t>{0, 0, 0}));
+    EXPECT_EQ(delta.totalVotes, 0u);
+}
+
+TEST(VoteTally, LargeIngestCountsOnThePool) {
+    // Several count chunks spread over the pool's threads and stripes
+    VoteTally tally(7);
+    NullifierSet spent;
+    std::vector<Vote> votes;
+    std::vector<uint64_t> expected(7, 0);
+    for (uint32_t i = 0; i < 200000; i++) {
+        votes.push_back({i + 1, (i * 2654435761u) % 7});
+        expected[votes.back().candidate]++;
+    }
+    std::vector<uint8_t> records = pack(votes);
+    EXPECT_EQ(tally.ingest(records.data(), votes.size(), spent, nullptr).accepted, votes.size());
+    VoteTally::Totals totals = tally.snapshot();
+    EXPECT_EQ(totals.counts, expected);
+    EXPECT_EQ(totals.totalVotes, votes.size());
+}
+
+TEST(VoteTally, ConcurrentIngestsAndReader) {
+    VoteTally tally(16);
+    ShardedNullifierSet spent;
+    const size_t THREADS = 4, BATCHES = 40, BATCH = 100;
+
+    // Every thread sends the same ballots, so each is counted once
+    std::vector<std::vector<uint8_t>> batches;
+    std::map<uint32_t, uint64_t> expected;
+    for (uint32_t c = 0; c < 16; c++) {
+        expected[c] = 0;
+    }
+    for (size_t b = 0; b < BATCHES; b++) {
+        std::vector<Vote> votes;
+        for (size_t i = 0; i < BATCH; i++) {
+            uint32_t nullifier = static_cast<uint32_t>(b * BATCH + i + 1);
+            votes.push_back({nullifier, nullifier % 16});
+            expected[nullifier % 16]++;
+        }
+        batches.push_back(pack(votes));
+    }
+
+    std::atomic<size_t> accepted(0);
+    std::atomic<bool> done(false);
+    std::vector<std::thread> threads;
+    for (size_t t = 0; t < THREADS; t++) {
+        threads.emplace_back([&, t]() {
+            for (size_t b = 0; b < BATCHES; b++) {
+                const std::vector<uint8_t>& records = batches[(b + t * 7) % BATCHES];
+                accepted += tally.ingest(records.data(), BATCH, spent, nullptr).accepted;
+            }
+        });
+    }
+
+    // Deltas seen while ingests run never move backwards, and the last
+    // poll after they finish matches the snapshot
+    Reader reader;
+    std::thread polling([&]() {
+        while (!done) {
+            uint64_t seen = reader.seen;
+            reader.poll(tally);
+            EXPECT_GE(reader.seen, seen);
+        }
+    });
+    for (std::thread& thread : threads) {
+        thread.join();
+    }
+    done = true;
+    polling.join();
+    reader.poll(tally);
+
+    EXPECT_EQ(accepted, BATCHES * BATCH);
+    EXPECT_EQ(reader.counts, expected);
+    EXPECT_EQ(countsOf(tally.snapshot()), expected);
+    EXPECT_EQ(tally.snapshot().totalVotes, BATCHES * BATCH);
+}
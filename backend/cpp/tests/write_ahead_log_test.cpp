@@ -0,0 +1,158 @@
+// Crash recovery: records replay in order onto the base trie, and a tail
+// torn by a crash is cut off without losing the intact records before it.
+
+#include <gtest/gtest.h>
+#include "merkle_trie.h"
+#include "write_ahead_log.h"
+#include <cstdio>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace {
+
+class WriteAheadLogTest : public testing::Test {
+protected:
+    std::string path;
+    Digest base;
+
+    void SetUp() override {
+        path = testing::TempDir() + "wal_test_" + std::to_string(::getpid()) + "_" +
+               testing::UnitTest::GetInstance()->current_test_info()->name();
+        std::remove(path.c_str());
+        base = MerkleTrie().view().getRootDigest();
+    }
+
+    void TearDown() override {
+        std::remove(path.c_str());
+    }
+
+    off_t fileSize() const {
+        struct stat info;
+        return ::stat(path.c_str(), &info) == 0 ? info.st_size : -1;
+    }
+
+    // Log `count` single-insert records on a fresh trie; returns the roots
+    std::vector<Digest> writeRecords(size_t count) {
+        MerkleTrie trie;
+        std::vector<Digest> roots;
+        WriteAheadLog log(path, base, [](const WriteAheadLog::Entries&, const Digest&) {});
+        for (size_t i = 0; i < count; i++) {
+            WriteAheadLog::Entries entries = {{"key" + std::to_string(i), "value" + std::to_string(i)}};
+            trie.insertBatch(entries);
+            roots.push_back(trie.view().getRootDigest());
+            log.sync(log.append(entries, roots.back()));
+        }
+        return roots;
+    }
+
+    // Reopen and replay onto a fresh trie, checking every record's root
+    size_t replay(MerkleTrie& trie) {
+        size_t replayed = 0;
+        WriteAheadLog log(path, base, [&](const WriteAheadLog::Entries& entries, const Digest& root) {
+            trie.insertBatch(entries);
+            EXPECT_EQ(trie.view().getRootDigest(), root) << "record " << replayed;
+            replayed++;
+        });
+        EXPECT_EQ(log.recordCount(), replayed);
+        EXPECT_FALSE(log.failed());
+        return replayed;
+    }
+};
+
+} // namespace
+
+TEST_F(WriteAheadLogTest, ReplaysEveryRecord) {
+    std::vector<Digest> roots = writeRecords(5);
+    MerkleTrie trie;
+    EXPECT_EQ(replay(trie), 5u);
+    EXPECT_EQ(trie.view().getRootDigest(), roots.back());
+}
+
+TEST_F(WriteAheadLogTest, TornTailIsCutOff) {
+    std::vector<Digest> roots = writeRecords(3);
+    off_t intact = fileSize();
+
+    // Half of a fourth record: it is dropped and the file cut back
+    {
+        MerkleTrie trie;
+        WriteAheadLog log(path, base, [&](const WriteAheadLog::Entries& entries, const Digest&) {
+            trie.insertBatch(entries);
+        });
+        trie.insert("key3", "value3");
+        log.sync(log.append({{"key3", "value3"}}, trie.view().getRootDigest()));
+    }
+    ASSERT_GT(fileSize(), intact);
+    ASSERT_EQ(::truncate(path.c_str(), (intact + fileSize()) / 2), 0);
+
+    MerkleTrie trie;
+    EXPECT_EQ(replay(trie), 3u);
+    EXPECT_EQ(trie.view().getRootDigest(), roots.back());
+    EXPECT_EQ(fileSize(), intact);
+}
+
+TEST_F(WriteAheadLogTest, AppendsAfterTruncatedTail) {
+    writeRecords(3);
+    off_t intact = fileSize();
+    FILE* file = std::fopen(path.c_str(), "ab");
+    ASSERT_NE(file, nullptr);
+    std::fputs("garbage after the last record", file);
+    std::fclose(file);
+
+    // The next record lands on the cut, not behind the garbage
+    {
+        MerkleTrie trie;
+        WriteAheadLog log(path, base, [&](const WriteAheadLog::Entries& entries, const Digest&) {
+            trie.insertBatch(entries);
+        });
+        EXPECT_EQ(fileSize(), intact);
+        trie.insert("late", "voter");
+        log.sync(log.append({{"late", "voter"}}, trie.view().getRootDigest()));
+    }
+
+    MerkleTrie trie;
+    EXPECT_EQ(replay(trie), 4u);
+    EXPECT_EQ(trie.getValue("late"), "voter");
+}
+
+TEST_F(WriteAheadLogTest, RejectsOtherBase) {
+    writeRecords(2);
+    MerkleTrie other;
+    other.insert("unrelated", "trie");
+    EXPECT_THROW(WriteAheadLog(path, other.view().getRootDigest(),
+                               [](const WriteAheadLog::Entries&, const Digest&) {}),
+                 std::runtime_error);
+}
+
+TEST_F(WriteAheadLogTest, FailedReplayRollsBack) {
+    // The third record claims a root its inserts do not produce
+    {
+        MerkleTrie trie;
+        WriteAheadLog log(path, base, [](const WriteAheadLog::Entries&, const Digest&) {});
+        for (size_t i = 0; i < 4; i++) {
+            WriteAheadLog::Entries entries = {{"key" + std::to_string(i), "value" + std::to_string(i)}};
+            trie.insertBatch(entries);
+            log.sync(log.append(entries, i == 2 ? base : trie.view().getRootDigest()));
+        }
+    }
+
+    // Replayed the way OpenWriteAheadLog does, under a savepoint
+    MerkleTrie trie;
+    std::string before = trie.getRootHash();
+    size_t replayed = 0;
+    trie.savepoint();
+    EXPECT_THROW(WriteAheadLog(path, base, [&](const WriteAheadLog::Entries& entries, const Digest& root) {
+        trie.insertBatch(entries);
+        if (trie.view().getRootDigest() != root) {
+            throw std::runtime_error("root mismatch");
+        }
+        replayed++;
+    }), std::runtime_error);
+    trie.rollback();
+    EXPECT_EQ(replayed, 2u);
+    EXPECT_EQ(trie.getRootHash(), before);
+    EXPECT_EQ(trie.getSize(), 0u);
+    EXPECT_FALSE(trie.search("key0"));
+}
@@ -0,0 +1,127 @@
+#include "include/thread_pool.h"
+#include <algorithm>
+#include <atomic>
+#include <exception>
+
+struct ThreadPool::Batch {
+    const std::function<void(size_t)>* task;
+    size_t count;
+    std::atomic<size_t> next{0};
+    std::atomic<size_t> done{0};
+    std::mutex mutex;
+    std::condition_variable finished;
+    std::exception_ptr error;
+};
+
+ThreadPool::ThreadPool(size_t threads) : stopping(false) {
+    if (threads == 0) {
+        threads = std::max<size_t>(1, std::thread::hardware_concurrency());
+    }
+    
+    // The caller participates, so spawn one worker fewer than requested
+    for (size_t i = 1; i < threads; i++) {
+        workers.emplace_back([this] { workerLoop(); });
+    }
+}
+
+ThreadPool::~ThreadPool() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    wake.notify_all();
+    
+    for (auto& worker : workers) {
+        worker.join();
+    }
+}
+
+ThreadPool& ThreadPool::shared() {
+    static ThreadPool pool;
+    return pool;
+}
+
+void ThreadPool::parallelFor(size_t count, const std::function<void(size_t)>& task) {
+    if (count == 0) return;
+    
+    if (count == 1 || workers.empty()) {
+        for (size_t i = 0; i < count; i++) {
+            task(i);
+        }
+        return;
+    }
+    
+    auto batch = std::make_shared<Batch>();
+    batch->task = &task;
+    batch->count = count;
+    
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        pending.push_back(batch);
+    }
+    wake.notify_all();
+    
+    runBatch(*batch);
+    
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        auto it = std::find(pending.begin(), pending.end(), batch);
+        if (it != pending.end()) {
+            pending.erase(it);
+        }
+    }
+    
+    // Wait for indices claimed by workers to finish
+    std::unique_lock<std::mutex> lock(batch->mutex);
+    batch->finished.wait(lock, [&] { return batch->done.load() == count; });
+    
+    if (batch->error) {
+        std::rethrow_exception(batch->error);
+    }
+}
+
+void ThreadPool::runBatch(Batch& batch) {
+    for (;;) {
+        size_t i = batch.next.fetch_add(1);
+        if (i >= batch.count) break;
+        
+        try {
+            (*batch.task)(i);
+        } catch (...) {
+            std::lock_guard<std::mutex> lock(batch.mutex);
+            if (!batch.error) {
+                batch.error = std::current_exception();
+            }
+        }
+        
+        if (batch.done.fetch_add(1) + 1 == batch.count) {
+            std::lock_guard<std::mutex> lock(batch.mutex);
+            batch.finished.notify_all();
+        }
+    }
+}
+
+void ThreadPool::workerLoop() {
+    for (;;) {
+        std::shared_ptr<Batch> batch;
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            wake.wait(lock, [this] { return stopping || !pending.empty(); });
+            if (stopping) return;
+            
+            batch = pending.front();
+            // Drop batches that have no unclaimed indices left
+            if (batch->next.load() >= batch->count) {
+                pending.pop_front();
+                continue;
+            }
+        }
+        
+        runBatch(*batch);
+        
+        std::lock_guard<std::mutex> lock(mutex);
+        if (!pending.empty() && pending.front() == batch) {
+            pending.pop_front();
+        }
+    }
+}
@@ -1,173 +1,2292 @@
 #include <napi.h>
 #include "include/merkle_trie.h"
+#include "include/blake2b.h"
 #include "include/hash_fusion.h"
+#include "include/keccak.h"
+#include "include/merkle_tree.h"
+#include "include/metrics.h"
+#include "include/nullifier_set.h"
+#include "include/roll_import.h"
+#include "include/sharded_trie.h"
+#include "include/sparse_merkle_tree.h"
+#include "include/thread_pool.h"
+#include "include/trie_snapshot.h"
+#include "include/vote_tally.h"
+#include "include/write_ahead_log.h"
+#include <algorithm>
 #include <memory>
 #include <chrono>
+#include <cstring>
+#include <functional>
+#include <mutex>
+#include <shared_mutex>
+#include <stdexcept>
+#include <unordered_set>
 
 // Global trie instance for voter data
 static std::unique_ptr<MerkleTrie> globalTrie = nullptr;
 
-// Initialize the global trie
+// Readers (verify, stats) share the trie; writers (insert, reset) are
+// serialized. Async workers and synchronous calls take the same lock.
+static std::shared_mutex trieMutex;
+
+// Registered voter hashes in arrival order as Merkle tree leaves, so list
+// proofs are O(log n) lookups; guarded by trieMutex like the trie
+static std::unique_ptr<MerkleTree<Sha256HexPolicy>> voterTree = nullptr;
+
+// Snapshot loaded at startup; serves reads straight from the mapping
+// until the first write copies it into globalTrie
+static std::unique_ptr<TrieSnapshot> globalSnapshot = nullptr;
+
+// Log of inserts since the last snapshot, once openWriteAheadLog is called.
+// Records are appended under trieMutex so their order matches the trie;
+// callers wait for the fsync after releasing it, so concurrent inserts
+// share one group commit.
+static std::shared_ptr<WriteAheadLog> globalWal = nullptr;
+
+// Spent nullifiers. Check-and-insert is atomic under the set's shard
+// lock, so two submissions of the same vote cannot both be accepted, and
+// spends landing in different shards run concurrently.
+static ShardedNullifierSet nullifierSet;
+
+// The same nullifiers in a sparse Merkle tree for (non-)membership proofs.
+// Spends only queue them (under pendingMutex); they enter the tree as one
+// batch when a root or proof is next needed. Spends hold nullifierMutex
+// shared; flushing the queue into the tree and resetting hold it
+// exclusively.
+static NullifierTree nullifierTree;
+static std::vector<Digest> pendingNullifiers;
+static std::mutex pendingMutex;
+static std::shared_mutex nullifierMutex;
+
+// Live per-candidate totals. Ingests hold nullifierMutex and tallyMutex
+// shared, so they overlap each other; only reconfiguring takes tallyMutex
+// exclusively, so snapshots and deltas never wait on ingest. Lock
+// nullifierMutex first when taking both.
+static VoteTally voteTally;
+static std::shared_mutex tallyMutex;
+
+// Progress of the running importVoterRoll, if any; one import at a time
+static RollProgress importProgress;
+static std::atomic<bool> importActive(false);
+
+// Sharded registry by the first hex nibble of the voter hash; it has its
+// own per-shard locks and does not touch trieMutex
+static ShardedMerkleTrie<Sha256HexPolicy> shardedRegistry(1);
+
+// Fusion contexts of the most recent (salt, timestamp) pairs. An election
+// registers everyone under one pair, so each entry point looks its
+// context up here instead of padding the suffix blocks on every call.
+static const size_t FUSION_CACHE_SIZE = 8;
+
+struct CachedFusion {
+    std::string salt;
+    uint64_t timestamp;
+    uint64_t lastUse;
+    std::shared_ptr<const FusionContext> context;
+};
+static std::vector<CachedFusion> fusionCache;
+static uint64_t fusionCacheClock = 0;
+static std::mutex fusionCacheMutex;
+
+static std::shared_ptr<const FusionContext> fusionContext(const std::string& salt, uint64_t timestamp) {
+    std::lock_guard<std::mutex> lock(fusionCacheMutex);
+    fusionCacheClock++;
+    for (CachedFusion& entry : fusionCache) {
+        if (entry.timestamp == timestamp && entry.salt == salt) {
+            entry.lastUse = fusionCacheClock;
+            return entry.context;
+        }
+    }
+    
+    // Evict the least recently used pair once full
+    auto context = std::make_shared<const FusionContext>(salt, timestamp);
+    if (fusionCache.size() < FUSION_CACHE_SIZE) {
+        fusionCache.push_back({salt, timestamp, fusionCacheClock, context});
+    } else {
+        auto oldest = std::min_element(fusionCache.begin(), fusionCache.end(),
+            [](const CachedFusion& a, const CachedFusion& b) { return a.lastUse < b.lastUse; });
+        *oldest = {salt, timestamp, fusionCacheClock, context};
+    }
+    return context;
+}
+
+// Rebuild voterTree from the snapshot's leaves; caller holds trieMutex exclusively
+static void restoreVoterTree() {
+    if (!voterTree && globalSnapshot) {
+        const Digest* leaves = globalSnapshot->leaves();
+        voterTree = std::make_unique<MerkleTree<Sha256HexPolicy>>(
+            std::vector<Digest>(leaves, leaves + globalSnapshot->leafCount()));
+    }
+}
+
+// Initialize the global trie; caller must hold trieMutex exclusively
 void initializeTrie() {
     if (!globalTrie) {
-        globalTrie = std::make_unique<MerkleTrie>();
+        if (globalSnapshot) {
+            restoreVoterTree();
+            globalTrie = std::make_unique<MerkleTrie>(globalSnapshot->view());
+            globalSnapshot.reset();
+        } else {
+            globalTrie = std::make_unique<MerkleTrie>();
+            voterTree = std::make_unique<MerkleTree<Sha256HexPolicy>>();
+        }
+    }
+}
+
+// Registry for readers, live or mapped; caller holds trieMutex.
+// False before the first registration or snapshot load.
+static bool registryView(TrieView& view) {
+    if (globalTrie) {
+        view = globalTrie->view();
+        return true;
+    }
+    if (globalSnapshot) {
+        view = globalSnapshot->view();
+        return true;
+    }
+    return false;
+}
+
+// voterTree is rebuilt lazily after a snapshot load, on first list proof
+static void ensureVoterTree() {
+    {
+        std::shared_lock<std::shared_mutex> lock(trieMutex);
+        if (voterTree || !globalSnapshot) return;
+    }
+    std::unique_lock<std::shared_mutex> lock(trieMutex);
+    restoreVoterTree();
+}
+
+// Append voter hashes not yet in voterTree; caller holds trieMutex exclusively
+static void appendVoterLeaves(const std::vector<Digest>& leaves) {
+    std::vector<Digest> fresh;
+    std::unordered_set<Digest, DigestHash> seen;
+    
+    for (const auto& leaf : leaves) {
+        if (voterTree->indexOf(leaf) == MerkleTree<Sha256HexPolicy>::NOT_FOUND &&
+            seen.insert(leaf).second) {
+            fresh.push_back(leaf);
+        }
+    }
+    
+    voterTree->append(fresh);
+}
+
+static void appendVoterLeaves(const std::vector<std::string>& voterHashes) {
+    std::vector<Digest> leaves;
+    leaves.reserve(voterHashes.size());
+    for (const auto& voterHash : voterHashes) {
+        Digest leaf;
+        if (HashFusion::fromHex(voterHash, leaf)) {
+            leaves.push_back(leaf);
+        }
+    }
+    appendVoterLeaves(leaves);
+}
+
+// Runs `work` on the libuv thread pool and settles a Promise with its
+// converted result, so hashing never blocks the JS event loop
+template <typename Result>
+class PromiseWorker : public Napi::AsyncWorker {
+public:
+    typedef std::function<Result()> Work;
+    typedef std::function<Napi::Value(Napi::Env, const Result&)> Convert;
+    
+    static Napi::Promise Start(Napi::Env env, Work work, Convert convert,
+                               const std::string& errorPrefix) {
+        auto* worker = new PromiseWorker(env, std::move(work), std::move(convert), errorPrefix);
+        Napi::Promise promise = worker->deferred.Promise();
+        worker->Queue();
+        return promise;
+    }
+
+protected:
+    void Execute() override {
+        try {
+            result = work();
+        } catch (const std::exception& e) {
+            SetError(errorPrefix + e.what());
+        }
+    }
+    
+    void OnOK() override {
+        deferred.Resolve(convert(Env(), result));
+    }
+    
+    void OnError(const Napi::Error& error) override {
+        deferred.Reject(error.Value());
+    }
+
+private:
+    PromiseWorker(Napi::Env env, Work work, Convert convert, const std::string& errorPrefix)
+        : Napi::AsyncWorker(env),
+          deferred(Napi::Promise::Deferred::New(env)),
+          work(std::move(work)),
+          convert(std::move(convert)),
+          errorPrefix(errorPrefix) {}
+    
+    Napi::Promise::Deferred deferred;
+    Work work;
+    Convert convert;
+    std::string errorPrefix;
+    Result result;
+};
+
+// Result of registering one voter, built off the JS thread
+struct VoterRecord {
+    std::string voterHash;
+    std::string nullifierHash;
+    std::string trieRoot;
+    std::vector<std::string> merkleProof;
+    size_t size;
+};
+
+struct TrieStats {
+    bool initialized;
+    size_t size;
+    size_t nodeCount;
+    size_t memoryBytes;
+    std::string rootHash;
+    std::vector<std::string> voterHashes;
+};
+
+// Stats list only the first few keys; listVoterKeys pages through the rest
+static const size_t STATS_PREVIEW_KEYS = 16;
+static const size_t MAX_KEY_PAGE = 10000;
+
+static VoterRecord registerVoter(const std::string& voterInput, const std::string& salt,
+                                 uint64_t timestamp) {
+    TRIE_METRIC_TIME(PROCESS_VOTER);
+    VoterRecord record;
+    
+    // Hash fusion is pure, so it runs before taking the writer lock
+    std::shared_ptr<const FusionContext> fusion = fusionContext(salt, timestamp);
+    Digest voterHash = fusion->voterHashFusion(voterInput);
+    record.voterHash = HashFusion::toHex(voterHash);
+    record.nullifierHash = HashFusion::toHex(fusion->nullifier(voterHash));
+    
+    std::shared_ptr<WriteAheadLog> wal;
+    uint64_t sequence = 0;
+    {
+        std::unique_lock<std::shared_mutex> lock(trieMutex);
+        initializeTrie();
+        
+        // Logged before anything else sees the insert; a failed append
+        // takes it back out
+        wal = globalWal;
+        if (wal) {
+            globalTrie->savepoint();
+            try {
+                globalTrie->insert(record.voterHash, voterInput);
+                sequence = wal->append({{record.voterHash, voterInput}}, globalTrie->view().getRootDigest());
+            } catch (...) {
+                globalTrie->rollback();
+                throw;
+            }
+            globalTrie->release();
+        } else {
+            globalTrie->insert(record.voterHash, voterInput);
+        }
+        
+        appendVoterLeaves({record.voterHash});
+        record.trieRoot = globalTrie->getRootHash();
+        record.merkleProof = globalTrie->getMerkleProof(record.voterHash);
+        record.size = globalTrie->getSize();
+    }
+    
+    // Not acknowledged until the insert is durable
+    if (wal) {
+        wal->sync(sequence);
+    }
+    
+    return record;
+}
+
+// Insert already-fused voters (entries: hex hash, input; leaves: the same
+// hashes in binary) with one trie rehash and one log record, and wait for
+// the record to be durable. Returns the trie size; trieRoot gets the root.
+static size_t insertVoterBatch(const std::vector<std::pair<std::string, std::string>>& entries,
+                               const std::vector<Digest>& leaves, std::string& trieRoot) {
+    size_t size;
+    std::shared_ptr<WriteAheadLog> wal;
+    uint64_t sequence = 0;
+    {
+        std::unique_lock<std::shared_mutex> lock(trieMutex);
+        initializeTrie();
+        
+        // The whole batch is one log record, written before the voter tree
+        // sees the batch; a failed append takes it back out of the trie
+        wal = globalWal;
+        if (wal) {
+            globalTrie->savepoint();
+            try {
+                globalTrie->insertBatch(entries);
+                sequence = wal->append(entries, globalTrie->view().getRootDigest());
+            } catch (...) {
+                globalTrie->rollback();
+                throw;
+            }
+            globalTrie->release();
+        } else {
+            globalTrie->insertBatch(entries);
+        }
+        
+        appendVoterLeaves(leaves);
+        trieRoot = globalTrie->getRootHash();
+        size = globalTrie->getSize();
+    }
+    if (wal) {
+        wal->sync(sequence);
+    }
+    return size;
+}
+
+// Result of processVoterIDs: per voter, in input order, the voter hash
+// and nullifier as raw digests, VOTER_RECORD_BYTES each
+struct VoterBatch {
+    std::shared_ptr<std::vector<uint8_t>> records;
+    size_t count;
+    std::string trieRoot;
+    size_t size;
+};
+
+static const size_t VOTER_RECORD_BYTES = 2 * sizeof(Digest);
+
+static VoterBatch registerVoterBatch(const std::vector<std::string>& voterInputs,
+                                     const std::string& salt, uint64_t timestamp) {
+    TRIE_METRIC_TIME(PROCESS_VOTER_BATCH);
+    VoterBatch batch;
+    batch.count = voterInputs.size();
+    batch.records = std::make_shared<std::vector<uint8_t>>(batch.count * VOTER_RECORD_BYTES);
+    
+    std::vector<std::pair<std::string, std::string>> entries(batch.count);
+    std::vector<Digest> leaves(batch.count);
+    uint8_t* out = batch.records->data();
+    std::shared_ptr<const FusionContext> fusion = fusionContext(salt, timestamp);
+    ThreadPool::shared().parallelFor(batch.count, [&](size_t i) {
+        leaves[i] = fusion->voterHashFusion(voterInputs[i]);
+        Digest nullifier = fusion->nullifier(leaves[i]);
+        std::copy(leaves[i].begin(), leaves[i].end(), out + i * VOTER_RECORD_BYTES);
+        std::copy(nullifier.begin(), nullifier.end(), out + i * VOTER_RECORD_BYTES + sizeof(Digest));
+        entries[i] = {HashFusion::toHex(leaves[i]), voterInputs[i]};
+    });
+    
+    batch.size = insertVoterBatch(entries, leaves, batch.trieRoot);
+    return batch;
+}
+
+static bool lookupVoter(const std::string& voterHash) {
+    std::shared_lock<std::shared_mutex> lock(trieMutex);
+    TrieView view;
+    return registryView(view) && view.search(voterHash);
+}
+
+static TrieStats collectStats() {
+    std::shared_lock<std::shared_mutex> lock(trieMutex);
+    TrieStats stats;
+    
+    TrieView view;
+    if (!registryView(view)) {
+        stats.initialized = false;
+        stats.size = 0;
+        stats.nodeCount = 0;
+        stats.memoryBytes = 0;
+        return stats;
+    }
+    
+    stats.initialized = true;
+    stats.size = view.getSize();
+    stats.nodeCount = view.nodeCount;
+    stats.memoryBytes = view.nodeCount * sizeof(TrieNode) + view.labelBytes + view.valueBytes;
+    stats.rootHash = HashFusion::toHex(view.getRootDigest());
+    
+    // Key preview for debugging
+    for (const auto& key : view.listKeys("", "", STATS_PREVIEW_KEYS)) {
+        stats.voterHashes.push_back(key.substr(0, 16) + "...");
+    }
+    
+    return stats;
+}
+
+static Napi::Value voterRecordToObject(Napi::Env env, const VoterRecord& record) {
+    Napi::Object result = Napi::Object::New(env);
+    result.Set("voterHash", Napi::String::New(env, record.voterHash));
+    result.Set("nullifierHash", Napi::String::New(env, record.nullifierHash));
+    result.Set("trieRoot", Napi::String::New(env, record.trieRoot));
+    
+    // Convert merkle proof to JavaScript array
+    Napi::Array proofArray = Napi::Array::New(env, record.merkleProof.size());
+    for (size_t i = 0; i < record.merkleProof.size(); i++) {
+        proofArray.Set(i, Napi::String::New(env, record.merkleProof[i]));
+    }
+    result.Set("merkleProof", proofArray);
+    
+    // Add trie data for debugging
+    Napi::Object trieData = Napi::Object::New(env);
+    trieData.Set("size", Napi::Number::New(env, record.size));
+    trieData.Set("rootHash", Napi::String::New(env, record.trieRoot));
+    result.Set("trieData", trieData);
+    
+    return result;
+}
+
+static Napi::Value trieStatsToObject(Napi::Env env, const TrieStats& trieStats) {
+    Napi::Object stats = Napi::Object::New(env);
+    stats.Set("initialized", Napi::Boolean::New(env, trieStats.initialized));
+    stats.Set("size", Napi::Number::New(env, trieStats.size));
+    stats.Set("nodeCount", Napi::Number::New(env, trieStats.nodeCount));
+    stats.Set("memoryBytes", Napi::Number::New(env, trieStats.memoryBytes));
+    stats.Set("rootHash", Napi::String::New(env, trieStats.rootHash));
+    
+    if (trieStats.initialized) {
+        Napi::Array keysArray = Napi::Array::New(env, trieStats.voterHashes.size());
+        for (size_t i = 0; i < trieStats.voterHashes.size(); i++) {
+            keysArray.Set(i, Napi::String::New(env, trieStats.voterHashes[i]));
+        }
+        stats.Set("voterHashes", keysArray);
+    }
+    
+    return stats;
+}
+
+static bool checkVoterArgs(const Napi::CallbackInfo& info) {
+    if (info.Length() < 3) {
+        Napi::TypeError::New(info.Env(), "Expected 3 arguments: voterInput, salt, timestamp")
+            .ThrowAsJavaScriptException();
+        return false;
+    }
+    return true;
+}
+
+static bool checkVoterHashArg(const Napi::CallbackInfo& info) {
+    if (info.Length() < 1) {
+        Napi::TypeError::New(info.Env(), "Expected voterHash argument")
+            .ThrowAsJavaScriptException();
+        return false;
+    }
+    return true;
+}
+
+// 32-byte hex digest, with or without the 0x prefix ethers produces
+static bool digestFromJs(const std::string& hex, Digest& digest) {
+    bool prefixed = hex.size() > 2 && hex[0] == '0' && (hex[1] == 'x' || hex[1] == 'X');
+    return HashFusion::fromHex(prefixed ? hex.substr(2) : hex, digest);
+}
+
+// Buffers and Uint8Arrays are read in place; callers that pass one get
+// binary results back instead of hex strings
+static bool isBinary(const Napi::Value& value) {
+    return value.IsTypedArray() &&
+           value.As<Napi::TypedArray>().TypedArrayType() == napi_uint8_array;
+}
+
+// A hex string as above, or exactly 32 raw bytes
+static bool digestFromJs(const Napi::Value& value, Digest& digest) {
+    if (isBinary(value)) {
+        Napi::Uint8Array bytes = value.As<Napi::Uint8Array>();
+        if (bytes.ByteLength() != digest.size()) {
+            return false;
+        }
+        std::memcpy(digest.data(), bytes.Data(), digest.size());
+        return true;
+    }
+    return value.IsString() && digestFromJs(value.As<Napi::String>().Utf8Value(), digest);
+}
+
+// Trie key for a voter hash given as hex or as 32 raw bytes; a buffer of
+// any other length yields a key that is never registered
+static std::string voterHashFromJs(const Napi::Value& value) {
+    if (isBinary(value)) {
+        Napi::Uint8Array bytes = value.As<Napi::Uint8Array>();
+        return bytes.ByteLength() == sizeof(Digest) ? HashFusion::bytesToHex(bytes.Data(), sizeof(Digest))
+                                                    : std::string();
+    }
+    return value.As<Napi::String>().Utf8Value();
+}
+
+static bool isDigestList(const Napi::Value& value) {
+    return value.IsArray() || isBinary(value);
+}
+
+// An array of digests (hex or binary), or one buffer of digests back to back
+static bool readLeaves(Napi::Env env, const Napi::Value& value, std::vector<Digest>& leaves) {
+    if (isBinary(value)) {
+        Napi::Uint8Array bytes = value.As<Napi::Uint8Array>();
+        if (bytes.ByteLength() % sizeof(Digest) != 0) {
+            Napi::TypeError::New(env, "Leaf buffer length is not a multiple of 32 bytes")
+                .ThrowAsJavaScriptException();
+            return false;
+        }
+        leaves.resize(bytes.ByteLength() / sizeof(Digest));
+        std::memcpy(leaves.data(), bytes.Data(), bytes.ByteLength());
+        return true;
+    }
+    
+    Napi::Array array = value.As<Napi::Array>();
+    leaves.resize(array.Length());
+    for (uint32_t i = 0; i < array.Length(); i++) {
+        if (!digestFromJs(array.Get(i), leaves[i])) {
+            Napi::TypeError::New(env, "Leaf " + std::to_string(i) + " is not a 32-byte digest")
+                .ThrowAsJavaScriptException();
+            return false;
+        }
+    }
+    return true;
+}
+
+// Wraps items in a Buffer without copying; the Buffer keeps them alive
+template <typename T>
+static Napi::Buffer<uint8_t> externalBuffer(Napi::Env env, std::shared_ptr<std::vector<T>> items) {
+    auto* owner = new std::shared_ptr<std::vector<T>>(std::move(items));
+    return Napi::Buffer<uint8_t>::New(env,
+        reinterpret_cast<uint8_t*>((*owner)->data()), (*owner)->size() * sizeof(T),
+        [](Napi::Env, uint8_t*, std::shared_ptr<std::vector<T>>* hint) { delete hint; },
+        owner);
+}
+
+static Napi::Value digestToJs(Napi::Env env, const Digest& digest, bool binary) {
+    if (binary) {
+        return Napi::Buffer<uint8_t>::Copy(env, digest.data(), digest.size());
+    }
+    return Napi::String::New(env, HashFusion::toHex(digest));
+}
+
+// Calls fn with the hash policy named by algorithm; false if unknown.
+// "keccak256-eth" matches VotingWithMerkle.sol and frontend/js/merkle.js
+template <typename Fn>
+static bool withHashPolicy(const std::string& algorithm, Fn fn) {
+    if (algorithm == "keccak256-eth") {
+        fn(Keccak256Policy());
+    } else if (algorithm == "sha256") {
+        fn(Sha256HexPolicy());
+    } else if (algorithm == "blake2b-256") {
+        fn(Blake2bPolicy());
+    } else {
+        return false;
+    }
+    return true;
+}
+
+static std::string treeAlgorithmArg(const Napi::CallbackInfo& info, size_t index) {
+    if (info.Length() <= index || info[index].IsUndefined()) {
+        return "keccak256-eth";
+    }
+    return info[index].As<Napi::String>().Utf8Value();
+}
+
+static Napi::Array digestsToArray(Napi::Env env, const std::vector<Digest>& digests) {
+    Napi::Array array = Napi::Array::New(env, digests.size());
+    for (size_t i = 0; i < digests.size(); i++) {
+        array.Set(i, Napi::String::New(env, HashFusion::toHex(digests[i])));
+    }
+    return array;
+}
+
+// Binary: one contiguous buffer of 32-byte digests
+static Napi::Value digestsToJs(Napi::Env env, std::vector<Digest> digests, bool binary) {
+    if (binary) {
+        return externalBuffer(env, std::make_shared<std::vector<Digest>>(std::move(digests)));
+    }
+    return digestsToArray(env, digests);
+}
+
+// binary: leaves and proof as contiguous digest buffers
+static Napi::Object multiProofToObject(Napi::Env env, const MerkleMultiProof& multiProof,
+                                       bool binary) {
+    Napi::Object result = Napi::Object::New(env);
+    result.Set("leafCount", Napi::Number::New(env, multiProof.leafCount));
+    
+    Napi::Array indices = Napi::Array::New(env, multiProof.indices.size());
+    for (size_t i = 0; i < multiProof.indices.size(); i++) {
+        indices.Set(i, Napi::Number::New(env, multiProof.indices[i]));
+    }
+    result.Set("indices", indices);
+    result.Set("leaves", digestsToJs(env, multiProof.leaves, binary));
+    result.Set("proof", digestsToJs(env, multiProof.proof, binary));
+    
+    Napi::Array flags = Napi::Array::New(env, multiProof.proofFlags.size());
+    for (size_t i = 0; i < multiProof.proofFlags.size(); i++) {
+        flags.Set(i, Napi::Boolean::New(env, multiProof.proofFlags[i]));
+    }
+    result.Set("proofFlags", flags);
+    result.Set("contractCompatible", Napi::Boolean::New(env, multiProof.contractCompatible));
+    return result;
+}
+
+// Inverse of multiProofToObject; proofFlags are not needed to verify
+static bool multiProofFromObject(Napi::Env env, const Napi::Object& object,
+                                 MerkleMultiProof& multiProof) {
+    if (!object.Get("indices").IsArray() || !isDigestList(object.Get("leaves")) ||
+        !isDigestList(object.Get("proof"))) {
+        Napi::TypeError::New(env, "Expected { leafCount, indices[], leaves[], proof[] }")
+            .ThrowAsJavaScriptException();
+        return false;
+    }
+    
+    multiProof.leafCount = object.Get("leafCount").As<Napi::Number>().Int64Value();
+    Napi::Array indices = object.Get("indices").As<Napi::Array>();
+    multiProof.indices.resize(indices.Length());
+    for (uint32_t i = 0; i < indices.Length(); i++) {
+        multiProof.indices[i] = indices.Get(i).As<Napi::Number>().Int64Value();
+    }
+    multiProof.contractCompatible = false;
+    
+    return readLeaves(env, object.Get("leaves"), multiProof.leaves) &&
+           readLeaves(env, object.Get("proof"), multiProof.proof);
+}
+
+static Napi::Object trieProofToObject(Napi::Env env, const TrieProof& proof) {
+    Napi::Object result = Napi::Object::New(env);
+    result.Set("key", Napi::String::New(env, proof.key));
+    
+    Napi::Array levels = Napi::Array::New(env, proof.levels.size());
+    for (size_t i = 0; i < proof.levels.size(); i++) {
+        const TrieProofLevel& level = proof.levels[i];
+        Napi::Object levelObject = Napi::Object::New(env);
+        levelObject.Set("value", Napi::String::New(env, level.value));
+        levelObject.Set("endOfWord", Napi::Boolean::New(env, level.endOfWord));
+        
+        Napi::Array siblings = Napi::Array::New(env, level.siblings.size());
+        for (size_t j = 0; j < level.siblings.size(); j++) {
+            Napi::Object sibling = Napi::Object::New(env);
+            sibling.Set("char", Napi::String::New(env, std::string(1, level.siblings[j].first)));
+            sibling.Set("hash", Napi::String::New(env, HashFusion::toHex(level.siblings[j].second)));
+            siblings.Set(j, sibling);
+        }
+        levelObject.Set("siblings", siblings);
+        levels.Set(i, levelObject);
+    }
+    result.Set("levels", levels);
+    
+    return result;
+}
+
+// Inverse of trieProofToObject; false (with a pending TypeError) if malformed
+static bool trieProofFromObject(Napi::Env env, const Napi::Value& value, TrieProof& proof) {
+    if (!value.IsObject() || !value.As<Napi::Object>().Get("levels").IsArray()) {
+        Napi::TypeError::New(env, "Expected { key, levels[] } trie proof")
+            .ThrowAsJavaScriptException();
+        return false;
+    }
+    
+    Napi::Object object = value.As<Napi::Object>();
+    proof.key = object.Get("key").As<Napi::String>().Utf8Value();
+    Napi::Array levels = object.Get("levels").As<Napi::Array>();
+    proof.levels.resize(levels.Length());
+    
+    for (uint32_t i = 0; i < levels.Length(); i++) {
+        Napi::Object levelObject = levels.Get(i).As<Napi::Object>();
+        TrieProofLevel& level = proof.levels[i];
+        level.value = levelObject.Get("value").As<Napi::String>().Utf8Value();
+        level.endOfWord = levelObject.Get("endOfWord").ToBoolean().Value();
+        level.siblings.clear();
+        
+        Napi::Array siblings = levelObject.Get("siblings").As<Napi::Array>();
+        for (uint32_t j = 0; j < siblings.Length(); j++) {
+            Napi::Object sibling = siblings.Get(j).As<Napi::Object>();
+            std::string edge = sibling.Get("char").As<Napi::String>().Utf8Value();
+            Digest hash;
+            if (edge.size() != 1 ||
+                !digestFromJs(sibling.Get("hash"), hash)) {
+                Napi::TypeError::New(env, "Malformed trie proof sibling")
+                    .ThrowAsJavaScriptException();
+                return false;
+            }
+            level.siblings.emplace_back(edge[0], hash);
+        }
+    }
+    
+    return true;
+}
+
+// Process voter ID with trie hash fusion
+Napi::Object ProcessVoterID(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+    
+    if (!checkVoterArgs(info)) {
+        return Napi::Object::New(env);
+    }
+    
+    std::string voterInput = info[0].As<Napi::String>().Utf8Value();
+    std::string salt = info[1].As<Napi::String>().Utf8Value();
+    uint64_t timestamp = info[2].As<Napi::Number>().Int64Value();
+    
+    try {
+        return voterRecordToObject(env, registerVoter(voterInput, salt, timestamp))
+            .As<Napi::Object>();
+    
+    } catch (const std::exception& e) {
+        Napi::Error::New(env, std::string("Trie hash fusion error: ") + e.what())
+            .ThrowAsJavaScriptException();
+        return Napi::Object::New(env);
+    }
+}
+
+// Promise-returning ProcessVoterID; hashing and insert run off the JS thread
+Napi::Value ProcessVoterIDAsync(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+    
+    if (!checkVoterArgs(info)) {
+        return env.Undefined();
+    }
+    
+    std::string voterInput = info[0].As<Napi::String>().Utf8Value();
+    std::string salt = info[1].As<Napi::String>().Utf8Value();
+    uint64_t timestamp = info[2].As<Napi::Number>().Int64Value();
+    
+    return PromiseWorker<VoterRecord>::Start(env,
+        [voterInput, salt, timestamp] { return registerVoter(voterInput, salt, timestamp); },
+        voterRecordToObject, "Trie hash fusion error: ");
+}
+
+// Bulk-load an electoral roll: fuse every voter ID in parallel, then
+// merge the whole roll into the trie with one bottom-up rehash
+Napi::Object BulkLoadVoters(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+    
+    if (info.Length() < 3 || !info[0].IsArray()) {
+        Napi::TypeError::New(env, "Expected 3 arguments: voterInputs[], salt, timestamp")
+            .ThrowAsJavaScriptException();
+        return Napi::Object::New(env);
+    }
+    
+    Napi::Array inputs = info[0].As<Napi::Array>();
+    std::string salt = info[1].As<Napi::String>().Utf8Value();
+    uint64_t timestamp = info[2].As<Napi::Number>().Int64Value();
+    
+    try {
+        std::vector<std::pair<std::string, std::string>> entries(inputs.Length());
+        for (uint32_t i = 0; i < inputs.Length(); i++) {
+            entries[i].second = inputs.Get(i).As<Napi::String>().Utf8Value();
+        }
+        
+        std::vector<Digest> leaves(entries.size());
+        std::shared_ptr<const FusionContext> fusion = fusionContext(salt, timestamp);
+        ThreadPool::shared().parallelFor(entries.size(), [&](size_t i) {
+            leaves[i] = fusion->voterHashFusion(entries[i].second);
+            entries[i].first = HashFusion::toHex(leaves[i]);
+        });
+        
+        std::string trieRoot;
+        size_t size = insertVoterBatch(entries, leaves, trieRoot);
+        
+        Napi::Object result = Napi::Object::New(env);
+        Napi::Array hashArray = Napi::Array::New(env, entries.size());
+        for (size_t i = 0; i < entries.size(); i++) {
+            hashArray.Set(i, Napi::String::New(env, entries[i].first));
+        }
+        result.Set("voterHashes", hashArray);
+        result.Set("trieRoot", Napi::String::New(env, trieRoot));
+        result.Set("size", Napi::Number::New(env, size));
+        
+        return result;
+    
+    } catch (const std::exception& e) {
+        Napi::Error::New(env, std::string("Trie bulk load error: ") + e.what())
+            .ThrowAsJavaScriptException();
+        return Napi::Object::New(env);
+    }
+}
+
+// Voter inputs packed one per line into a Buffer or Uint8Array, as they
+// arrive from the serial reader or a roll file; a trailing newline and
+// CRLF line ends are accepted, empty lines are skipped
+static bool readVoterLines(const Napi::CallbackInfo& info, std::vector<std::string>& voterInputs) {
+    if (info.Length() < 3 || !info[0].IsTypedArray() ||
+        info[0].As<Napi::TypedArray>().TypedArrayType() != napi_uint8_array) {
+        Napi::TypeError::New(info.Env(), "Expected 3 arguments: voterInputs (Buffer), salt, timestamp")
+            .ThrowAsJavaScriptException();
+        return false;
+    }
+    
+    Napi::Uint8Array bytes = info[0].As<Napi::Uint8Array>();
+    const char* data = reinterpret_cast<const char*>(bytes.Data());
+    const char* end = data + bytes.ByteLength();
+    while (data < end) {
+        const char* newline = static_cast<const char*>(std::memchr(data, '\n', end - data));
+        const char* lineEnd = newline ? newline : end;
+        size_t length = lineEnd - data;
+        if (length > 0 && data[length - 1] == '\r') {
+            length--;
+        }
+        if (length > 0) {
+            voterInputs.emplace_back(data, length);
+        }
+        data = newline ? newline + 1 : end;
+    }
+    return true;
+}
+
+static Napi::Value voterBatchToObject(Napi::Env env, const VoterBatch& batch) {
+    Napi::Object result = Napi::Object::New(env);
+    result.Set("records", externalBuffer(env, batch.records));
+    result.Set("count", Napi::Number::New(env, batch.count));
+    result.Set("recordBytes", Napi::Number::New(env, VOTER_RECORD_BYTES));
+    result.Set("trieRoot", Napi::String::New(env, batch.trieRoot));
+    result.Set("size", Napi::Number::New(env, batch.size));
+    return result;
+}
+
+// Register a batch of voters in one call: processVoterIDs(buffer, salt,
+// timestamp) -> { records, count, recordBytes, trieRoot, size }. Record i
+// of `records` is voter i's hash then nullifier, 32 raw bytes each; use
+// getTrieProof for proofs, since the batch shares one root
+Napi::Value ProcessVoterIDs(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+    
+    std::vector<std::string> voterInputs;
+    if (!readVoterLines(info, voterInputs)) {
+        return env.Undefined();
+    }
+    std::string salt = info[1].As<Napi::String>().Utf8Value();
+    uint64_t timestamp = info[2].As<Napi::Number>().Int64Value();
+    
+    try {
+        return voterBatchToObject(env, registerVoterBatch(voterInputs, salt, timestamp));
+    
+    } catch (const std::exception& e) {
+        Napi::Error::New(env, std::string("Trie batch error: ") + e.what())
+            .ThrowAsJavaScriptException();
+        return env.Undefined();
+    }
+}
+
+// Promise-returning ProcessVoterIDs; the buffer is split on the JS thread,
+// hashing and the insert run off it
+Napi::Value ProcessVoterIDsAsync(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+    
+    auto voterInputs = std::make_shared<std::vector<std::string>>();
+    if (!readVoterLines(info, *voterInputs)) {
+        return env.Undefined();
+    }
+    std::string salt = info[1].As<Napi::String>().Utf8Value();
+    uint64_t timestamp = info[2].As<Napi::Number>().Int64Value();
+    
+    return PromiseWorker<VoterBatch>::Start(env,
+        [voterInputs, salt, timestamp] { return registerVoterBatch(*voterInputs, salt, timestamp); },
+        voterBatchToObject, "Trie batch error: ");
+}
+
+// Verify voter in trie; the hash may be hex or 32 raw bytes
+Napi::Boolean VerifyVoter(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+    
+    if (!checkVoterHashArg(info)) {
+        return Napi::Boolean::New(env, false);
+    }
+    
+    std::string voterHash = voterHashFromJs(info[0]);
+    
+    bool exists = lookupVoter(voterHash);
+    return Napi::Boolean::New(env, exists);
+}
+
+// Promise-returning VerifyVoter; only waits on in-flight writers
+Napi::Value VerifyVoterAsync(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+    
+    if (!checkVoterHashArg(info)) {
+        return env.Undefined();
+    }
+    
+    std::string voterHash = voterHashFromJs(info[0]);
+    
+    return PromiseWorker<bool>::Start(env,
+        [voterHash] { return lookupVoter(voterHash); },
+        [](Napi::Env env, const bool& exists) -> Napi::Value {
+            return Napi::Boolean::New(env, exists);
+        },
+        "Trie lookup error: ");
+}
+
+// Get trie statistics
+Napi::Object GetTrieStats(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+    
+    return trieStatsToObject(env, collectStats()).As<Napi::Object>();
+}
+
+// Promise-returning GetTrieStats; the key walk runs off the JS thread
+Napi::Value GetTrieStatsAsync(const Napi::CallbackInfo& info) {
+    return PromiseWorker<TrieStats>::Start(info.Env(), collectStats, trieStatsToObject,
+                                           "Trie stats error: ");
+}
+
+// One page of registered voter hashes in key order:
+// listVoterKeys({ prefix, cursor, limit }) -> { keys, nextCursor }.
+// Pass nextCursor back to continue; it is null on the last page.
+Napi::Value ListVoterKeys(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+    
+    std::string prefix;
+    std::string cursor;
+    size_t limit = 100;
+    if (info.Length() > 0 && info[0].IsObject()) {
+        Napi::Object options = info[0].As<Napi::Object>();
+        if (options.Has("prefix") && options.Get("prefix").IsString()) {
+            prefix = options.Get("prefix").As<Napi::String>().Utf8Value();
+        }
+        if (options.Has("cursor") && options.Get("cursor").IsString()) {
+            cursor = options.Get("cursor").As<Napi::String>().Utf8Value();
+        }
+        if (options.Has("limit") && options.Get("limit").IsNumber()) {
+            int64_t requested = options.Get("limit").As<Napi::Number>().Int64Value();
+            limit = static_cast<size_t>(std::max<int64_t>(1, std::min<int64_t>(requested, MAX_KEY_PAGE)));
+        }
+    }
+    
+    std::vector<std::string> keys;
+    {
+        std::shared_lock<std::shared_mutex> lock(trieMutex);
+        TrieView view;
+        if (registryView(view)) {
+            // One extra key tells whether another page follows
+            keys = view.listKeys(prefix, cursor, limit + 1);
+        }
+    }
+    
+    bool more = keys.size() > limit;
+    if (more) {
+        keys.pop_back();
+    }
+    
+    Napi::Object result = Napi::Object::New(env);
+    Napi::Array keyArray = Napi::Array::New(env, keys.size());
+    for (size_t i = 0; i < keys.size(); i++) {
+        keyArray.Set(i, Napi::String::New(env, keys[i]));
+    }
+    result.Set("keys", keyArray);
+    result.Set("nextCursor", more ? Napi::Value(Napi::String::New(env, keys.back())) : env.Null());
+    return result;
+}
+
+// Digest of data under a generateHash algorithm name into out, which
+// holds Blake2bStream::MAX_OUTPUT bytes; returns the digest length.
+// Unknown names fall back to SHA-256
+static size_t hashByAlgorithm(const std::string& algorithm, const uint8_t* data, size_t length,
+                              uint8_t* out) {
+    Digest digest;
+    if (algorithm == "keccak256") {
+        digest = Sha256Stream().update("keccak:", 7).update(data, length).finish();
+    } else if (algorithm == "blake2b") {
+        digest = Sha256Stream().update("blake2b:", 8).update(data, length).finish();
+    } else if (algorithm == "keccak256-eth") {
+        digest = Keccak256Stream::hash(data, length);
+    } else if (algorithm == "blake2b-256") {
+        digest = Blake2bStream::hash(data, length);
+    } else if (algorithm == "blake2b-512") {
+        Blake2bStream(Blake2bStream::MAX_OUTPUT).update(data, length).finish(out);
+        return Blake2bStream::MAX_OUTPUT;
+    } else {
+        digest = HashFusion::sha256Digest(data, length);
+    }
+    std::copy(digest.begin(), digest.end(), out);
+    return digest.size();
+}
+
+// Generate hash using different algorithms. A Buffer or Uint8Array input
+// is hashed in place and the digest returned as a Buffer; a string input
+// gets the hex digest
+Napi::Value GenerateHash(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+    
+    if (info.Length() < 2) {
+        Napi::TypeError::New(env, "Expected input and algorithm arguments")
+            .ThrowAsJavaScriptException();
+        return Napi::String::New(env, "");
+    }
+    
+    std::string algorithm = info[1].As<Napi::String>().Utf8Value();
+    uint8_t digest[Blake2bStream::MAX_OUTPUT];
+    
+    if (isBinary(info[0])) {
+        Napi::Uint8Array input = info[0].As<Napi::Uint8Array>();
+        size_t length = hashByAlgorithm(algorithm, input.Data(), input.ByteLength(), digest);
+        return Napi::Buffer<uint8_t>::Copy(env, digest, length);
+    }
+    
+    std::string input = info[0].As<Napi::String>().Utf8Value();
+    size_t length = hashByAlgorithm(algorithm, reinterpret_cast<const uint8_t*>(input.data()),
+                                    input.size(), digest);
+    return Napi::String::New(env, HashFusion::bytesToHex(digest, length));
+}
+
+// Merkle root of leaves under sorted-pair hashing, odd nodes carried up;
+// a leaf buffer gets the root back as a Buffer
+Napi::Value ComputeMerkleRoot(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+    
+    if (info.Length() < 1 || !isDigestList(info[0])) {
+        Napi::TypeError::New(env, "Expected leaves[] and optional algorithm")
+            .ThrowAsJavaScriptException();
+        return env.Undefined();
+    }
+    
+    std::vector<Digest> leaves;
+    if (!readLeaves(env, info[0], leaves)) {
+        return env.Undefined();
+    }
+    
+    Digest root;
+    bool known = withHashPolicy(treeAlgorithmArg(info, 1), [&](auto policy) {
+        root = MerkleTree<decltype(policy)>::computeRoot(leaves);
+    });
+    if (!known) {
+        Napi::TypeError::New(env, "Unknown Merkle tree algorithm").ThrowAsJavaScriptException();
+        return env.Undefined();
+    }
+    
+    return digestToJs(env, root, isBinary(info[0]));
+}
+
+// Sibling path for one leaf; empty when the leaf is not in the set.
+// A binary leaf gets the path back as one buffer of digests
+Napi::Value ComputeMerkleProof(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+    
+    if (info.Length() < 2 || !isDigestList(info[0])) {
+        Napi::TypeError::New(env, "Expected leaves[], leaf and optional algorithm")
+            .ThrowAsJavaScriptException();
+        return env.Undefined();
+    }
+    
+    std::vector<Digest> leaves;
+    Digest leaf;
+    if (!readLeaves(env, info[0], leaves)) {
+        return env.Undefined();
+    }
+    if (!digestFromJs(info[1], leaf)) {
+        Napi::TypeError::New(env, "Leaf is not a 32-byte digest").ThrowAsJavaScriptException();
+        return env.Undefined();
+    }
+    
+    size_t index = std::find(leaves.begin(), leaves.end(), leaf) - leaves.begin();
+    std::vector<Digest> proof;
+    bool known = withHashPolicy(treeAlgorithmArg(info, 2), [&](auto policy) {
+        proof = MerkleTree<decltype(policy)>::computeProof(leaves, index);
+    });
+    if (!known) {
+        Napi::TypeError::New(env, "Unknown Merkle tree algorithm").ThrowAsJavaScriptException();
+        return env.Undefined();
+    }
+    
+    return digestsToJs(env, std::move(proof), isBinary(info[1]));
+}
+
+// Proof for one registered voter in the voter list tree; null if unknown.
+// Same layout and hashes as HashFusion::generateMerkleProof over the list;
+// a binary voter hash gets root and proof back as buffers
+Napi::Value GetVoterMerkleProof(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+    
+    if (!checkVoterHashArg(info)) {
+        return env.Null();
+    }
+    
+    Digest leaf;
+    bool binary = isBinary(info[0]);
+    if (!digestFromJs(info[0], leaf)) {
+        return env.Null();
+    }
+    
+    ensureVoterTree();
+    std::shared_lock<std::shared_mutex> lock(trieMutex);
+    size_t index = voterTree ? voterTree->indexOf(leaf) : MerkleTree<Sha256HexPolicy>::NOT_FOUND;
+    if (index == MerkleTree<Sha256HexPolicy>::NOT_FOUND) {
+        return env.Null();
+    }
+    
+    Napi::Object result = Napi::Object::New(env);
+    result.Set("leafIndex", Napi::Number::New(env, index));
+    result.Set("leafCount", Napi::Number::New(env, voterTree->size()));
+    result.Set("root", digestToJs(env, voterTree->getRoot(), binary));
+    result.Set("proof", digestsToJs(env, voterTree->getProof(index), binary));
+    return result;
+}
+
+// Deduplicated proof for several registered voters in the voter list
+// tree (precinct audits); unknown voter hashes are left out
+Napi::Value GetVoterMultiProof(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+    
+    if (info.Length() < 1 || !isDigestList(info[0])) {
+        Napi::TypeError::New(env, "Expected voterHashes[]").ThrowAsJavaScriptException();
+        return env.Undefined();
+    }
+    
+    std::vector<Digest> leaves;
+    bool binary = isBinary(info[0]);
+    if (!readLeaves(env, info[0], leaves)) {
+        return env.Undefined();
+    }
+    
+    ensureVoterTree();
+    std::shared_lock<std::shared_mutex> lock(trieMutex);
+    if (!voterTree) {
+        return multiProofToObject(env, MerkleTree<Sha256HexPolicy>().getMultiProof({}), binary);
+    }
+    
+    std::vector<size_t> indices;
+    for (const auto& leaf : leaves) {
+        size_t index = voterTree->indexOf(leaf);
+        if (index != MerkleTree<Sha256HexPolicy>::NOT_FOUND) {
+            indices.push_back(index);
+        }
+    }
+    
+    MerkleMultiProof multiProof = voterTree->getMultiProof(indices);
+    Napi::Object result = multiProofToObject(env, multiProof, binary);
+    result.Set("root", digestToJs(env, voterTree->getRoot(), binary));
+    return result;
+}
+
+// Multiproof for targets within leaves; see computeMerkleProof
+Napi::Value ComputeMultiProof(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+    
+    if (info.Length() < 2 || !isDigestList(info[0]) || !isDigestList(info[1])) {
+        Napi::TypeError::New(env, "Expected leaves[], targets[] and optional algorithm")
+            .ThrowAsJavaScriptException();
+        return env.Undefined();
+    }
+    
+    std::vector<Digest> leaves, targets;
+    bool binary = isBinary(info[0]);
+    if (!readLeaves(env, info[0], leaves) || !readLeaves(env, info[1], targets)) {
+        return env.Undefined();
+    }
+    
+    MerkleMultiProof multiProof;
+    Digest root;
+    bool known = withHashPolicy(treeAlgorithmArg(info, 2), [&](auto policy) {
+        MerkleTree<decltype(policy)> tree(leaves);
+        std::vector<size_t> indices;
+        for (const auto& target : targets) {
+            indices.push_back(tree.indexOf(target));
+        }
+        multiProof = tree.getMultiProof(indices);
+        root = tree.getRoot();
+    });
+    if (!known) {
+        Napi::TypeError::New(env, "Unknown Merkle tree algorithm").ThrowAsJavaScriptException();
+        return env.Undefined();
+    }
+    
+    Napi::Object result = multiProofToObject(env, multiProof, binary);
+    result.Set("root", digestToJs(env, root, binary));
+    return result;
+}
+
+// Verify a multiproof object against a root in one pass
+Napi::Value VerifyMultiProof(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+    
+    if (info.Length() < 2 || !info[0].IsObject()) {
+        Napi::TypeError::New(env, "Expected multiProof, root and optional algorithm")
+            .ThrowAsJavaScriptException();
+        return env.Undefined();
+    }
+    
+    MerkleMultiProof multiProof;
+    Digest root;
+    if (!multiProofFromObject(env, info[0].As<Napi::Object>(), multiProof)) {
+        return env.Undefined();
+    }
+    if (!digestFromJs(info[1], root)) {
+        return Napi::Boolean::New(env, false);
+    }
+    
+    bool valid = false;
+    bool known = withHashPolicy(treeAlgorithmArg(info, 2), [&](auto policy) {
+        valid = MerkleTree<decltype(policy)>::verifyMultiProof(multiProof, root);
+    });
+    if (!known) {
+        Napi::TypeError::New(env, "Unknown Merkle tree algorithm").ThrowAsJavaScriptException();
+        return env.Undefined();
+    }
+    
+    return Napi::Boolean::New(env, valid);
+}
+
+// Structured proof of a registered voter in the trie; null if unknown
+Napi::Value GetTrieProof(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+    
+    if (!checkVoterHashArg(info)) {
+        return env.Null();
+    }
+    
+    std::string voterHash = voterHashFromJs(info[0]);
+    bool historical = info.Length() > 1 && !info[1].IsUndefined();
+    
+    std::shared_lock<std::shared_mutex> lock(trieMutex);
+    TrieView view;
+    TrieProof proof;
+    if (historical) {
+        // Against a committed version instead of the current trie
+        int64_t version = info[1].As<Napi::Number>().Int64Value();
+        if (!globalTrie || version <= 0 || !globalTrie->view(static_cast<uint64_t>(version), view)) {
+            return env.Null();
+        }
+    } else if (!registryView(view)) {
+        return env.Null();
+    }
+    if (!view.getTrieProof(voterHash, proof)) {
+        return env.Null();
+    }
+    
+    Napi::Object result = trieProofToObject(env, proof);
+    result.Set("value", Napi::String::New(env, proof.levels.back().value));
+    result.Set("root", Napi::String::New(env, HashFusion::toHex(view.getRootDigest())));
+    return result;
+}
+
+// Recompute the trie root from a structured proof; needs no trie state
+Napi::Value VerifyTrieProof(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+    
+    if (info.Length() < 2) {
+        Napi::TypeError::New(env, "Expected proof and root").ThrowAsJavaScriptException();
+        return env.Undefined();
+    }
+    
+    TrieProof proof;
+    Digest root;
+    if (!trieProofFromObject(env, info[0], proof)) {
+        return env.Undefined();
+    }
+    if (!digestFromJs(info[1], root)) {
+        return Napi::Boolean::New(env, false);
+    }
+    
+    return Napi::Boolean::New(env, MerkleTrie::verifyTrieProof(proof, root));
+}
+
+// Verify many structured proofs against one root across the thread pool
+Napi::Value VerifyTrieProofs(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+    
+    if (info.Length() < 2 || !info[0].IsArray()) {
+        Napi::TypeError::New(env, "Expected proofs[] and root").ThrowAsJavaScriptException();
+        return env.Undefined();
+    }
+    
+    Napi::Array proofArray = info[0].As<Napi::Array>();
+    std::vector<TrieProof> proofs(proofArray.Length());
+    for (uint32_t i = 0; i < proofArray.Length(); i++) {
+        if (!trieProofFromObject(env, proofArray.Get(i), proofs[i])) {
+            return env.Undefined();
+        }
+    }
+    
+    Digest root;
+    std::vector<uint8_t> results(proofs.size(), 0);
+    if (digestFromJs(info[1], root)) {
+        results = MerkleTrie::verifyTrieProofs(proofs, root);
+    }
+    
+    Napi::Array resultArray = Napi::Array::New(env, results.size());
+    for (size_t i = 0; i < results.size(); i++) {
+        resultArray.Set(i, Napi::Boolean::New(env, results[i] != 0));
+    }
+    return resultArray;
+}
+
+static bool readNullifierArg(const Napi::CallbackInfo& info, Digest& nullifier) {
+    if (info.Length() < 1 || !digestFromJs(info[0], nullifier)) {
+        Napi::TypeError::New(info.Env(), "Expected nullifier as a 32-byte digest")
+            .ThrowAsJavaScriptException();
+        return false;
+    }
+    return true;
+}
+
+// Atomically record a nullifier; false if it was already spent (double vote)
+Napi::Boolean SpendNullifier(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+    
+    Digest nullifier;
+    if (!readNullifierArg(info, nullifier)) {
+        return Napi::Boolean::New(env, false);
+    }
+    
+    std::shared_lock<std::shared_mutex> lock(nullifierMutex);
+    bool fresh = nullifierSet.insert(nullifier);
+    if (fresh) {
+        std::lock_guard<std::mutex> pendingLock(pendingMutex);
+        pendingNullifiers.push_back(nullifier);
+    }
+    return Napi::Boolean::New(env, fresh);
+}
+
+Napi::Boolean IsNullifierSpent(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+    
+    Digest nullifier;
+    if (!readNullifierArg(info, nullifier)) {
+        return Napi::Boolean::New(env, false);
+    }
+    
+    std::shared_lock<std::shared_mutex> lock(nullifierMutex);
+    return Napi::Boolean::New(env, nullifierSet.contains(nullifier));
+}
+
+Napi::Object GetNullifierStats(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+    
+    std::shared_lock<std::shared_mutex> lock(nullifierMutex);
+    Napi::Object stats = Napi::Object::New(env);
+    stats.Set("size", Napi::Number::New(env, nullifierSet.size()));
+    stats.Set("capacity", Napi::Number::New(env, nullifierSet.capacity()));
+    stats.Set("memoryBytes", Napi::Number::New(env, nullifierSet.memoryBytes()));
+    stats.Set("treeMemoryBytes", Napi::Number::New(env, nullifierTree.memoryBytes()));
+    std::lock_guard<std::mutex> pendingLock(pendingMutex);
+    stats.Set("pendingTreeInserts", Napi::Number::New(env, pendingNullifiers.size()));
+    return stats;
+}
+
+// Apply queued spends to nullifierTree and return its root
+static Digest flushNullifierTree() {
+    std::unique_lock<std::shared_mutex> lock(nullifierMutex);
+    if (!pendingNullifiers.empty()) {
+        nullifierTree.insertBatch(pendingNullifiers);
+        pendingNullifiers.clear();
+    }
+    return nullifierTree.getRoot();
+}
+
+static Napi::Object nullifierProofToObject(Napi::Env env, const SparseMerkleProof& proof,
+                                           const Digest& root, bool binary) {
+    Napi::Object result = Napi::Object::New(env);
+    result.Set("nullifier", digestToJs(env, proof.key, binary));
+    result.Set("spent", Napi::Boolean::New(env, proof.included));
+    result.Set("bitmap", digestToJs(env, proof.bitmap, binary));
+    result.Set("siblings", digestsToJs(env, proof.siblings, binary));
+    result.Set("root", digestToJs(env, root, binary));
+    return result;
+}
+
+// Root of the spent-nullifier sparse Merkle tree
+Napi::Value GetNullifierRoot(const Napi::CallbackInfo& info) {
+    return Napi::String::New(info.Env(), HashFusion::toHex(flushNullifierTree()));
+}
+
+// Proof that a nullifier is spent, or that it is not (spent: false):
+// { nullifier, spent, bitmap, siblings, root }. Bit i of the bitmap marks
+// a non-empty sibling at depth i + 1; siblings lists those top-down
+Napi::Value GetNullifierProof(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+    
+    Digest nullifier;
+    if (!readNullifierArg(info, nullifier)) {
+        return env.Undefined();
+    }
+    
+    flushNullifierTree();
+    std::shared_lock<std::shared_mutex> lock(nullifierMutex);
+    SparseMerkleProof proof;
+    nullifierTree.getProof(nullifier, proof);
+    return nullifierProofToObject(env, proof, nullifierTree.getRoot(), isBinary(info[0]));
+}
+
+// getNullifierProof for many nullifiers at once, built across the pool
+Napi::Value GetNullifierProofs(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+    
+    if (info.Length() < 1 || !isDigestList(info[0])) {
+        Napi::TypeError::New(env, "Expected nullifiers[]").ThrowAsJavaScriptException();
+        return env.Undefined();
+    }
+    
+    std::vector<Digest> nullifiers;
+    if (!readLeaves(env, info[0], nullifiers)) {
+        return env.Undefined();
+    }
+    
+    flushNullifierTree();
+    std::shared_lock<std::shared_mutex> lock(nullifierMutex);
+    std::vector<SparseMerkleProof> proofs = nullifierTree.getProofs(nullifiers);
+    bool binary = isBinary(info[0]);
+    
+    Napi::Array result = Napi::Array::New(env, proofs.size());
+    for (size_t i = 0; i < proofs.size(); i++) {
+        result.Set(i, nullifierProofToObject(env, proofs[i], nullifierTree.getRoot(), binary));
     }
+    return result;
 }
 
-// Process voter ID with trie hash fusion
-Napi::Object ProcessVoterID(const Napi::CallbackInfo& info) {
+// Check a getNullifierProof result against a root; needs no tree state
+Napi::Value VerifyNullifierProof(const Napi::CallbackInfo& info) {
     Napi::Env env = info.Env();
     
-    if (info.Length() < 3) {
-        Napi::TypeError::New(env, "Expected 3 arguments: voterInput, salt, timestamp")
+    if (info.Length() < 2 || !info[0].IsObject()) {
+        Napi::TypeError::New(env, "Expected proof and root").ThrowAsJavaScriptException();
+        return env.Undefined();
+    }
+    
+    Napi::Object object = info[0].As<Napi::Object>();
+    SparseMerkleProof proof;
+    Digest root;
+    if (!digestFromJs(object.Get("nullifier"), proof.key) ||
+        !digestFromJs(object.Get("bitmap"), proof.bitmap) ||
+        !isDigestList(object.Get("siblings"))) {
+        Napi::TypeError::New(env, "Expected { nullifier, spent, bitmap, siblings }")
             .ThrowAsJavaScriptException();
-        return Napi::Object::New(env);
+        return env.Undefined();
+    }
+    if (!readLeaves(env, object.Get("siblings"), proof.siblings)) {
+        return env.Undefined();
+    }
+    proof.included = object.Get("spent").ToBoolean().Value();
+    if (!digestFromJs(info[1], root)) {
+        return Napi::Boolean::New(env, false);
+    }
+    
+    return Napi::Boolean::New(env, NullifierTree::verifyProof(proof, root));
+}
+
+// Start a fresh tally over candidateCount candidates; returns its sequence.
+// Spent nullifiers are kept, so ballots already counted stay rejected
+Napi::Value ConfigureTally(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+    
+    if (info.Length() < 1 || !info[0].IsNumber() ||
+        info[0].As<Napi::Number>().Int64Value() < 0 ||
+        info[0].As<Napi::Number>().Int64Value() > static_cast<int64_t>(VoteTally::MAX_CANDIDATES)) {
+        Napi::TypeError::New(env, "Expected candidateCount between 0 and " +
+                             std::to_string(VoteTally::MAX_CANDIDATES)).ThrowAsJavaScriptException();
+        return env.Undefined();
+    }
+    
+    std::unique_lock<std::shared_mutex> lock(tallyMutex);
+    voteTally.reset(info[0].As<Napi::Number>().Int64Value());
+    return Napi::Number::New(env, voteTally.sequence());
+}
+
+// castVotes result; status holds one VoteTally::VoteStatus byte per record
+struct VoteBatch {
+    VoteTally::IngestResult result;
+    std::shared_ptr<std::vector<uint8_t>> status;
+};
+
+// Votes as VoteTally records packed back to back in a Buffer or
+// Uint8Array, or as an array of { nullifier, candidate }
+static bool readVoteRecords(const Napi::CallbackInfo& info, std::vector<uint8_t>& records) {
+    Napi::Env env = info.Env();
+    
+    if (info.Length() >= 1 && isBinary(info[0])) {
+        Napi::Uint8Array bytes = info[0].As<Napi::Uint8Array>();
+        if (bytes.ByteLength() % VoteTally::RECORD_BYTES != 0) {
+            Napi::TypeError::New(env, "Vote buffer length must be a multiple of " +
+                                 std::to_string(VoteTally::RECORD_BYTES)).ThrowAsJavaScriptException();
+            return false;
+        }
+        records.assign(bytes.Data(), bytes.Data() + bytes.ByteLength());
+        return true;
+    }
+    
+    if (info.Length() < 1 || !info[0].IsArray()) {
+        Napi::TypeError::New(env, "Expected votes as a Buffer or [{ nullifier, candidate }]")
+            .ThrowAsJavaScriptException();
+        return false;
+    }
+    
+    Napi::Array votes = info[0].As<Napi::Array>();
+    records.resize(votes.Length() * VoteTally::RECORD_BYTES);
+    for (uint32_t i = 0; i < votes.Length(); i++) {
+        Napi::Value vote = votes.Get(i);
+        Digest nullifier;
+        if (!vote.IsObject() || !digestFromJs(vote.As<Napi::Object>().Get("nullifier"), nullifier) ||
+            !vote.As<Napi::Object>().Get("candidate").IsNumber()) {
+            Napi::TypeError::New(env, "Vote " + std::to_string(i) +
+                                 " needs a 32-byte nullifier and a numeric candidate")
+                .ThrowAsJavaScriptException();
+            return false;
+        }
+        // Negative or oversized indices wrap past MAX_CANDIDATES and are
+        // reported as unknown candidates
+        uint32_t candidate = vote.As<Napi::Object>().Get("candidate").As<Napi::Number>().Uint32Value();
+        uint8_t* record = records.data() + i * VoteTally::RECORD_BYTES;
+        std::copy(nullifier.begin(), nullifier.end(), record);
+        for (size_t b = 0; b < 4; b++) {
+            record[sizeof(Digest) + b] = static_cast<uint8_t>(candidate >> (8 * b));
+        }
+    }
+    return true;
+}
+
+static VoteBatch castVoteBatch(const std::vector<uint8_t>& records) {
+    size_t count = records.size() / VoteTally::RECORD_BYTES;
+    VoteBatch batch;
+    batch.status = std::make_shared<std::vector<uint8_t>>(count);
+    
+    std::shared_lock<std::shared_mutex> lock(nullifierMutex);
+    std::shared_lock<std::shared_mutex> tallyLock(tallyMutex);
+    batch.result = voteTally.ingest(records.data(), count, nullifierSet, batch.status->data());
+    
+    std::lock_guard<std::mutex> pendingLock(pendingMutex);
+    for (size_t i = 0; i < count; i++) {
+        if ((*batch.status)[i] == VoteTally::ACCEPTED) {
+            Digest nullifier;
+            std::copy(records.begin() + i * VoteTally::RECORD_BYTES,
+                      records.begin() + i * VoteTally::RECORD_BYTES + sizeof(Digest), nullifier.begin());
+            pendingNullifiers.push_back(nullifier);
+        }
+    }
+    return batch;
+}
+
+static Napi::Value voteBatchToObject(Napi::Env env, const VoteBatch& batch) {
+    Napi::Object result = Napi::Object::New(env);
+    result.Set("accepted", Napi::Number::New(env, batch.result.accepted));
+    result.Set("duplicates", Napi::Number::New(env, batch.result.duplicates));
+    result.Set("invalid", Napi::Number::New(env, batch.result.invalid));
+    result.Set("sequence", Napi::Number::New(env, batch.result.sequence));
+    result.Set("status", externalBuffer(env, batch.status));
+    return result;
+}
+
+// Count a batch of votes, spending each nullifier:
+// castVotes(votes) -> { accepted, duplicates, invalid, sequence, status }.
+// status[i] is 0 when vote i counted, 1 when its nullifier was already
+// spent and 2 when its candidate is unknown (the nullifier stays unspent)
+Napi::Value CastVotes(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+    
+    std::vector<uint8_t> records;
+    if (!readVoteRecords(info, records)) {
+        return env.Undefined();
+    }
+    
+    try {
+        return voteBatchToObject(env, castVoteBatch(records));
+    
+    } catch (const std::exception& e) {
+        Napi::Error::New(env, std::string("Tally error: ") + e.what())
+            .ThrowAsJavaScriptException();
+        return env.Undefined();
+    }
+}
+
+// Promise-returning CastVotes; records are copied on the JS thread
+Napi::Value CastVotesAsync(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+    
+    auto records = std::make_shared<std::vector<uint8_t>>();
+    if (!readVoteRecords(info, *records)) {
+        return env.Undefined();
+    }
+    
+    return PromiseWorker<VoteBatch>::Start(env,
+        [records] { return castVoteBatch(*records); },
+        voteBatchToObject, "Tally error: ");
+}
+
+static Napi::Object tallyTotalsToObject(Napi::Env env, const VoteTally::Totals& totals, bool delta) {
+    Napi::Object result = Napi::Object::New(env);
+    result.Set("sequence", Napi::Number::New(env, totals.sequence));
+    result.Set("totalVotes", Napi::Number::New(env, totals.totalVotes));
+    if (delta) {
+        Napi::Array candidates = Napi::Array::New(env, totals.candidates.size());
+        for (size_t i = 0; i < totals.candidates.size(); i++) {
+            candidates.Set(i, Napi::Number::New(env, totals.candidates[i]));
+        }
+        result.Set("candidates", candidates);
+    }
+    Napi::Array counts = Napi::Array::New(env, totals.counts.size());
+    for (size_t i = 0; i < totals.counts.size(); i++) {
+        counts.Set(i, Napi::Number::New(env, totals.counts[i]));
+    }
+    result.Set("counts", counts);
+    return result;
+}
+
+// Every candidate's total: { sequence, totalVotes, counts }, counts[i]
+// being candidate i's
+Napi::Value GetTallySnapshot(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+    
+    std::shared_lock<std::shared_mutex> lock(tallyMutex);
+    return tallyTotalsToObject(env, voteTally.snapshot(), false);
+}
+
+// Totals changed after a sequence from an earlier snapshot or delta:
+// { sequence, totalVotes, candidates, counts }, counts[i] being the new
+// total of candidates[i]. Pass the returned sequence to the next call; a
+// reconfigured tally returns every candidate
+Napi::Value GetTallyDelta(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+    
+    if (info.Length() < 1 || !info[0].IsNumber() || info[0].As<Napi::Number>().Int64Value() < 0) {
+        Napi::TypeError::New(env, "Expected sinceSequence").ThrowAsJavaScriptException();
+        return env.Undefined();
+    }
+    
+    std::shared_lock<std::shared_mutex> lock(tallyMutex);
+    return tallyTotalsToObject(env, voteTally.delta(info[0].As<Napi::Number>().Int64Value()), true);
+}
+
+struct ShardedVoterRecord {
+    std::string voterHash;
+    std::string nullifierHash;
+    size_t shard;
+};
+
+// Promise-returning registration into the sharded registry; concurrent
+// calls only contend when their voter hashes land in the same shard
+Napi::Value ProcessVoterIDShardedAsync(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+    
+    if (!checkVoterArgs(info)) {
+        return env.Undefined();
     }
     
     std::string voterInput = info[0].As<Napi::String>().Utf8Value();
     std::string salt = info[1].As<Napi::String>().Utf8Value();
     uint64_t timestamp = info[2].As<Napi::Number>().Int64Value();
     
-    // Initialize trie if not already done
-    initializeTrie();
+    return PromiseWorker<ShardedVoterRecord>::Start(env,
+        [voterInput, salt, timestamp] {
+            ShardedVoterRecord record;
+            std::shared_ptr<const FusionContext> fusion = fusionContext(salt, timestamp);
+            Digest voterHash = fusion->voterHashFusion(voterInput);
+            record.voterHash = HashFusion::toHex(voterHash);
+            record.nullifierHash = HashFusion::toHex(fusion->nullifier(voterHash));
+            record.shard = shardedRegistry.shardOf(record.voterHash);
+            shardedRegistry.insert(record.voterHash, voterInput);
+            return record;
+        },
+        [](Napi::Env env, const ShardedVoterRecord& record) -> Napi::Value {
+            Napi::Object result = Napi::Object::New(env);
+            result.Set("voterHash", Napi::String::New(env, record.voterHash));
+            result.Set("nullifierHash", Napi::String::New(env, record.nullifierHash));
+            result.Set("shard", Napi::Number::New(env, record.shard));
+            return result;
+        },
+        "Sharded registration error: ");
+}
+
+// Bulk-load into the sharded registry; shards are filled in parallel
+Napi::Object BulkLoadVotersSharded(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+    
+    if (info.Length() < 3 || !info[0].IsArray()) {
+        Napi::TypeError::New(env, "Expected 3 arguments: voterInputs[], salt, timestamp")
+            .ThrowAsJavaScriptException();
+        return Napi::Object::New(env);
+    }
+    
+    Napi::Array inputs = info[0].As<Napi::Array>();
+    std::string salt = info[1].As<Napi::String>().Utf8Value();
+    uint64_t timestamp = info[2].As<Napi::Number>().Int64Value();
     
     try {
-        // Generate voter hash using trie hash fusion
-        std::string voterHash = HashFusion::voterHashFusion(voterInput, salt, timestamp);
-        
-        // Generate nullifier hash for double-vote prevention
-        std::string nullifierHash = HashFusion::generateNullifier(voterHash, salt);
-        
-        // Insert into trie
-        globalTrie->insert(voterHash, voterInput);
-        
-        // Get current trie root
-        std::string trieRoot = globalTrie->getRootHash();
+        std::vector<std::pair<std::string, std::string>> entries(inputs.Length());
+        for (uint32_t i = 0; i < inputs.Length(); i++) {
+            entries[i].second = inputs.Get(i).As<Napi::String>().Utf8Value();
+        }
         
-        // Generate Merkle proof
-        std::vector<std::string> merkleProof = globalTrie->getMerkleProof(voterHash);
+        std::shared_ptr<const FusionContext> fusion = fusionContext(salt, timestamp);
+        ThreadPool::shared().parallelFor(entries.size(), [&](size_t i) {
+            entries[i].first = HashFusion::toHex(fusion->voterHashFusion(entries[i].second));
+        });
+        shardedRegistry.insertBatch(entries);
         
-        // Create result object
         Napi::Object result = Napi::Object::New(env);
-        result.Set("voterHash", Napi::String::New(env, voterHash));
-        result.Set("nullifierHash", Napi::String::New(env, nullifierHash));
-        result.Set("trieRoot", Napi::String::New(env, trieRoot));
-        
-        // Convert merkle proof to JavaScript array
-        Napi::Array proofArray = Napi::Array::New(env, merkleProof.size());
-        for (size_t i = 0; i < merkleProof.size(); i++) {
-            proofArray.Set(i, Napi::String::New(env, merkleProof[i]));
+        Napi::Array hashArray = Napi::Array::New(env, entries.size());
+        for (size_t i = 0; i < entries.size(); i++) {
+            hashArray.Set(i, Napi::String::New(env, entries[i].first));
         }
-        result.Set("merkleProof", proofArray);
-        
-        // Add trie data for debugging
-        Napi::Object trieData = Napi::Object::New(env);
-        trieData.Set("size", Napi::Number::New(env, globalTrie->getSize()));
-        trieData.Set("rootHash", Napi::String::New(env, trieRoot));
-        result.Set("trieData", trieData);
-        
+        result.Set("voterHashes", hashArray);
+        result.Set("rootHash", Napi::String::New(env, shardedRegistry.getRootHash()));
         return result;
-        
+    
     } catch (const std::exception& e) {
-        Napi::Error::New(env, std::string("Trie hash fusion error: ") + e.what())
+        Napi::Error::New(env, std::string("Sharded bulk load error: ") + e.what())
             .ThrowAsJavaScriptException();
         return Napi::Object::New(env);
     }
 }
 
-// Verify voter in trie
-Napi::Boolean VerifyVoter(const Napi::CallbackInfo& info) {
+// Shard trie proof plus the shard root's path to the registry root
+Napi::Value GetShardedVoterProof(const Napi::CallbackInfo& info) {
     Napi::Env env = info.Env();
     
-    if (info.Length() < 1) {
-        Napi::TypeError::New(env, "Expected voterHash argument")
-            .ThrowAsJavaScriptException();
-        return Napi::Boolean::New(env, false);
+    if (!checkVoterHashArg(info)) {
+        return env.Null();
     }
     
-    std::string voterHash = info[0].As<Napi::String>().Utf8Value();
+    std::string voterHash = voterHashFromJs(info[0]);
     
-    if (!globalTrie) {
+    ShardedTrieProof proof;
+    Digest root;
+    if (!shardedRegistry.getProof(voterHash, proof, root)) {
+        return env.Null();
+    }
+    
+    Napi::Object result = Napi::Object::New(env);
+    result.Set("shard", Napi::Number::New(env, proof.shard));
+    result.Set("shardRoot", Napi::String::New(env, HashFusion::toHex(proof.shardRoot)));
+    result.Set("shardProof", trieProofToObject(env, proof.shardProof));
+    result.Set("shardPath", digestsToArray(env, proof.shardPath));
+    result.Set("root", Napi::String::New(env, HashFusion::toHex(root)));
+    return result;
+}
+
+Napi::Value VerifyShardedVoterProof(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+    
+    if (info.Length() < 2 || !info[0].IsObject()) {
+        Napi::TypeError::New(env, "Expected proof and root").ThrowAsJavaScriptException();
+        return env.Undefined();
+    }
+    
+    Napi::Object object = info[0].As<Napi::Object>();
+    ShardedTrieProof proof;
+    Digest root;
+    if (!trieProofFromObject(env, object.Get("shardProof"), proof.shardProof)) {
+        return env.Undefined();
+    }
+    if (!isDigestList(object.Get("shardPath")) ||
+        !readLeaves(env, object.Get("shardPath"), proof.shardPath)) {
+        return env.Undefined();
+    }
+    proof.shard = object.Get("shard").ToNumber().Uint32Value();
+    if (!digestFromJs(object.Get("shardRoot"), proof.shardRoot) ||
+        !digestFromJs(info[1], root)) {
         return Napi::Boolean::New(env, false);
     }
     
-    bool exists = globalTrie->search(voterHash);
-    return Napi::Boolean::New(env, exists);
+    return Napi::Boolean::New(env, shardedRegistry.verifyProof(proof, root));
 }
 
-// Get trie statistics
-Napi::Object GetTrieStats(const Napi::CallbackInfo& info) {
+Napi::Object GetShardedRegistryStats(const Napi::CallbackInfo& info) {
     Napi::Env env = info.Env();
     
     Napi::Object stats = Napi::Object::New(env);
+    stats.Set("shards", Napi::Number::New(env, shardedRegistry.shardCount()));
+    stats.Set("size", Napi::Number::New(env, shardedRegistry.getSize()));
+    stats.Set("rootHash", Napi::String::New(env, shardedRegistry.getRootHash()));
+    return stats;
+}
+
+// Native counters and latency histograms: `prometheus` is the text
+// exposition format for a /metrics endpoint, the rest the same data as
+// plain objects. All zero when built with TRIE_METRICS=0.
+Napi::Object GetMetrics(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
     
-    if (!globalTrie) {
-        stats.Set("initialized", Napi::Boolean::New(env, false));
-        stats.Set("size", Napi::Number::New(env, 0));
-        stats.Set("rootHash", Napi::String::New(env, ""));
-        return stats;
+    Napi::Object result = Napi::Object::New(env);
+    result.Set("enabled", Napi::Boolean::New(env, Metrics::enabled()));
+    result.Set("prometheus", Napi::String::New(env, Metrics::prometheusText()));
+    
+    Napi::Object counters = Napi::Object::New(env);
+    for (size_t i = 0; i < Metrics::COUNTER_COUNT; i++) {
+        Metrics::Counter counter = static_cast<Metrics::Counter>(i);
+        counters.Set(Metrics::counterName(counter),
+                     Napi::Number::New(env, static_cast<double>(Metrics::counterValue(counter))));
+    }
+    result.Set("counters", counters);
+    
+    Napi::Object operations = Napi::Object::New(env);
+    for (size_t i = 0; i < Metrics::OPERATION_COUNT; i++) {
+        Metrics::Operation operation = static_cast<Metrics::Operation>(i);
+        Metrics::Histogram histogram = Metrics::histogram(operation);
+        
+        Napi::Object entry = Napi::Object::New(env);
+        entry.Set("count", Napi::Number::New(env, static_cast<double>(histogram.count)));
+        entry.Set("sumSeconds", Napi::Number::New(env, histogram.sumNanoseconds * 1e-9));
+        
+        // Cumulative, as Prometheus buckets are
+        Napi::Array buckets = Napi::Array::New(env, Metrics::BUCKETS);
+        uint64_t cumulative = 0;
+        for (size_t b = 0; b < Metrics::BUCKETS; b++) {
+            cumulative += histogram.buckets[b];
+            Napi::Object bucket = Napi::Object::New(env);
+            bucket.Set("le", Napi::Number::New(env, Metrics::bucketBound(b)));
+            bucket.Set("count", Napi::Number::New(env, static_cast<double>(cumulative)));
+            buckets.Set(b, bucket);
+        }
+        entry.Set("buckets", buckets);
+        operations.Set(Metrics::operationName(operation), entry);
     }
+    result.Set("operations", operations);
     
-    stats.Set("initialized", Napi::Boolean::New(env, true));
-    stats.Set("size", Napi::Number::New(env, globalTrie->getSize()));
-    stats.Set("rootHash", Napi::String::New(env, globalTrie->getRootHash()));
+    return result;
+}
+
+// Freeze the current trie as a numbered version, e.g. when its root is
+// published on chain; proofs against it stay available as voters arrive
+Napi::Value CommitTrieVersion(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
     
-    // Get all keys for debugging
-    std::vector<std::string> keys = globalTrie->getAllKeys();
-    Napi::Array keysArray = Napi::Array::New(env, keys.size());
-    for (size_t i = 0; i < keys.size(); i++) {
-        keysArray.Set(i, Napi::String::New(env, keys[i].substr(0, 16) + "..."));
+    std::unique_lock<std::shared_mutex> lock(trieMutex);
+    initializeTrie();
+    
+    Napi::Object result = Napi::Object::New(env);
+    result.Set("version", Napi::Number::New(env, static_cast<double>(globalTrie->commit())));
+    result.Set("rootHash", Napi::String::New(env, globalTrie->getRootHash()));
+    result.Set("size", Napi::Number::New(env, globalTrie->getSize()));
+    return result;
+}
+
+// Retained versions in commit order as { version, rootHash }
+Napi::Value GetTrieVersions(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+    
+    std::shared_lock<std::shared_mutex> lock(trieMutex);
+    std::vector<MerkleTrie::Version> versions;
+    if (globalTrie) {
+        versions = globalTrie->getVersions();
     }
-    stats.Set("voterHashes", keysArray);
     
-    return stats;
+    Napi::Array result = Napi::Array::New(env, versions.size());
+    for (size_t i = 0; i < versions.size(); i++) {
+        TrieView view;
+        globalTrie->view(versions[i], view);
+        
+        Napi::Object entry = Napi::Object::New(env);
+        entry.Set("version", Napi::Number::New(env, static_cast<double>(versions[i])));
+        entry.Set("rootHash", Napi::String::New(env, HashFusion::toHex(view.getRootDigest())));
+        result.Set(i, entry);
+    }
+    return result;
 }
 
-// Generate hash using different algorithms
-Napi::String GenerateHash(const Napi::CallbackInfo& info) {
+// Drop a version; its nodes are reclaimed by the next collectTrieGarbage
+Napi::Boolean ReleaseTrieVersion(const Napi::CallbackInfo& info) {
     Napi::Env env = info.Env();
     
-    if (info.Length() < 2) {
-        Napi::TypeError::New(env, "Expected input and algorithm arguments")
+    if (info.Length() < 1 || !info[0].IsNumber()) {
+        Napi::TypeError::New(env, "Expected version number").ThrowAsJavaScriptException();
+        return Napi::Boolean::New(env, false);
+    }
+    
+    int64_t version = info[0].As<Napi::Number>().Int64Value();
+    
+    std::unique_lock<std::shared_mutex> lock(trieMutex);
+    bool released = globalTrie && version > 0 &&
+                    globalTrie->releaseVersion(static_cast<uint64_t>(version));
+    return Napi::Boolean::New(env, released);
+}
+
+// Compact the trie arena to the current trie and retained versions;
+// returns the number of nodes freed
+Napi::Number CollectTrieGarbage(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+    
+    std::unique_lock<std::shared_mutex> lock(trieMutex);
+    size_t freed = globalTrie ? globalTrie->collectGarbage() : 0;
+    return Napi::Number::New(env, freed);
+}
+
+// Write the registry (trie plus voter list order) to path atomically
+Napi::Value SaveTrieSnapshot(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+    
+    if (info.Length() < 1) {
+        Napi::TypeError::New(env, "Expected snapshot path").ThrowAsJavaScriptException();
+        return env.Undefined();
+    }
+    
+    std::string path = info[0].As<Napi::String>().Utf8Value();
+    
+    try {
+        ensureVoterTree();
+        std::shared_lock<std::shared_mutex> lock(trieMutex);
+        TrieView view;
+        MerkleTrie empty;
+        if (!registryView(view)) {
+            view = empty.view();
+        }
+        
+        std::vector<Digest> leaves;
+        if (voterTree) {
+            leaves.reserve(voterTree->size());
+            for (size_t i = 0; i < voterTree->size(); i++) {
+                leaves.push_back(voterTree->getLeaf(i));
+            }
+        }
+        TrieSnapshot::write(path, view, Sha256HexPolicy::name(), leaves);
+        
+        // The snapshot now holds every logged insert (writers are held off
+        // by the shared lock), so the log restarts on top of it
+        if (globalWal) {
+            globalWal->reset(view.getRootDigest());
+        }
+        
+        Napi::Object result = Napi::Object::New(env);
+        result.Set("path", Napi::String::New(env, path));
+        result.Set("size", Napi::Number::New(env, view.getSize()));
+        result.Set("rootHash", Napi::String::New(env, HashFusion::toHex(view.getRootDigest())));
+        return result;
+    
+    } catch (const std::exception& e) {
+        Napi::Error::New(env, std::string("Trie snapshot error: ") + e.what())
             .ThrowAsJavaScriptException();
-        return Napi::String::New(env, "");
+        return env.Undefined();
+    }
+}
+
+// Replace the registry with a mapped snapshot; lookups and proofs are
+// served from the mapping at once, the first write copies it
+Napi::Value LoadTrieSnapshot(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+    
+    if (info.Length() < 1) {
+        Napi::TypeError::New(env, "Expected snapshot path").ThrowAsJavaScriptException();
+        return env.Undefined();
     }
     
-    std::string input = info[0].As<Napi::String>().Utf8Value();
-    std::string algorithm = info[1].As<Napi::String>().Utf8Value();
+    std::string path = info[0].As<Napi::String>().Utf8Value();
     
-    std::string result;
+    try {
+        auto snapshot = std::make_unique<TrieSnapshot>(path);
+        if (snapshot->hashPolicy() != Sha256HexPolicy::name()) {
+            throw std::runtime_error("snapshot uses hash policy " + snapshot->hashPolicy());
+        }
+        
+        Napi::Object result = Napi::Object::New(env);
+        result.Set("size", Napi::Number::New(env, snapshot->view().getSize()));
+        result.Set("rootHash", Napi::String::New(env,
+            HashFusion::toHex(snapshot->view().getRootDigest())));
+        
+        std::unique_lock<std::shared_mutex> lock(trieMutex);
+        globalTrie.reset();
+        voterTree.reset();
+        globalSnapshot = std::move(snapshot);
+        // The log described the registry just replaced
+        globalWal.reset();
+        return result;
     
-    if (algorithm == "sha256") {
-        result = HashFusion::sha256(input);
-    } else if (algorithm == "keccak256") {
-        result = HashFusion::keccak256(input);
-    } else if (algorithm == "blake2b") {
-        result = HashFusion::blake2b(input);
+    } catch (const std::exception& e) {
+        Napi::Error::New(env, std::string("Trie snapshot error: ") + e.what())
+            .ThrowAsJavaScriptException();
+        return env.Undefined();
+    }
+}
+
+// Crash recovery: replay the log at path on top of the current registry
+// (normally a just-loaded snapshot), checking every record's root, then
+// keep logging inserts to it
+Napi::Value OpenWriteAheadLog(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+    
+    if (info.Length() < 1) {
+        Napi::TypeError::New(env, "Expected log path").ThrowAsJavaScriptException();
+        return env.Undefined();
+    }
+    
+    std::string path = info[0].As<Napi::String>().Utf8Value();
+    
+    try {
+        std::unique_lock<std::shared_mutex> lock(trieMutex);
+        
+        TrieView view;
+        MerkleTrie empty;
+        if (!registryView(view)) {
+            view = empty.view();
+        }
+        
+        // Records go under a savepoint on the live trie, or into a trie
+        // restored from the snapshot that is installed only once every
+        // record checks out, and the voter leaves wait for the same; a
+        // failed recovery leaves the registry and its old log as they were
+        std::unique_ptr<MerkleTrie> restored;
+        MerkleTrie* trie = globalTrie.get();
+        std::vector<std::string> voterHashes;
+        size_t replayed = 0;
+        auto replay = [&](const WriteAheadLog::Entries& entries, const Digest& root) {
+            if (!trie) {
+                restored = globalSnapshot ? std::make_unique<MerkleTrie>(globalSnapshot->view())
+                                          : std::make_unique<MerkleTrie>();
+                trie = restored.get();
+            }
+            if (entries.size() == 1) {
+                trie->insert(entries[0].first, entries[0].second);
+            } else {
+                trie->insertBatch(entries);
+            }
+            for (const auto& entry : entries) {
+                voterHashes.push_back(entry.first);
+            }
+            
+            const Digest& recovered = trie->view().getRootDigest();
+            if (recovered != root) {
+                throw std::runtime_error("record " + std::to_string(replayed) + " recovers root " +
+                                         HashFusion::toHex(recovered) + ", log has " +
+                                         HashFusion::toHex(root));
+            }
+            replayed++;
+        };
+        
+        std::shared_ptr<WriteAheadLog> wal;
+        if (globalTrie) {
+            globalTrie->savepoint();
+        }
+        try {
+            wal = std::make_shared<WriteAheadLog>(path, view.getRootDigest(), replay);
+        } catch (...) {
+            if (globalTrie) {
+                globalTrie->rollback();
+            }
+            throw;
+        }
+        if (globalTrie) {
+            globalTrie->release();
+        }
+        
+        // Installed the way initializeTrie() would have
+        if (restored) {
+            if (globalSnapshot) {
+                restoreVoterTree();
+                globalSnapshot.reset();
+            } else {
+                voterTree = std::make_unique<MerkleTree<Sha256HexPolicy>>();
+            }
+            globalTrie = std::move(restored);
+        }
+        if (!voterHashes.empty()) {
+            appendVoterLeaves(voterHashes);
+        }
+        globalWal = wal;
+        
+        if (!registryView(view)) {
+            view = empty.view();
+        }
+        Napi::Object result = Napi::Object::New(env);
+        result.Set("path", Napi::String::New(env, path));
+        result.Set("replayed", Napi::Number::New(env, replayed));
+        result.Set("size", Napi::Number::New(env, view.getSize()));
+        result.Set("rootHash", Napi::String::New(env, HashFusion::toHex(view.getRootDigest())));
+        return result;
+    
+    } catch (const std::exception& e) {
+        Napi::Error::New(env, std::string("Trie recovery error: ") + e.what())
+            .ThrowAsJavaScriptException();
+        return env.Undefined();
+    }
+}
+
+// Result of importVoterRoll
+struct RollImport {
+    size_t imported;
+    size_t skipped;
+    size_t bytes;
+    std::string trieRoot;
+    size_t size;
+};
+
+// Roll layout from importVoterRoll's options: { format: 'csv' (default)
+// with column, delimiter, header } or { format: 'fixed' with recordBytes,
+// fieldOffset, fieldBytes }; batchSize tunes voters per trie insert
+static bool readRollOptions(const Napi::CallbackInfo& info, RollFormat& format, size_t& batchRecords) {
+    Napi::Env env = info.Env();
+    format = RollFormat::csv();
+    batchRecords = RollImporter::DEFAULT_BATCH_RECORDS;
+    if (info.Length() < 4 || info[3].IsUndefined()) {
+        return true;
+    }
+    if (!info[3].IsObject()) {
+        Napi::TypeError::New(env, "Expected options object").ThrowAsJavaScriptException();
+        return false;
+    }
+    
+    Napi::Object options = info[3].As<Napi::Object>();
+    auto count = [&](const char* name, size_t fallback) -> size_t {
+        if (!options.Has(name) || !options.Get(name).IsNumber()) {
+            return fallback;
+        }
+        int64_t value = options.Get(name).As<Napi::Number>().Int64Value();
+        return value > 0 ? static_cast<size_t>(value) : 0;
+    };
+    
+    std::string kind = options.Has("format") && options.Get("format").IsString()
+        ? options.Get("format").As<Napi::String>().Utf8Value() : "csv";
+    if (kind == "csv") {
+        std::string delimiter = options.Has("delimiter") && options.Get("delimiter").IsString()
+            ? options.Get("delimiter").As<Napi::String>().Utf8Value() : ",";
+        if (delimiter.size() != 1) {
+            Napi::TypeError::New(env, "delimiter must be one character").ThrowAsJavaScriptException();
+            return false;
+        }
+        bool header = options.Has("header") && options.Get("header").ToBoolean().Value();
+        format = RollFormat::csv(count("column", 0), delimiter[0], header);
+    } else if (kind == "fixed") {
+        format = RollFormat::fixedWidth(count("recordBytes", 0), count("fieldOffset", 0),
+                                        count("fieldBytes", 0));
     } else {
-        result = HashFusion::sha256(input); // Default to SHA256
+        Napi::TypeError::New(env, "format must be 'csv' or 'fixed'").ThrowAsJavaScriptException();
+        return false;
+    }
+    batchRecords = count("batchSize", batchRecords);
+    return true;
+}
+
+static RollImport importRoll(const std::string& path, const RollFormat& format, size_t batchRecords,
+                             const std::string& salt, uint64_t timestamp) {
+    RollImport result = {0, 0, 0, "", 0};
+    RollFile file(path);
+    RollImporter importer(file, format, batchRecords);
+    std::shared_ptr<const FusionContext> fusion = fusionContext(salt, timestamp);
+    
+    // Each batch is one locked insert and one log record, so readers get
+    // in between batches
+    importer.run(*fusion, [&](RollImporter::Batch& batch) {
+        result.size = insertVoterBatch(batch.entries, batch.leaves, result.trieRoot);
+    }, importProgress);
+    
+    result.imported = importProgress.imported.load(std::memory_order_relaxed);
+    result.skipped = importProgress.skipped.load(std::memory_order_relaxed);
+    result.bytes = file.size();
+    if (result.imported == 0) {
+        std::shared_lock<std::shared_mutex> lock(trieMutex);
+        TrieView view;
+        if (registryView(view)) {
+            result.trieRoot = HashFusion::toHex(view.getRootDigest());
+            result.size = view.getSize();
+        }
+    }
+    return result;
+}
+
+static Napi::Value rollImportToObject(Napi::Env env, const RollImport& result) {
+    Napi::Object object = Napi::Object::New(env);
+    object.Set("imported", Napi::Number::New(env, result.imported));
+    object.Set("skipped", Napi::Number::New(env, result.skipped));
+    object.Set("bytes", Napi::Number::New(env, result.bytes));
+    object.Set("trieRoot", Napi::String::New(env, result.trieRoot));
+    object.Set("size", Napi::Number::New(env, result.size));
+    return object;
+}
+
+// Register every voter in a roll file without a JS loop:
+// importVoterRoll(path, salt, timestamp, options?) -> Promise of
+// { imported, skipped, bytes, trieRoot, size }. The file is mapped, not
+// read into memory; poll getImportProgress while it runs
+Napi::Value ImportVoterRoll(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+    
+    if (info.Length() < 3 || !info[0].IsString() || !info[1].IsString() || !info[2].IsNumber()) {
+        Napi::TypeError::New(env, "Expected path, salt, timestamp and optional options")
+            .ThrowAsJavaScriptException();
+        return env.Undefined();
+    }
+    
+    RollFormat format;
+    size_t batchRecords;
+    if (!readRollOptions(info, format, batchRecords)) {
+        return env.Undefined();
+    }
+    std::string path = info[0].As<Napi::String>().Utf8Value();
+    std::string salt = info[1].As<Napi::String>().Utf8Value();
+    uint64_t timestamp = info[2].As<Napi::Number>().Int64Value();
+    
+    bool idle = false;
+    if (!importActive.compare_exchange_strong(idle, true)) {
+        Napi::Error::New(env, "A voter roll import is already running").ThrowAsJavaScriptException();
+        return env.Undefined();
     }
     
-    return Napi::String::New(env, result);
+    return PromiseWorker<RollImport>::Start(env,
+        [path, format, batchRecords, salt, timestamp] {
+            struct Release {
+                ~Release() { importActive.store(false); }
+            } release;
+            return importRoll(path, format, batchRecords, salt, timestamp);
+        },
+        rollImportToObject, "Roll import error: ");
+}
+
+// { active, bytesRead, totalBytes, imported, skipped } of the running
+// import, or of the last one once active is false
+Napi::Object GetImportProgress(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+    
+    Napi::Object progress = Napi::Object::New(env);
+    progress.Set("active", Napi::Boolean::New(env, importActive.load()));
+    progress.Set("bytesRead", Napi::Number::New(env, importProgress.bytesRead.load(std::memory_order_relaxed)));
+    progress.Set("totalBytes", Napi::Number::New(env, importProgress.totalBytes.load(std::memory_order_relaxed)));
+    progress.Set("imported", Napi::Number::New(env, importProgress.imported.load(std::memory_order_relaxed)));
+    progress.Set("skipped", Napi::Number::New(env, importProgress.skipped.load(std::memory_order_relaxed)));
+    return progress;
 }
 
 // Reset trie (for testing)
 Napi::Boolean ResetTrie(const Napi::CallbackInfo& info) {
     Napi::Env env = info.Env();
     
+    std::unique_lock<std::shared_mutex> lock(trieMutex);
+    globalSnapshot.reset();
+    globalWal.reset();
     globalTrie = std::make_unique<MerkleTrie>();
+    voterTree = std::make_unique<MerkleTree<Sha256HexPolicy>>();
+    
+    std::unique_lock<std::shared_mutex> nullifierLock(nullifierMutex);
+    nullifierSet.clear();
+    nullifierTree.clear();
+    pendingNullifiers.clear();
+    shardedRegistry.clear();
+    
+    std::unique_lock<std::shared_mutex> tallyLock(tallyMutex);
+    voteTally.reset(voteTally.candidateCount());
     return Napi::Boolean::New(env, true);
 }
 
 // Module initialization
 Napi::Object Init(Napi::Env env, Napi::Object exports) {
     exports.Set("processVoterID", Napi::Function::New(env, ProcessVoterID));
+    exports.Set("processVoterIDAsync", Napi::Function::New(env, ProcessVoterIDAsync));
+    exports.Set("processVoterIDs", Napi::Function::New(env, ProcessVoterIDs));
+    exports.Set("processVoterIDsAsync", Napi::Function::New(env, ProcessVoterIDsAsync));
+    exports.Set("importVoterRoll", Napi::Function::New(env, ImportVoterRoll));
+    exports.Set("getImportProgress", Napi::Function::New(env, GetImportProgress));
+    exports.Set("bulkLoadVoters", Napi::Function::New(env, BulkLoadVoters));
     exports.Set("verifyVoter", Napi::Function::New(env, VerifyVoter));
+    exports.Set("verifyVoterAsync", Napi::Function::New(env, VerifyVoterAsync));
     exports.Set("getTrieStats", Napi::Function::New(env, GetTrieStats));
+    exports.Set("getTrieStatsAsync", Napi::Function::New(env, GetTrieStatsAsync));
+    exports.Set("listVoterKeys", Napi::Function::New(env, ListVoterKeys));
     exports.Set("generateHash", Napi::Function::New(env, GenerateHash));
+    exports.Set("computeMerkleRoot", Napi::Function::New(env, ComputeMerkleRoot));
+    exports.Set("computeMerkleProof", Napi::Function::New(env, ComputeMerkleProof));
+    exports.Set("getVoterMerkleProof", Napi::Function::New(env, GetVoterMerkleProof));
+    exports.Set("getVoterMultiProof", Napi::Function::New(env, GetVoterMultiProof));
+    exports.Set("computeMultiProof", Napi::Function::New(env, ComputeMultiProof));
+    exports.Set("verifyMultiProof", Napi::Function::New(env, VerifyMultiProof));
+    exports.Set("getTrieProof", Napi::Function::New(env, GetTrieProof));
+    exports.Set("verifyTrieProof", Napi::Function::New(env, VerifyTrieProof));
+    exports.Set("verifyTrieProofs", Napi::Function::New(env, VerifyTrieProofs));
+    exports.Set("spendNullifier", Napi::Function::New(env, SpendNullifier));
+    exports.Set("isNullifierSpent", Napi::Function::New(env, IsNullifierSpent));
+    exports.Set("getNullifierStats", Napi::Function::New(env, GetNullifierStats));
+    exports.Set("getNullifierRoot", Napi::Function::New(env, GetNullifierRoot));
+    exports.Set("getNullifierProof", Napi::Function::New(env, GetNullifierProof));
+    exports.Set("getNullifierProofs", Napi::Function::New(env, GetNullifierProofs));
+    exports.Set("verifyNullifierProof", Napi::Function::New(env, VerifyNullifierProof));
+    exports.Set("configureTally", Napi::Function::New(env, ConfigureTally));
+    exports.Set("castVotes", Napi::Function::New(env, CastVotes));
+    exports.Set("castVotesAsync", Napi::Function::New(env, CastVotesAsync));
+    exports.Set("getTallySnapshot", Napi::Function::New(env, GetTallySnapshot));
+    exports.Set("getTallyDelta", Napi::Function::New(env, GetTallyDelta));
+    exports.Set("processVoterIDShardedAsync", Napi::Function::New(env, ProcessVoterIDShardedAsync));
+    exports.Set("bulkLoadVotersSharded", Napi::Function::New(env, BulkLoadVotersSharded));
+    exports.Set("getShardedVoterProof", Napi::Function::New(env, GetShardedVoterProof));
+    exports.Set("verifyShardedVoterProof", Napi::Function::New(env, VerifyShardedVoterProof));
+    exports.Set("getShardedRegistryStats", Napi::Function::New(env, GetShardedRegistryStats));
+    exports.Set("getMetrics", Napi::Function::New(env, GetMetrics));
+    exports.Set("commitTrieVersion", Napi::Function::New(env, CommitTrieVersion));
+    exports.Set("getTrieVersions", Napi::Function::New(env, GetTrieVersions));
+    exports.Set("releaseTrieVersion", Napi::Function::New(env, ReleaseTrieVersion));
+    exports.Set("collectTrieGarbage", Napi::Function::New(env, CollectTrieGarbage));
+    exports.Set("saveTrieSnapshot", Napi::Function::New(env, SaveTrieSnapshot));
+    exports.Set("loadTrieSnapshot", Napi::Function::New(env, LoadTrieSnapshot));
+    exports.Set("openWriteAheadLog", Napi::Function::New(env, OpenWriteAheadLog));
     exports.Set("resetTrie", Napi::Function::New(env, ResetTrie));
     
     return exports;
 }
 
-NODE_API_MODULE(trie_hash_fusion, Init)
\ No newline at end of file
+NODE_API_MODULE(trie_hash_fusion, Init)
@@ -0,0 +1,233 @@
+#include "include/trie_snapshot.h"
+#include "include/metrics.h"
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+#include <type_traits>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+static_assert(std::is_trivially_copyable<TrieNode>::value, "TrieNode is written as raw bytes");
+static_assert(std::is_trivially_copyable<SnapshotHeader>::value, "SnapshotHeader is written as raw bytes");
+
+static const char SNAPSHOT_MAGIC[8] = { 'M', 'T', 'R', 'I', 'E', 'S', 'N', 'P' };
+static const uint64_t SECTION_ALIGNMENT = 64;
+
+static uint64_t alignSection(uint64_t offset) {
+    return (offset + SECTION_ALIGNMENT - 1) & ~(SECTION_ALIGNMENT - 1);
+}
+
+static std::runtime_error ioError(const std::string& what, const std::string& path) {
+    return std::runtime_error(what + " " + path + ": " + std::strerror(errno));
+}
+
+static void writeAll(int fd, const void* data, size_t length, const std::string& path) {
+    const char* bytes = static_cast<const char*>(data);
+    while (length > 0) {
+        ssize_t written = ::write(fd, bytes, length);
+        if (written < 0) {
+            if (errno == EINTR) continue;
+            throw ioError("Cannot write snapshot", path);
+        }
+        bytes += written;
+        length -= static_cast<size_t>(written);
+    }
+}
+
+// Zero padding up to the next section boundary
+static void writePadding(int fd, uint64_t& position, uint64_t target, const std::string& path) {
+    static const char zeros[SECTION_ALIGNMENT] = {};
+    writeAll(fd, zeros, target - position, path);
+    position = target;
+}
+
+void TrieSnapshot::write(const std::string& path, const TrieView& trie, const char* hashPolicy,
+                         const std::vector<Digest>& leaves) {
+    TRIE_METRIC_TIME(SNAPSHOT_WRITE);
+    SnapshotHeader header;
+    std::memset(&header, 0, sizeof(header));
+    std::memcpy(header.magic, SNAPSHOT_MAGIC, sizeof(header.magic));
+    header.version = VERSION;
+    header.byteOrder = BYTE_ORDER_MARK;
+    header.nodeSize = sizeof(TrieNode);
+    header.root = trie.root;
+    std::strncpy(header.hashPolicy, hashPolicy, sizeof(header.hashPolicy) - 1);
+    header.nodeCount = trie.nodeCount;
+    header.labelBytes = trie.labelBytes;
+    header.valueBytes = trie.valueBytes;
+    header.leafCount = leaves.size();
+    header.keyCount = trie.getSize();
+    header.nodesOffset = alignSection(sizeof(header));
+    header.labelsOffset = alignSection(header.nodesOffset + trie.nodeCount * sizeof(TrieNode));
+    header.valuesOffset = alignSection(header.labelsOffset + trie.labelBytes);
+    header.leavesOffset = alignSection(header.valuesOffset + trie.valueBytes);
+    header.rootHash = trie.getRootDigest();
+    
+    std::string temporary = path + ".tmp." + std::to_string(::getpid());
+    int fd = ::open(temporary.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (fd < 0) {
+        throw ioError("Cannot create snapshot", temporary);
+    }
+    
+    try {
+        uint64_t position = sizeof(header);
+        writeAll(fd, &header, sizeof(header), temporary);
+        
+        writePadding(fd, position, header.nodesOffset, temporary);
+        writeAll(fd, trie.nodes, trie.nodeCount * sizeof(TrieNode), temporary);
+        position += trie.nodeCount * sizeof(TrieNode);
+        
+        writePadding(fd, position, header.labelsOffset, temporary);
+        writeAll(fd, trie.labels, trie.labelBytes, temporary);
+        position += trie.labelBytes;
+        
+        writePadding(fd, position, header.valuesOffset, temporary);
+        writeAll(fd, trie.values, trie.valueBytes, temporary);
+        position += trie.valueBytes;
+        
+        writePadding(fd, position, header.leavesOffset, temporary);
+        writeAll(fd, leaves.data(), leaves.size() * sizeof(Digest), temporary);
+        
+        if (::fsync(fd) != 0) {
+            throw ioError("Cannot sync snapshot", temporary);
+        }
+    } catch (...) {
+        ::close(fd);
+        ::unlink(temporary.c_str());
+        throw;
+    }
+    
+    ::close(fd);
+    if (::rename(temporary.c_str(), path.c_str()) != 0) {
+        ::unlink(temporary.c_str());
+        throw ioError("Cannot replace snapshot", path);
+    }
+    
+    // Persist the rename itself
+    size_t slash = path.find_last_of('/');
+    std::string directory = slash == std::string::npos ? "." : path.substr(0, slash + 1);
+    int dirFd = ::open(directory.c_str(), O_RDONLY | O_CLOEXEC);
+    if (dirFd >= 0) {
+        ::fsync(dirFd);
+        ::close(dirFd);
+    }
+}
+
+TrieSnapshot::TrieSnapshot(const std::string& path)
+    : mapping(nullptr), mappedBytes(0), trieView(), leafData(nullptr), leafTotal(0) {
+    int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        throw ioError("Cannot open snapshot", path);
+    }
+    
+    struct stat info;
+    if (::fstat(fd, &info) != 0) {
+        ::close(fd);
+        throw ioError("Cannot stat snapshot", path);
+    }
+    if (static_cast<size_t>(info.st_size) < sizeof(SnapshotHeader)) {
+        ::close(fd);
+        throw std::runtime_error("Snapshot " + path + " is truncated");
+    }
+    
+    mappedBytes = static_cast<size_t>(info.st_size);
+    mapping = ::mmap(nullptr, mappedBytes, PROT_READ, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if (mapping == MAP_FAILED) {
+        mapping = nullptr;
+        throw ioError("Cannot map snapshot", path);
+    }
+    
+    const char* base = static_cast<const char*>(mapping);
+    const SnapshotHeader* header = reinterpret_cast<const SnapshotHeader*>(base);
+    trieView.nodes = reinterpret_cast<const TrieNode*>(base + header->nodesOffset);
+    trieView.nodeCount = header->nodeCount;
+    trieView.labels = base + header->labelsOffset;
+    trieView.labelBytes = header->labelBytes;
+    trieView.values = base + header->valuesOffset;
+    trieView.valueBytes = header->valueBytes;
+    trieView.root = header->root;
+    trieView.keyCount = header->keyCount;
+    leafData = reinterpret_cast<const Digest*>(base + header->leavesOffset);
+    leafTotal = header->leafCount;
+    
+    try {
+        validate(path);
+    } catch (...) {
+        ::munmap(mapping, mappedBytes);
+        throw;
+    }
+}
+
+TrieSnapshot::~TrieSnapshot() {
+    if (mapping) {
+        ::munmap(mapping, mappedBytes);
+    }
+}
+
+std::string TrieSnapshot::hashPolicy() const {
+    const SnapshotHeader* header = static_cast<const SnapshotHeader*>(mapping);
+    return std::string(header->hashPolicy, strnlen(header->hashPolicy, sizeof(header->hashPolicy)));
+}
+
+void TrieSnapshot::validate(const std::string& path) const {
+    const SnapshotHeader* header = static_cast<const SnapshotHeader*>(mapping);
+    auto fail = [&](const char* reason) {
+        return std::runtime_error("Snapshot " + path + " " + reason);
+    };
+    
+    if (std::memcmp(header->magic, SNAPSHOT_MAGIC, sizeof(header->magic)) != 0) {
+        throw fail("is not a trie snapshot");
+    }
+    if (header->version != VERSION) {
+        throw fail("has an unsupported version");
+    }
+    if (header->byteOrder != BYTE_ORDER_MARK || header->nodeSize != sizeof(TrieNode)) {
+        throw fail("was written with an incompatible node layout");
+    }
+    
+    // Sections must be aligned and lie inside the file, in order
+    auto fits = [&](uint64_t offset, uint64_t count, uint64_t size) {
+        return offset % SECTION_ALIGNMENT == 0 && offset <= mappedBytes &&
+               count <= (mappedBytes - offset) / size;
+    };
+    if (!fits(header->nodesOffset, header->nodeCount, sizeof(TrieNode)) ||
+        !fits(header->labelsOffset, header->labelBytes, 1) ||
+        !fits(header->valuesOffset, header->valueBytes, 1) ||
+        !fits(header->leavesOffset, header->leafCount, sizeof(Digest))) {
+        throw fail("is truncated");
+    }
+    if (header->nodeCount == 0 || header->nodeCount > TrieNode::NIL ||
+        header->root >= header->nodeCount) {
+        throw fail("has no valid root");
+    }
+    
+    // Every index and offset is bounds-checked once here, so lookups on
+    // the mapping never need to
+    for (uint64_t i = 0; i < header->nodeCount; i++) {
+        const TrieNode& node = trieView.nodes[i];
+        bool linksValid = (node.firstChild == TrieNode::NIL || node.firstChild < header->nodeCount) &&
+                          (node.nextSibling == TrieNode::NIL || node.nextSibling < header->nodeCount);
+        // Only the root may have an empty label, but the roots of retained
+        // versions are in the arena too, so check labels where nodes are
+        // linked as children, which is where lookups read them
+        bool labelValid = linksValid &&
+                          node.labelOffset <= header->labelBytes &&
+                          node.labelLength <= header->labelBytes - node.labelOffset &&
+                          (node.firstChild == TrieNode::NIL ||
+                           trieView.nodes[node.firstChild].labelLength > 0) &&
+                          (node.nextSibling == TrieNode::NIL ||
+                           trieView.nodes[node.nextSibling].labelLength > 0);
+        bool valueValid = node.valueOffset <= header->valueBytes &&
+                          node.valueLength <= header->valueBytes - node.valueOffset;
+        if (!linksValid || !labelValid || !valueValid || (node.flags & TrieNode::DIRTY)) {
+            throw fail("has a corrupt node");
+        }
+    }
+    
+    if (trieView.nodes[header->root].hash != header->rootHash) {
+        throw fail("root hash does not match its header");
+    }
+}
@@ -0,0 +1,189 @@
+#include "include/vote_tally.h"
+#include "include/metrics.h"
+#include "include/thread_pool.h"
+#include <algorithm>
+#include <cstring>
+
+// Fixed per thread, handed out round-robin
+static size_t threadSlot() {
+    static std::atomic<size_t> nextSlot(0);
+    thread_local size_t slot = nextSlot.fetch_add(1, std::memory_order_relaxed);
+    return slot;
+}
+
+VoteTally::VoteTally(size_t candidateCount) : candidates(0), lineCount(0), votesCounted(0), sequenceNumber(0) {
+    reset(candidateCount);
+}
+
+void VoteTally::reset(size_t candidateCount) {
+    candidates = std::min(candidateCount, MAX_CANDIDATES);
+    lineCount = (candidates + WORDS_PER_LINE - 1) / WORDS_PER_LINE;
+    // Value-initialized, so every counter starts at zero
+    lines.reset(new Line[STRIPES * lineCount]());
+    votesCounted.store(0, std::memory_order_relaxed);
+
+    uint64_t stamp = sequenceNumber.load(std::memory_order_relaxed) + 1;
+    changedAt.reset(new std::atomic<uint64_t>[candidates]);
+    for (size_t i = 0; i < candidates; i++) {
+        changedAt[i].store(stamp, std::memory_order_relaxed);
+    }
+    sequenceNumber.store(stamp, std::memory_order_release);
+}
+
+std::atomic<uint64_t>& VoteTally::counter(size_t stripe, uint32_t candidate) const {
+    return lines[stripe * lineCount + candidate / WORDS_PER_LINE].words[candidate % WORDS_PER_LINE];
+}
+
+uint64_t VoteTally::merged(uint32_t candidate) const {
+    uint64_t total = 0;
+    for (size_t stripe = 0; stripe < STRIPES; stripe++) {
+        total += counter(stripe, candidate).load(std::memory_order_relaxed);
+    }
+    return total;
+}
+
+void VoteTally::count(const uint32_t* votes, size_t voteCount) {
+    // Chunks tally locally, then add each nonzero total to their thread's
+    // stripe once
+    size_t chunks = (voteCount + COUNT_CHUNK_SIZE - 1) / COUNT_CHUNK_SIZE;
+    auto countChunk = [&](size_t chunk) {
+        size_t begin = chunk * COUNT_CHUNK_SIZE;
+        size_t end = std::min(begin + COUNT_CHUNK_SIZE, voteCount);
+        std::vector<uint64_t> local(candidates, 0);
+        for (size_t i = begin; i < end; i++) {
+            local[votes[i]]++;
+        }
+        size_t stripe = threadSlot() % STRIPES;
+        for (uint32_t candidate = 0; candidate < candidates; candidate++) {
+            if (local[candidate]) {
+                counter(stripe, candidate).fetch_add(local[candidate], std::memory_order_relaxed);
+            }
+        }
+    };
+
+    if (chunks <= 1) {
+        countChunk(0);
+    } else {
+        ThreadPool::shared().parallelFor(chunks, countChunk);
+    }
+}
+
+template <typename Spend>
+VoteTally::IngestResult VoteTally::ingestWith(const uint8_t* records, size_t recordCount,
+                                              uint8_t* status, Spend spend) {
+    TRIE_METRIC_TIME(TALLY_INGEST);
+    IngestResult result = {0, 0, 0, 0};
+
+    // Records naming a known candidate, as (record index, candidate), go
+    // to spend in one batch
+    std::vector<std::pair<size_t, uint32_t>> valid;
+    std::vector<Digest> nullifiers;
+    valid.reserve(recordCount);
+    nullifiers.reserve(recordCount);
+    for (size_t i = 0; i < recordCount; i++) {
+        const uint8_t* record = records + i * RECORD_BYTES;
+        uint32_t candidate = uint32_t(record[32]) | uint32_t(record[33]) << 8 |
+                             uint32_t(record[34]) << 16 | uint32_t(record[35]) << 24;
+
+        if (candidate >= candidates) {
+            result.invalid++;
+            if (status) {
+                status[i] = UNKNOWN_CANDIDATE;
+            }
+            continue;
+        }
+        valid.emplace_back(i, candidate);
+        nullifiers.emplace_back();
+        std::memcpy(nullifiers.back().data(), record, sizeof(Digest));
+    }
+
+    std::vector<uint8_t> fresh(valid.size());
+    spend(nullifiers.data(), nullifiers.size(), fresh.data());
+
+    // The accepted candidate indices are kept for counting
+    std::vector<uint32_t> votes;
+    votes.reserve(valid.size());
+    std::vector<uint8_t> touched(candidates, 0);
+    for (size_t v = 0; v < valid.size(); v++) {
+        VoteStatus outcome;
+        if (fresh[v]) {
+            outcome = ACCEPTED;
+            votes.push_back(valid[v].second);
+            touched[valid[v].second] = 1;
+        } else {
+            outcome = DUPLICATE;
+            result.duplicates++;
+        }
+        if (status) {
+            status[valid[v].first] = outcome;
+        }
+    }
+    result.accepted = votes.size();
+
+    if (votes.empty()) {
+        result.sequence = sequence();
+        return result;
+    }
+
+    count(votes.data(), votes.size());
+    votesCounted.fetch_add(votes.size(), std::memory_order_relaxed);
+
+    // Stamps go out before the sequence that names them, so a reader that
+    // sees sequence s also sees every candidate changed at or before s.
+    // Concurrent ingests stamp one at a time so the sequence never skips
+    // a stamp it has not published
+    std::lock_guard<std::mutex> lock(stampMutex);
+    uint64_t stamp = sequenceNumber.load(std::memory_order_relaxed) + 1;
+    for (uint32_t candidate = 0; candidate < candidates; candidate++) {
+        if (touched[candidate]) {
+            changedAt[candidate].store(stamp, std::memory_order_relaxed);
+        }
+    }
+    sequenceNumber.store(stamp, std::memory_order_release);
+    result.sequence = stamp;
+    return result;
+}
+
+VoteTally::IngestResult VoteTally::ingest(const uint8_t* records, size_t recordCount,
+                                          NullifierSet& spent, uint8_t* status) {
+    return ingestWith(records, recordCount, status,
+                      [&](const Digest* nullifiers, size_t count, uint8_t* fresh) {
+        for (size_t i = 0; i < count; i++) {
+            fresh[i] = spent.insert(nullifiers[i]);
+        }
+    });
+}
+
+VoteTally::IngestResult VoteTally::ingest(const uint8_t* records, size_t recordCount,
+                                          ShardedNullifierSet& spent, uint8_t* status) {
+    return ingestWith(records, recordCount, status,
+                      [&](const Digest* nullifiers, size_t count, uint8_t* fresh) {
+        spent.insertMany(nullifiers, count, fresh);
+    });
+}
+
+VoteTally::Totals VoteTally::collect(uint64_t since) const {
+    Totals totals;
+    totals.sequence = sequence();
+    totals.totalVotes = votesCounted.load(std::memory_order_relaxed);
+
+    // Counts may already include part of a newer ingest; its candidates
+    // carry the newer stamp and are returned again by the next delta.
+    // Only the returned candidates are merged across stripes
+    for (uint32_t candidate = 0; candidate < candidates; candidate++) {
+        if (changedAt[candidate].load(std::memory_order_relaxed) > since) {
+            totals.candidates.push_back(candidate);
+            totals.counts.push_back(merged(candidate));
+        }
+    }
+    return totals;
+}
+
+VoteTally::Totals VoteTally::snapshot() const {
+    // Every stamp is at least 1
+    return collect(0);
+}
+
+VoteTally::Totals VoteTally::delta(uint64_t since) const {
+    return collect(since);
+}
@@ -0,0 +1,321 @@
+#include "include/write_ahead_log.h"
+#include "include/metrics.h"
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+static const char WAL_MAGIC[8] = { 'M', 'T', 'R', 'I', 'E', 'W', 'A', 'L' };
+static const size_t HEADER_SIZE = 8 + 4 + 4 + 32;
+static const size_t RECORD_PREFIX = 4 + 4;
+static const size_t PAYLOAD_FIXED = 8 + 4 + 32;
+
+static std::runtime_error ioError(const std::string& what, const std::string& path) {
+    return std::runtime_error(what + " " + path + ": " + std::strerror(errno));
+}
+
+// CRC-32 (IEEE), table-driven
+static uint32_t crc32(const uint8_t* data, size_t length) {
+    static const struct Crc32Table {
+        uint32_t value[256];
+        Crc32Table() {
+            for (uint32_t i = 0; i < 256; i++) {
+                uint32_t c = i;
+                for (int k = 0; k < 8; k++) {
+                    c = (c & 1) ? 0xedb88320u ^ (c >> 1) : c >> 1;
+                }
+                value[i] = c;
+            }
+        }
+    } table;
+    
+    uint32_t crc = 0xffffffffu;
+    for (size_t i = 0; i < length; i++) {
+        crc = table.value[(crc ^ data[i]) & 0xff] ^ (crc >> 8);
+    }
+    return crc ^ 0xffffffffu;
+}
+
+static void putU32(std::string& out, uint32_t v) {
+    for (int i = 0; i < 4; i++) out += static_cast<char>(v >> (8 * i));
+}
+
+static void putU64(std::string& out, uint64_t v) {
+    for (int i = 0; i < 8; i++) out += static_cast<char>(v >> (8 * i));
+}
+
+static uint32_t getU32(const uint8_t* p) {
+    return uint32_t(p[0]) | (uint32_t(p[1]) << 8) | (uint32_t(p[2]) << 16) | (uint32_t(p[3]) << 24);
+}
+
+static uint64_t getU64(const uint8_t* p) {
+    return uint64_t(getU32(p)) | (uint64_t(getU32(p + 4)) << 32);
+}
+
+static void writeAll(int fd, const void* data, size_t length, const std::string& path) {
+    const char* bytes = static_cast<const char*>(data);
+    while (length > 0) {
+        ssize_t written = ::write(fd, bytes, length);
+        if (written < 0) {
+            if (errno == EINTR) continue;
+            throw ioError("Cannot write log", path);
+        }
+        bytes += written;
+        length -= static_cast<size_t>(written);
+    }
+}
+
+// Decode one record payload; false if it is malformed
+static bool parsePayload(const uint8_t* p, size_t length, uint64_t& sequence,
+                         WriteAheadLog::Entries& entries, Digest& root) {
+    if (length < PAYLOAD_FIXED) return false;
+    
+    sequence = getU64(p);
+    uint32_t count = getU32(p + 8);
+    std::memcpy(root.data(), p + 12, root.size());
+    size_t pos = PAYLOAD_FIXED;
+    
+    entries.clear();
+    for (uint32_t i = 0; i < count; i++) {
+        if (length - pos < 8) return false;
+        uint32_t keyLength = getU32(p + pos);
+        uint32_t valueLength = getU32(p + pos + 4);
+        pos += 8;
+        if (length - pos < uint64_t(keyLength) + valueLength) return false;
+        
+        entries.emplace_back(std::string(reinterpret_cast<const char*>(p + pos), keyLength),
+                             std::string(reinterpret_cast<const char*>(p + pos + keyLength), valueLength));
+        pos += keyLength + valueLength;
+    }
+    return pos == length;
+}
+
+WriteAheadLog::WriteAheadLog(const std::string& path, const Digest& baseRoot, const ReplayFn& replay)
+    : path(path), fd(-1), nextSequence(0), durableSequence(0), syncing(false), records(0), length(0) {
+    fd = ::open(path.c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+    if (fd < 0) {
+        throw ioError("Cannot open log", path);
+    }
+    
+    try {
+        struct stat info;
+        if (::fstat(fd, &info) != 0) {
+            throw ioError("Cannot stat log", path);
+        }
+        
+        std::vector<uint8_t> contents(static_cast<size_t>(info.st_size));
+        size_t readBytes = 0;
+        while (readBytes < contents.size()) {
+            ssize_t n = ::pread(fd, contents.data() + readBytes, contents.size() - readBytes, readBytes);
+            if (n < 0 && errno == EINTR) continue;
+            if (n <= 0) throw ioError("Cannot read log", path);
+            readBytes += static_cast<size_t>(n);
+        }
+        
+        bool hasHeader = contents.size() >= HEADER_SIZE &&
+                         std::memcmp(contents.data(), WAL_MAGIC, sizeof(WAL_MAGIC)) == 0;
+        if (!contents.empty() && !hasHeader) {
+            throw std::runtime_error("Log " + path + " is not a trie write-ahead log");
+        }
+        if (hasHeader && getU32(contents.data() + 8) != VERSION) {
+            throw std::runtime_error("Log " + path + " has an unsupported version");
+        }
+        
+        // Collect the intact prefix; anything after the first short or
+        // corrupt record is a write torn by a crash
+        struct Record { size_t offset; size_t length; };
+        std::vector<Record> intact;
+        size_t goodLength = hasHeader ? HEADER_SIZE : 0;
+        while (hasHeader && contents.size() - goodLength >= RECORD_PREFIX) {
+            uint32_t length = getU32(contents.data() + goodLength);
+            uint32_t checksum = getU32(contents.data() + goodLength + 4);
+            size_t payload = goodLength + RECORD_PREFIX;
+            if (contents.size() - payload < length ||
+                crc32(contents.data() + payload, length) != checksum) {
+                break;
+            }
+            intact.push_back(Record{payload, length});
+            goodLength = payload + length;
+        }
+        
+        Digest logBase;
+        if (hasHeader) {
+            std::memcpy(logBase.data(), contents.data() + 16, logBase.size());
+        }
+        
+        Entries entries;
+        Digest root;
+        uint64_t sequence = 0;
+        bool replayLog = hasHeader && logBase == baseRoot;
+        
+        if (hasHeader && !replayLog && !intact.empty()) {
+            const Record& last = intact.back();
+            if (!parsePayload(contents.data() + last.offset, last.length, sequence, entries, root) ||
+                root != baseRoot) {
+                throw std::runtime_error("Log " + path + " does not continue the current snapshot");
+            }
+        }
+        
+        if (replayLog) {
+            for (const auto& record : intact) {
+                if (!parsePayload(contents.data() + record.offset, record.length, sequence, entries, root)) {
+                    throw std::runtime_error("Log " + path + " has a malformed record");
+                }
+                replay(entries, root);
+                nextSequence = sequence + 1;
+                records++;
+            }
+            if (::ftruncate(fd, static_cast<off_t>(goodLength)) != 0) {
+                throw ioError("Cannot truncate log", path);
+            }
+            length = goodLength;
+        } else {
+            // New log, or one already folded into the snapshot
+            if (::ftruncate(fd, 0) != 0) {
+                throw ioError("Cannot truncate log", path);
+            }
+            writeHeader(baseRoot);
+        }
+        
+        if (::lseek(fd, 0, SEEK_END) < 0 || ::fsync(fd) != 0) {
+            throw ioError("Cannot sync log", path);
+        }
+        durableSequence = nextSequence;
+    } catch (...) {
+        ::close(fd);
+        throw;
+    }
+}
+
+WriteAheadLog::~WriteAheadLog() {
+    if (fd >= 0) {
+        ::fdatasync(fd);
+        ::close(fd);
+    }
+}
+
+void WriteAheadLog::writeHeader(const Digest& baseRoot) {
+    std::string header(WAL_MAGIC, sizeof(WAL_MAGIC));
+    putU32(header, VERSION);
+    putU32(header, 0);
+    header.append(reinterpret_cast<const char*>(baseRoot.data()), baseRoot.size());
+    
+    if (::lseek(fd, 0, SEEK_SET) < 0) {
+        throw ioError("Cannot seek log", path);
+    }
+    writeAll(fd, header.data(), header.size(), path);
+    length = header.size();
+}
+
+void WriteAheadLog::checkHealthy() const {
+    if (!failure.empty()) {
+        throw std::runtime_error("Log " + path + " has failed: " + failure);
+    }
+}
+
+uint64_t WriteAheadLog::append(const Entries& entries, const Digest& root) {
+    std::string payload;
+    std::unique_lock<std::mutex> lock(mutex);
+    checkHealthy();
+    uint64_t sequence = nextSequence;
+    
+    putU64(payload, sequence);
+    putU32(payload, static_cast<uint32_t>(entries.size()));
+    payload.append(reinterpret_cast<const char*>(root.data()), root.size());
+    for (const auto& entry : entries) {
+        putU32(payload, static_cast<uint32_t>(entry.first.size()));
+        putU32(payload, static_cast<uint32_t>(entry.second.size()));
+        payload += entry.first;
+        payload += entry.second;
+    }
+    
+    std::string record;
+    record.reserve(RECORD_PREFIX + payload.size());
+    putU32(record, static_cast<uint32_t>(payload.size()));
+    putU32(record, crc32(reinterpret_cast<const uint8_t*>(payload.data()), payload.size()));
+    record += payload;
+    
+    // One write per record, so a crash can only tear the last one
+    try {
+        writeAll(fd, record.data(), record.size(), path);
+    } catch (const std::exception& e) {
+        // Cut off whatever part of the record did reach the file
+        if (::ftruncate(fd, static_cast<off_t>(length)) != 0 ||
+            ::lseek(fd, static_cast<off_t>(length), SEEK_SET) < 0) {
+            failure = std::string(e.what()) + "; cannot truncate the partial record: " +
+                      std::strerror(errno);
+        }
+        throw;
+    }
+    length += record.size();
+    nextSequence++;
+    records++;
+    return sequence;
+}
+
+void WriteAheadLog::sync(uint64_t sequence) {
+    std::unique_lock<std::mutex> lock(mutex);
+    
+    while (durableSequence <= sequence) {
+        checkHealthy();
+        if (syncing) {
+            // Another caller's fsync is in flight; it or the next one covers us
+            synced.wait(lock);
+            continue;
+        }
+        
+        syncing = true;
+        uint64_t target = nextSequence;
+        lock.unlock();
+        int result;
+        int error;
+        {
+            TRIE_METRIC_TIME(WAL_SYNC);
+            result = ::fdatasync(fd);
+            error = errno;
+        }
+        lock.lock();
+        syncing = false;
+        
+        if (result != 0) {
+            // Retrying could report success for pages the kernel already
+            // dropped, so nothing is treated as durable from here on
+            failure = std::string("fdatasync: ") + std::strerror(error);
+            synced.notify_all();
+            checkHealthy();
+        }
+        durableSequence = std::max(durableSequence, target);
+        synced.notify_all();
+    }
+}
+
+void WriteAheadLog::reset(const Digest& baseRoot) {
+    std::unique_lock<std::mutex> lock(mutex);
+    while (syncing) {
+        synced.wait(lock);
+    }
+    
+    if (::ftruncate(fd, 0) != 0) {
+        throw ioError("Cannot truncate log", path);
+    }
+    writeHeader(baseRoot);
+    if (::fsync(fd) != 0) {
+        throw ioError("Cannot sync log", path);
+    }
+    records = 0;
+    durableSequence = nextSequence;
+    failure.clear();
+}
+
+size_t WriteAheadLog::recordCount() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return records;
+}
+
+bool WriteAheadLog::failed() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return !failure.empty();
+}